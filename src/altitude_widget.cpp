@@ -32,8 +32,6 @@
 
 
 #include "altitude_widget.h"
-#include <QChart>
-#include <QGraphicsLayout>
 #include <QLayout>
 
 /*!
@@ -43,36 +41,16 @@ AltitudeWidget::AltitudeWidget(QWidget *parent) : QWidget(parent)
 {
     // Default buffer size.
     m_bufferSize = 100;
+    m_altitudeBuffer.setCapacity(m_bufferSize);
 
-    m_altitudeBuffer.resize(m_bufferSize);
-    m_altitudeBuffer.clear();
-
-    m_series = new QtCharts::QLineSeries();
-    m_chartView = new QtCharts::QChartView(this);
+    m_plot = new PlotWidget(this);
+    m_plot->setTitle("Altitude vs Time");
+    m_plot->setAxisTitles("TOW [s]", "Altitude [m]");
+    m_plot->addSeries("Altitude", [this](const PlotWidget::Viewport &) { return m_altitudeBuffer.view(); });
 
     QVBoxLayout *layout = new QVBoxLayout(this);
     this->setLayout(layout);
-    layout->addWidget(m_chartView);
-
-    QtCharts::QChart *chart = m_chartView->chart();
-
-    chart->addSeries(m_series);
-    chart->setTitle("Altitude vs Time");
-    chart->legend()->hide();
-    chart->createDefaultAxes();
-    chart->axes(Qt::Horizontal).back()->setTitleText("TOW [s]");
-    chart->axes(Qt::Vertical).back()->setTitleText("Altitude [m]");
-    chart->layout()->setContentsMargins(0, 0, 0, 0);
-    chart->setContentsMargins(-18, -18, -14, -16);
-
-    m_chartView->setRenderHint(QPainter::Antialiasing);
-    m_chartView->setContentsMargins(0, 0, 0, 0);
-
-    min_x = std::numeric_limits<double>::max();
-    max_x = -std::numeric_limits<double>::max();
-
-    min_y = std::numeric_limits<double>::max();
-    max_y = -std::numeric_limits<double>::max();
+    layout->addWidget(m_plot);
 }
 
 /*!
@@ -80,43 +58,15 @@ AltitudeWidget::AltitudeWidget(QWidget *parent) : QWidget(parent)
  */
 void AltitudeWidget::addData(qreal tow, qreal altitude)
 {
-    m_altitudeBuffer.push_back(QPointF(tow, altitude));
+    m_altitudeBuffer.append(tow, altitude);
 }
 
 /*!
- Redraws the chart by replacing the old data in the series object with the new data.
+ Repaints the plot if data was added since the last redraw. The plot reads the buffer in place.
  */
 void AltitudeWidget::redraw()
 {
-    if (!m_altitudeBuffer.empty())
-    {
-        double min_x = std::numeric_limits<double>::max();
-        double max_x = -std::numeric_limits<double>::max();
-
-        double min_y = std::numeric_limits<double>::max();
-        double max_y = -std::numeric_limits<double>::max();
-
-        QtCharts::QChart *chart = m_chartView->chart();
-        QPointF p;
-        QVector<QPointF> vec;
-
-        for (size_t i = 0; i < m_altitudeBuffer.size(); i++)
-        {
-            p = m_altitudeBuffer.at(i);
-            vec << p;
-
-            min_x = std::min(min_x, p.x());
-            min_y = std::min(min_y, p.y());
-
-            max_x = std::max(max_x, p.x());
-            max_y = std::max(max_y, p.y());
-        }
-
-        m_series->replace(vec);
-
-        chart->axes(Qt::Horizontal).back()->setRange(min_x, max_x);
-        chart->axes(Qt::Vertical).back()->setRange(min_y, max_y);
-    }
+    m_plot->refresh();
 }
 
 /*!
@@ -125,7 +75,15 @@ void AltitudeWidget::redraw()
 void AltitudeWidget::clear()
 {
     m_altitudeBuffer.clear();
-    m_series->clear();
+    m_plot->refresh();
+}
+
+/*!
+ Returns the number of bytes allocated by the widget's internal data structures.
+ */
+size_t AltitudeWidget::memoryUsage() const
+{
+    return m_altitudeBuffer.memoryUsage();
 }
 
 /*!
@@ -133,6 +91,11 @@ void AltitudeWidget::clear()
  */
 void AltitudeWidget::setBufferSize(size_t size)
 {
+    if (size == m_bufferSize)
+    {
+        return;
+    }
     m_bufferSize = size;
-    m_altitudeBuffer.resize(m_bufferSize);
+    m_altitudeBuffer.setCapacity(m_bufferSize);
+    m_plot->refresh();
 }
@@ -34,9 +34,8 @@
 #ifndef GNSS_SDR_MONITOR_ALTITUDE_WIDGET_H_
 #define GNSS_SDR_MONITOR_ALTITUDE_WIDGET_H_
 
-#include <boost/circular_buffer.hpp>
-#include <QChartView>
-#include <QLineSeries>
+#include "plot_widget.h"
+#include "series_buffer.h"
 #include <QWidget>
 
 class AltitudeWidget : public QWidget
@@ -46,6 +45,8 @@ class AltitudeWidget : public QWidget
 public:
     explicit AltitudeWidget(QWidget *parent = nullptr);
 
+    size_t memoryUsage() const;
+
 public slots:
     void addData(qreal tow, qreal altitude);
     void redraw();
@@ -54,15 +55,8 @@ public slots:
 
 private:
     size_t m_bufferSize;
-    boost::circular_buffer<QPointF> m_altitudeBuffer;
-    QtCharts::QChartView *m_chartView = nullptr;
-    QtCharts::QLineSeries *m_series = nullptr;
-
-    double min_x;
-    double min_y;
-
-    double max_x;
-    double max_y;
+    SeriesBuffer m_altitudeBuffer;
+    PlotWidget *m_plot = nullptr;
 };
 
 #endif  // GNSS_SDR_MONITOR_ALTITUDE_WIDGET_H_
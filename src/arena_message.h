@@ -0,0 +1,100 @@
+/*!
+ * \file arena_message.h
+ * \brief Interface and implementation of a protobuf message decoded into
+ * a reusable arena.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#ifndef GNSS_SDR_MONITOR_ARENA_MESSAGE_H_
+#define GNSS_SDR_MONITOR_ARENA_MESSAGE_H_
+
+#include <google/protobuf/arena.h>
+#include <cstddef>
+#include <vector>
+
+/*!
+ Owns a google::protobuf::Arena backed by a preallocated initial block and
+ the message most recently decoded into it.
+
+ Every call to parse() resets the arena and decodes the datagram in place
+ with ParseFromArray(), so once the initial block is large enough for a
+ typical datagram no heap allocation happens per message.
+ */
+template <typename Message, size_t InitialBlockSize>
+class ArenaMessage
+{
+public:
+    ArenaMessage() : m_block(InitialBlockSize),
+                     m_arena(arenaOptions(m_block.data(), m_block.size())),
+                     m_message(nullptr)
+    {
+    }
+
+    ArenaMessage(const ArenaMessage &) = delete;
+    ArenaMessage &operator=(const ArenaMessage &) = delete;
+
+    /*!
+     Decodes \a size bytes of \a data. Returns the decoded message, or nullptr if the data is malformed.
+     */
+    const Message *parse(const char *data, int size)
+    {
+        m_message = nullptr;
+        m_arena.Reset();
+
+        Message *message = google::protobuf::Arena::CreateMessage<Message>(&m_arena);
+        if (!message->ParseFromArray(data, size))
+        {
+            return nullptr;
+        }
+
+        m_message = message;
+        return m_message;
+    }
+
+    /*!
+     Returns the last successfully decoded message, or nullptr.
+     */
+    const Message *message() const
+    {
+        return m_message;
+    }
+
+private:
+    static google::protobuf::ArenaOptions arenaOptions(char *block, size_t size)
+    {
+        google::protobuf::ArenaOptions options;
+        options.initial_block = block;
+        options.initial_block_size = size;
+        return options;
+    }
+
+    std::vector<char> m_block;
+    google::protobuf::Arena m_arena;
+    Message *m_message;
+};
+
+#endif  // GNSS_SDR_MONITOR_ARENA_MESSAGE_H_
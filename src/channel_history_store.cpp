@@ -0,0 +1,963 @@
+/*!
+ * \file channel_history_store.cpp
+ * \brief Implementation of a dense, struct-of-arrays store for the sample
+ * history of the tracking channels.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "channel_history_store.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+// Samples a ring is first allocated for. It then doubles as needed.
+#define HISTORY_INITIAL_CAPACITY 64
+
+// Capacity, in samples or tier buckets, below which the memory budget does not shrink the history.
+#define HISTORY_MIN_CAPACITY 100
+
+// GNSS-SDR numbers its channels from zero, this bounds the id to slot lookup table.
+#define MAX_CHANNEL_ID 4096
+
+// Downsampled tiers kept behind the rings. Each bucket summarizes 16 of the
+// tier below, so at 50 samples per second the three tiers of 2048 buckets
+// reach back about 11 minutes, 3 hours and 46 hours.
+#define HISTORY_TIER_COUNT 3
+#define HISTORY_TIER_FACTOR 16
+#define HISTORY_TIER_CAPACITY 2048
+
+// Points per pixel column above which a plot reads from a coarser tier.
+#define HISTORY_POINTS_PER_PIXEL 2
+
+namespace
+{
+/*!
+ Returns the time, in seconds, of a clock that is not affected by the
+ receiver time, its week rollovers or changes of the system clock.
+ */
+double monotonicTime()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*!
+ Copies the newest \a count samples of \a ring to \a samples and pushes them to \a extrema.
+ */
+void copyTail(const RingView &ring, size_t count, std::vector<double> *samples, SlidingExtrema<double> *extrema)
+{
+    size_t first = ring.size() - count;
+    samples->reserve(count);
+    if (first < ring.firstSize())
+    {
+        samples->insert(samples->end(), ring.firstData() + first, ring.firstData() + ring.firstSize());
+        samples->insert(samples->end(), ring.secondData(), ring.secondData() + ring.secondSize());
+    }
+    else
+    {
+        const double *begin = ring.secondData() + (first - ring.firstSize());
+        samples->insert(samples->end(), begin, ring.secondData() + ring.secondSize());
+    }
+
+    extrema->setWindow(count);
+    for (double value : *samples)
+    {
+        extrema->push(value);
+    }
+}
+
+/*!
+ Returns the index of the first sample of the sorted \a ring that is not less than \a value.
+ */
+size_t lowerBound(const RingView &ring, double value)
+{
+    size_t first = 0;
+    size_t last = ring.size();
+    while (first < last)
+    {
+        size_t middle = first + (last - first) / 2;
+        if (ring[middle] < value)
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+    return first;
+}
+}  // namespace
+
+/*!
+ Copies the newest \a count samples of \a series, or all of them if it holds fewer.
+ */
+SeriesSnapshot::SeriesSnapshot(const SeriesView &series, size_t count)
+    : m_slot(series.slot), m_generation(series.generation), m_sequence(series.sequence)
+{
+    count = std::min(count, series.size());
+    copyTail(series.x, count, &m_x, &m_xExtrema);
+    copyTail(series.y, count, &m_y, &m_yExtrema);
+}
+
+/*!
+ Returns a view of the copied samples, valid for the lifetime of the snapshot.
+ */
+SeriesView SeriesSnapshot::view() const
+{
+    SeriesView series;
+    series.x = RingView(m_x.data(), m_x.size(), nullptr, 0, &m_xExtrema);
+    series.y = RingView(m_y.data(), m_y.size(), nullptr, 0, &m_yExtrema);
+    series.slot = m_slot;
+    series.generation = m_generation;
+    series.sequence = m_sequence;
+    return series;
+}
+
+/*!
+ Constructs a store whose rings hold \a capacity samples each.
+ */
+ChannelHistoryStore::ChannelHistoryStore(size_t capacity) : m_tierCapacity(HISTORY_TIER_CAPACITY), m_memoryBudget(0), m_memoryUsage(0), m_extremaGrew(false), m_satelliteTimeout(0), m_generation(0)
+{
+    std::fill(m_capacity, m_capacity + FieldCount, 0);
+    setCapacity(capacity);
+}
+
+/*!
+ Sets the number of samples kept per channel for every field. The newest
+ samples that fit are kept.
+ */
+void ChannelHistoryStore::setCapacity(size_t capacity)
+{
+    std::fill(m_retention, m_retention + FieldCount, capacity);
+    applyCapacities();
+}
+
+/*!
+ Sets the number of \a field samples kept per channel. The prompt I and Q are
+ paired, so setting one sets both, and the time is kept for as long as the
+ longest of the other fields. The newest samples that fit are kept.
+ */
+void ChannelHistoryStore::setCapacity(Field field, size_t capacity)
+{
+    if (field == Time)
+    {
+        return;
+    }
+
+    m_retention[field] = capacity;
+    if (field == PromptI || field == PromptQ)
+    {
+        m_retention[PromptI] = capacity;
+        m_retention[PromptQ] = capacity;
+    }
+    m_retention[Time] = std::max({m_retention[PromptI], m_retention[Cn0], m_retention[Doppler]});
+
+    applyCapacities();
+}
+
+/*!
+ Returns the number of \a field samples kept per channel, which is lower than
+ its retention() if the memory budget required it.
+ */
+size_t ChannelHistoryStore::capacity(Field field) const
+{
+    return m_capacity[field];
+}
+
+/*!
+ Returns the number of \a field samples per channel set with setCapacity().
+ */
+size_t ChannelHistoryStore::retention(Field field) const
+{
+    return m_retention[field];
+}
+
+/*!
+ Sets the number of bytes the history of all channels may take, or 0 for no
+ limit. The capacities lowered to fit a previous budget are restored, and
+ lowered again, starting from the least valuable field, if the history held
+ does not fit in the new one.
+ */
+void ChannelHistoryStore::setMemoryBudget(size_t bytes)
+{
+    if (bytes == m_memoryBudget)
+    {
+        return;
+    }
+
+    m_memoryBudget = bytes;
+    applyCapacities();
+}
+
+size_t ChannelHistoryStore::memoryBudget() const
+{
+    return m_memoryBudget;
+}
+
+/*!
+ Returns the number of bytes allocated by the rings of all slots, by their
+ extrema and by the downsampled tiers. It is kept up to date as they grow and
+ shrink.
+ */
+size_t ChannelHistoryStore::memoryUsage() const
+{
+    return m_memoryUsage;
+}
+
+/*!
+ Returns the part of memoryUsage() taken by the downsampled tiers of all slots.
+ */
+size_t ChannelHistoryStore::tierMemoryUsage() const
+{
+    size_t bytes = 0;
+    for (const Slot &slot : m_slots)
+    {
+        bytes += slot.tiers.memoryUsage();
+    }
+    return bytes;
+}
+
+/*!
+ Returns the number of buckets kept per tier, which is lower than
+ tierRetention() if the memory budget required it.
+ */
+size_t ChannelHistoryStore::tierCapacity() const
+{
+    return m_tierCapacity;
+}
+
+size_t ChannelHistoryStore::tierRetention() const
+{
+    return HISTORY_TIER_CAPACITY;
+}
+
+/*!
+ Returns the slot of the satellite tracked by \a channelId, or -1 if the
+ channel is not bound to any.
+ */
+int ChannelHistoryStore::slotOf(int channelId) const
+{
+    if (channelId < 0 || static_cast<size_t>(channelId) >= m_slotOfChannel.size())
+    {
+        return -1;
+    }
+    return m_slotOfChannel[channelId];
+}
+
+/*!
+ Returns the slot of \a satellite, or -1 if the satellite has no history.
+ */
+int ChannelHistoryStore::slotOfSatellite(uint64_t satellite) const
+{
+    auto it = m_slotOfSatellite.find(satellite);
+    return it == m_slotOfSatellite.end() ? -1 : it->second;
+}
+
+/*!
+ Returns the slot of \a satellite, assigning an empty one if the satellite
+ has no history yet.
+ */
+int ChannelHistoryStore::acquire(uint64_t satellite)
+{
+    int slot = slotOfSatellite(satellite);
+    if (slot >= 0)
+    {
+        return slot;
+    }
+
+    if (!m_freeSlots.empty())
+    {
+        // Recycle a slot released by another satellite.
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        slot = static_cast<int>(m_slots.size());
+        m_slots.emplace_back();
+        m_slots.back().tiers = HistoryTiers(2, HISTORY_TIER_COUNT, HISTORY_TIER_FACTOR, m_tierCapacity);
+        m_memoryUsage += m_slots.back().tiers.memoryUsage();
+    }
+
+    Slot &s = m_slots[slot];
+    s.used = true;
+    s.satellite = satellite;
+    s.channels = 0;
+    s.unboundTime = monotonicTime();
+    s.generation = ++m_generation;
+    // Numbering starts above any number handed out before, so the samples of
+    // a recycled slot can't be mistaken for those of its previous owner.
+    s.sequence = s.generation;
+    for (int field = 0; field < FieldCount; field++)
+    {
+        freeRing(&s.rings[field]);
+        s.rings[field].extrema.setWindow(m_capacity[field]);
+    }
+    freeTiers(&s.tiers);
+    s.tiers.setCapacity(m_tierCapacity);
+
+    m_slotOfSatellite[satellite] = slot;
+    // A new slot takes the few bytes of its open tier buckets.
+    if (m_memoryBudget > 0 && m_memoryUsage > m_memoryBudget)
+    {
+        enforceBudget();
+    }
+    return slot;
+}
+
+/*!
+ Binds \a channelId to the satellite of \a slot, unbinding it from the one
+ it tracked before. Returns false if the channel id is out of range.
+ */
+bool ChannelHistoryStore::bind(int channelId, int slot)
+{
+    if (channelId < 0 || channelId >= MAX_CHANNEL_ID)
+    {
+        return false;
+    }
+
+    if (static_cast<size_t>(channelId) >= m_slotOfChannel.size())
+    {
+        m_slotOfChannel.resize(channelId + 1, -1);
+    }
+
+    unbind(channelId);
+    m_slotOfChannel[channelId] = slot;
+    m_slots[slot].channels++;
+    return true;
+}
+
+/*!
+ Unbinds \a channelId from the satellite it tracks. The history of the
+ satellite is kept until it expires, see evictExpired().
+ */
+void ChannelHistoryStore::unbind(int channelId)
+{
+    int slot = slotOf(channelId);
+    if (slot < 0)
+    {
+        return;
+    }
+
+    Slot &s = m_slots[slot];
+    s.channels--;
+    // The satellite is gone from now on, not from its last sample.
+    s.unboundTime = monotonicTime();
+    m_slotOfChannel[channelId] = -1;
+}
+
+/*!
+ Drops the history of the satellite of \a slot, unbinding the channels that
+ track it. The slot is kept for reuse by another satellite.
+ */
+void ChannelHistoryStore::release(int slot)
+{
+    Slot &s = m_slots[slot];
+    if (!s.used)
+    {
+        return;
+    }
+
+    if (s.channels > 0)
+    {
+        std::replace(m_slotOfChannel.begin(), m_slotOfChannel.end(), slot, -1);
+    }
+    m_slotOfSatellite.erase(s.satellite);
+
+    s.used = false;
+    s.channels = 0;
+    for (Ring &ring : s.rings)
+    {
+        freeRing(&ring);
+    }
+    freeTiers(&s.tiers);
+    m_freeSlots.push_back(slot);
+}
+
+/*!
+ Sets how long, in seconds, the history of a satellite that no channel
+ tracks is kept. A value of 0 keeps it until the store is cleared.
+ */
+void ChannelHistoryStore::setSatelliteTimeout(double seconds)
+{
+    m_satelliteTimeout = seconds;
+}
+
+double ChannelHistoryStore::satelliteTimeout() const
+{
+    return m_satelliteTimeout;
+}
+
+/*!
+ Releases the slots of the satellites that no channel has tracked for longer
+ than the satellite timeout, and appends their indices to \a slots. It is
+ cheap enough to be called whenever a new satellite needs a slot, so expired
+ history is only dropped when its memory can be reused. If the memory budget
+ had lowered any capacity, the requested ones are put back in force.
+ */
+void ChannelHistoryStore::evictExpired(std::vector<int> *slots)
+{
+    if (m_satelliteTimeout <= 0)
+    {
+        return;
+    }
+
+    // Measured on a monotonic clock, as the receiver time of week wraps around.
+    double now = monotonicTime();
+    size_t first = slots->size();
+    for (int i = 0; i < static_cast<int>(m_slots.size()); i++)
+    {
+        const Slot &s = m_slots[i];
+        if (s.used && s.channels == 0 && now - s.unboundTime > m_satelliteTimeout)
+        {
+            release(i);
+            slots->push_back(i);
+        }
+    }
+
+    // The memory released may let the fields lowered by the budget grow back.
+    if (slots->size() > first &&
+        (!std::equal(m_capacity, m_capacity + FieldCount, m_retention) || m_tierCapacity != HISTORY_TIER_CAPACITY))
+    {
+        applyCapacities();
+    }
+}
+
+/*!
+ Drops the history of all satellites.
+ */
+void ChannelHistoryStore::clear()
+{
+    m_freeSlots.clear();
+    for (int i = static_cast<int>(m_slots.size()) - 1; i >= 0; i--)
+    {
+        m_slots[i].used = false;
+        m_slots[i].channels = 0;
+        for (Ring &ring : m_slots[i].rings)
+        {
+            freeRing(&ring);
+        }
+        freeTiers(&m_slots[i].tiers);
+        m_freeSlots.push_back(i);
+    }
+    m_slotOfChannel.clear();
+    m_slotOfSatellite.clear();
+}
+
+/*!
+ Returns the number of slots, used or not. Valid slot indices are 0 to slotCount() - 1.
+ */
+int ChannelHistoryStore::slotCount() const
+{
+    return static_cast<int>(m_slots.size());
+}
+
+/*!
+ Returns the key of the satellite that owns \a slot, see satelliteKey().
+ */
+uint64_t ChannelHistoryStore::satellite(int slot) const
+{
+    return m_slots[slot].satellite;
+}
+
+bool ChannelHistoryStore::isUsed(int slot) const
+{
+    return m_slots[slot].used;
+}
+
+/*!
+ Returns whether any channel is tracking the satellite of \a slot.
+ */
+bool ChannelHistoryStore::isTracked(int slot) const
+{
+    return m_slots[slot].channels > 0;
+}
+
+/*!
+ Appends one sample of every field to the rings of \a slot, overwriting the
+ oldest sample of the rings that are full.
+ */
+void ChannelHistoryStore::append(int slot, double time, double promptI, double promptQ, double cn0, double doppler)
+{
+    Slot &s = m_slots[slot];
+
+    bool grew = push(&s.rings[Time], time, m_capacity[Time]);
+    grew |= push(&s.rings[PromptI], promptI, m_capacity[PromptI]);
+    grew |= push(&s.rings[PromptQ], promptQ, m_capacity[PromptQ]);
+    grew |= push(&s.rings[Cn0], cn0, m_capacity[Cn0]);
+    grew |= push(&s.rings[Doppler], doppler, m_capacity[Doppler]);
+
+    double tierValues[] = {cn0, doppler};
+    size_t tierUsage = s.tiers.memoryUsage();
+    grew |= s.tiers.append(time, tierValues);
+    m_memoryUsage += s.tiers.memoryUsage() - tierUsage;
+
+    s.generation = ++m_generation;
+    s.sequence++;
+
+    // The extrema of the rings viewed since the last append may have grown too.
+    grew |= m_extremaGrew;
+    m_extremaGrew = false;
+
+    if (grew && m_memoryBudget > 0 && m_memoryUsage > m_memoryBudget)
+    {
+        enforceBudget();
+    }
+}
+
+/*!
+ Returns the number of time samples stored in \a slot. The other fields may
+ hold fewer, see capacity().
+ */
+size_t ChannelHistoryStore::size(int slot) const
+{
+    return m_slots[slot].rings[Time].size;
+}
+
+/*!
+ Returns a number that changes every time the samples of \a slot change. It
+ is unique across all slots, so a recycled slot never repeats a generation.
+ */
+uint64_t ChannelHistoryStore::generation(int slot) const
+{
+    return m_slots[slot].generation;
+}
+
+/*!
+ Returns the sequence number of the newest sample of \a slot. It grows by one
+ per appended sample, and is larger than any sequence number the slot, or the
+ channel, had before it was last acquired.
+ */
+uint64_t ChannelHistoryStore::sequence(int slot) const
+{
+    return m_slots[slot].sequence;
+}
+
+/*!
+ Returns a view of the \a field samples of \a slot, oldest first. The
+ extrema of the ring are brought up to date first, so although it is const it
+ must be called from the thread that appends.
+ */
+RingView ChannelHistoryStore::view(int slot, Field field) const
+{
+    return samples(m_slots[slot].rings[field]);
+}
+
+/*!
+ Returns the number of tiers of the history, counting the full resolution rings as tier 0.
+ */
+int ChannelHistoryStore::tierCount() const
+{
+    return 1 + HISTORY_TIER_COUNT;
+}
+
+/*!
+ Returns the finest tier of \a slot that reaches back to \a minX and has at
+ most a couple of points per pixel column when the time span from \a minX to
+ \a maxX is plotted \a width pixels wide. If no tier does, the coarsest one
+ that holds any data is returned. Pass an infinite range to plot the whole history.
+ */
+int ChannelHistoryStore::selectTier(int slot, double minX, double maxX, int width) const
+{
+    const Slot &s = m_slots[slot];
+    size_t budget = HISTORY_POINTS_PER_PIXEL * static_cast<size_t>(std::max(width, 1));
+
+    int coarsest = 0;
+    for (int tier = 0; tier < tierCount(); tier++)
+    {
+        RingView time = view(slot, Time, tier);
+        if (time.empty())
+        {
+            // The coarser tiers are empty too.
+            break;
+        }
+        coarsest = tier;
+
+        bool complete = tier == 0 ? s.rings[Time].size < m_capacity[Time] : s.tiers.isComplete(tier - 1);
+        if (!complete && time.front() > minX)
+        {
+            continue;
+        }
+
+        size_t points = lowerBound(time, maxX) - lowerBound(time, minX);
+        if (points <= budget)
+        {
+            return tier;
+        }
+    }
+    return coarsest;
+}
+
+/*!
+ Returns a view of the \a statistic of the \a field samples of \a slot in \a
+ tier, oldest first. Tier 0 is the full resolution ring, and the statistic is
+ ignored for it. The coarser tiers only hold the time, C/N0 and Doppler, and
+ the view is empty for the other fields.
+ */
+RingView ChannelHistoryStore::view(int slot, Field field, int tier, HistoryTiers::Statistic statistic) const
+{
+    if (tier == 0)
+    {
+        return view(slot, field);
+    }
+
+    const HistoryTiers &tiers = m_slots[slot].tiers;
+    switch (field)
+    {
+    case Time:
+        return tiers.time(tier - 1);
+
+    case Cn0:
+        return tiers.view(tier - 1, 0, statistic);
+
+    case Doppler:
+        return tiers.view(tier - 1, 1, statistic);
+
+    default:
+        return RingView();
+    }
+}
+
+/*!
+ Appends \a value to \a ring, whose field keeps \a capacity samples. Returns
+ true if the ring had to grow its storage. The extrema are left to the next
+ view of the ring.
+ */
+bool ChannelHistoryStore::push(Ring *ring, double value, size_t capacity)
+{
+    if (capacity == 0)
+    {
+        return false;
+    }
+
+    bool grew = false;
+    if (ring->size < capacity)
+    {
+        // The ring has not wrapped around yet, so its samples start at index 0.
+        if (ring->size == ring->samples.size())
+        {
+            size_t allocated = ring->samples.capacity();
+            size_t size = std::min(std::max<size_t>(2 * ring->size, HISTORY_INITIAL_CAPACITY), capacity);
+            ring->samples.reserve(size);
+            ring->samples.resize(size);
+            m_memoryUsage += (ring->samples.capacity() - allocated) * sizeof(double);
+            grew = true;
+        }
+        ring->samples[ring->size++] = value;
+    }
+    else
+    {
+        ring->samples[ring->head] = value;
+        if (++ring->head == capacity)
+        {
+            ring->head = 0;
+        }
+    }
+
+    // Past the capacity the extrema are rebuilt from the ring anyway.
+    if (ring->pending < capacity)
+    {
+        ring->pending++;
+    }
+    return grew;
+}
+
+/*!
+ Sets the capacity of \a ring, keeping its newest samples. The ring is
+ unwrapped in place, so that it can grow again, and its storage is only
+ reallocated if it is larger than the new capacity, to release the rest.
+ */
+void ChannelHistoryStore::resize(Ring *ring, size_t capacity)
+{
+    // The extrema keep the newest samples that fit, so they must have seen them.
+    updateExtrema(*ring);
+    m_memoryUsage -= ringMemory(*ring);
+
+    if (ring->head != 0)
+    {
+        // A wrapped ring fills its storage, so rotating it puts the oldest sample first.
+        std::rotate(ring->samples.begin(), ring->samples.begin() + ring->head, ring->samples.end());
+        ring->head = 0;
+    }
+
+    if (ring->samples.size() > capacity)
+    {
+        size_t kept = std::min(ring->size, capacity);
+        auto last = ring->samples.begin() + ring->size;
+        decltype(ring->samples)(last - kept, last).swap(ring->samples);
+        ring->size = kept;
+    }
+
+    ring->extrema.resize(capacity);
+
+    m_memoryUsage += ringMemory(*ring);
+}
+
+/*!
+ Returns a view of the samples of \a ring, oldest first.
+ */
+RingView ChannelHistoryStore::samples(const Ring &ring) const
+{
+    updateExtrema(ring);
+
+    const double *data = ring.samples.data();
+
+    size_t firstSize = std::min(ring.size, ring.samples.size() - ring.head);
+    return RingView(data + ring.head, firstSize, data, ring.size - firstSize, &ring.extrema);
+}
+
+/*!
+ Pushes the samples appended to \a ring since it was last viewed to its
+ extrema. If they fill the window, the extrema are rebuilt from them alone.
+ */
+void ChannelHistoryStore::updateExtrema(const Ring &ring) const
+{
+    if (ring.pending == 0)
+    {
+        return;
+    }
+
+    size_t usage = ring.extrema.memoryUsage();
+    if (ring.pending >= ring.extrema.window())
+    {
+        ring.extrema.clear();
+    }
+
+    const double *data = ring.samples.data();
+    size_t allocated = ring.samples.size();
+    for (size_t i = ring.size - std::min(ring.pending, ring.size); i < ring.size; i++)
+    {
+        size_t index = ring.head + i;
+        ring.extrema.push(data[index < allocated ? index : index - allocated]);
+    }
+    ring.pending = 0;
+
+    // The deques never shrink when pushed to.
+    size_t grown = ring.extrema.memoryUsage() - usage;
+    m_memoryUsage += grown;
+    m_extremaGrew = m_extremaGrew || grown > 0;
+}
+
+/*!
+ Empties \a ring and releases its memory.
+ */
+void ChannelHistoryStore::freeRing(Ring *ring)
+{
+    m_memoryUsage -= ringMemory(*ring);
+
+    decltype(ring->samples)().swap(ring->samples);
+    ring->head = 0;
+    ring->size = 0;
+    ring->pending = 0;
+    ring->extrema.setWindow(ring->extrema.window());
+}
+
+/*!
+ Empties \a tiers and releases the storage of their rings.
+ */
+void ChannelHistoryStore::freeTiers(HistoryTiers *tiers)
+{
+    m_memoryUsage -= tiers->memoryUsage();
+    tiers->clear();
+    m_memoryUsage += tiers->memoryUsage();
+}
+
+/*!
+ Returns the number of bytes allocated by \a ring and its extrema.
+ */
+size_t ChannelHistoryStore::ringMemory(const Ring &ring)
+{
+    return ring.samples.capacity() * sizeof(double) + ring.extrema.memoryUsage();
+}
+
+/*!
+ Lowers the capacity of \a field, and of the time if it was longer than all
+ the other fields, dropping the oldest samples of the rings that held more.
+ */
+void ChannelHistoryStore::limit(Field field, size_t capacity)
+{
+    std::vector<Field> fields(1, field);
+    if (field == PromptI || field == PromptQ)
+    {
+        fields = {PromptI, PromptQ};
+    }
+
+    for (Field f : fields)
+    {
+        m_capacity[f] = capacity;
+    }
+    size_t timeCapacity = std::max({m_capacity[PromptI], m_capacity[Cn0], m_capacity[Doppler]});
+    if (timeCapacity < m_capacity[Time])
+    {
+        m_capacity[Time] = timeCapacity;
+        fields.push_back(Time);
+    }
+
+    for (Slot &slot : m_slots)
+    {
+        if (!slot.used)
+        {
+            continue;
+        }
+        for (Field f : fields)
+        {
+            resize(&slot.rings[f], m_capacity[f]);
+        }
+        slot.generation = ++m_generation;
+    }
+}
+
+/*!
+ Sets the number of buckets kept by every tier, dropping the oldest buckets
+ of the tiers that held more.
+ */
+void ChannelHistoryStore::limitTiers(size_t capacity)
+{
+    m_tierCapacity = capacity;
+    for (Slot &slot : m_slots)
+    {
+        if (!slot.used)
+        {
+            continue;
+        }
+        m_memoryUsage -= slot.tiers.memoryUsage();
+        slot.tiers.setCapacity(capacity);
+        m_memoryUsage += slot.tiers.memoryUsage();
+        slot.generation = ++m_generation;
+    }
+}
+
+/*!
+ Puts the capacities requested with setCapacity() in force, resizing the
+ rings of the fields whose capacity changes, and then lowers them again if
+ the memory budget requires it. The rings of the other fields are untouched.
+ */
+void ChannelHistoryStore::applyCapacities()
+{
+    bool changed = false;
+    for (int field = 0; field < FieldCount; field++)
+    {
+        if (m_capacity[field] == m_retention[field])
+        {
+            continue;
+        }
+
+        m_capacity[field] = m_retention[field];
+        for (Slot &slot : m_slots)
+        {
+            if (slot.used)
+            {
+                resize(&slot.rings[field], m_capacity[field]);
+            }
+        }
+        changed = true;
+    }
+
+    if (m_tierCapacity != HISTORY_TIER_CAPACITY)
+    {
+        limitTiers(HISTORY_TIER_CAPACITY);
+    }
+
+    if (changed)
+    {
+        for (Slot &slot : m_slots)
+        {
+            if (slot.used)
+            {
+                slot.generation = ++m_generation;
+            }
+        }
+    }
+
+    enforceBudget();
+}
+
+/*!
+ Lowers the capacity of the least valuable history until it fits in the
+ memory budget. Each step cuts the longest ring of the field, or the largest
+ tier, by the number of samples or buckets per ring that covers the excess,
+ so that only the oldest ones are dropped, and only as many as needed. Rings
+ shorter than the new capacity release nothing, so a few steps may be
+ needed. No capacity goes below a minimum.
+ */
+void ChannelHistoryStore::enforceBudget()
+{
+    // FieldCount stands for the downsampled tiers, which go before the C/N0.
+    static const int evictionOrder[] = {PromptI, Doppler, FieldCount, Cn0};
+
+    for (int field : evictionOrder)
+    {
+        bool tiers = field == FieldCount;
+        while (m_memoryBudget > 0 && m_memoryUsage > m_memoryBudget)
+        {
+            // The prompt I and Q are lowered together, so they free two rings
+            // per slot, and a bucket of every tier holds the time and three
+            // statistics of the C/N0 and the Doppler.
+            size_t rings = 0;
+            size_t longest = 0;
+            for (const Slot &slot : m_slots)
+            {
+                if (!slot.used)
+                {
+                    continue;
+                }
+                if (tiers)
+                {
+                    rings += HISTORY_TIER_COUNT * (1 + HistoryTiers::StatisticCount * 2);
+                    longest = std::max(longest, slot.tiers.allocated());
+                }
+                else
+                {
+                    rings += field == PromptI ? 2 : 1;
+                    longest = std::max(longest, slot.rings[field].samples.size());
+                }
+            }
+            if (rings == 0)
+            {
+                break;
+            }
+
+            size_t current = tiers ? m_tierCapacity : m_capacity[field];
+            size_t excess = m_memoryUsage - m_memoryBudget;
+            size_t samples = (excess + rings * sizeof(double) - 1) / (rings * sizeof(double));
+            size_t capacity = std::min(longest, current);
+            capacity = capacity > samples + HISTORY_MIN_CAPACITY ? capacity - samples : HISTORY_MIN_CAPACITY;
+            if (capacity >= current)
+            {
+                break;
+            }
+            if (tiers)
+            {
+                limitTiers(capacity);
+            }
+            else
+            {
+                limit(static_cast<Field>(field), capacity);
+            }
+        }
+    }
+}
@@ -0,0 +1,312 @@
+/*!
+ * \file channel_history_store.h
+ * \brief Interface of a dense, struct-of-arrays store for the sample history
+ * of the tracking channels.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#ifndef GNSS_SDR_MONITOR_CHANNEL_HISTORY_STORE_H_
+#define GNSS_SDR_MONITOR_CHANNEL_HISTORY_STORE_H_
+
+#include "history_tiers.h"
+#include "sliding_extrema.h"
+#include <boost/align/aligned_allocator.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/*!
+ Read-only view of the samples of one history ring, oldest first. A ring
+ that has wrapped around is exposed as two contiguous segments. The view is
+ only valid until the next append to, or release of, the satellite it refers to.
+ */
+class RingView
+{
+public:
+    RingView() : m_first(nullptr), m_firstSize(0), m_second(nullptr), m_secondSize(0), m_extrema(nullptr) {}
+    RingView(const double *first, size_t firstSize, const double *second, size_t secondSize, const SlidingExtrema<double> *extrema)
+        : m_first(first), m_firstSize(firstSize), m_second(second), m_secondSize(secondSize), m_extrema(extrema)
+    {
+    }
+
+    size_t size() const { return m_firstSize + m_secondSize; }
+    bool empty() const { return size() == 0; }
+
+    double operator[](size_t i) const { return i < m_firstSize ? m_first[i] : m_second[i - m_firstSize]; }
+    double front() const { return (*this)[0]; }
+    double back() const { return (*this)[size() - 1]; }
+
+    // The two contiguous segments, for loops that want to avoid the per-sample branch.
+    const double *firstData() const { return m_first; }
+    size_t firstSize() const { return m_firstSize; }
+    const double *secondData() const { return m_second; }
+    size_t secondSize() const { return m_secondSize; }
+
+    // Newest \a count samples, or all of them if there are fewer.
+    RingView tail(size_t count) const
+    {
+        size_t skip = size() > count ? size() - count : 0;
+        if (skip < m_firstSize)
+        {
+            return RingView(m_first + skip, m_firstSize - skip, m_second, m_secondSize, m_extrema);
+        }
+        return RingView(m_second + (skip - m_firstSize), size() - skip, nullptr, 0, m_extrema);
+    }
+
+    // Range of the samples, kept up to date by the store as samples are
+    // appended and evicted. Views without extrema, which are bounded in
+    // size, are scanned instead. The view must not be empty.
+    double minimum() const { return m_extrema ? (isWhole() ? m_extrema->minimum() : m_extrema->minimum(size())) : scan(size(), false); }
+    double maximum() const { return m_extrema ? (isWhole() ? m_extrema->maximum() : m_extrema->maximum(size())) : scan(size(), true); }
+
+    // Range of the newest \a count samples, with 0 < count <= size().
+    double minimum(size_t count) const { return m_extrema ? m_extrema->minimum(count) : scan(count, false); }
+    double maximum(size_t count) const { return m_extrema ? m_extrema->maximum(count) : scan(count, true); }
+
+private:
+    // Whether the view spans the whole window of its extrema, rather than a tail of it.
+    bool isWhole() const { return m_extrema->size() == size(); }
+
+    double scan(size_t count, bool maximum) const
+    {
+        double result = back();
+        for (size_t i = size() - count; i < size(); i++)
+        {
+            double value = (*this)[i];
+            result = maximum ? std::max(result, value) : std::min(result, value);
+        }
+        return result;
+    }
+
+    const double *m_first;
+    size_t m_firstSize;
+    const double *m_second;
+    size_t m_secondSize;
+    const SlidingExtrema<double> *m_extrema;
+};
+
+/*!
+ Two rings of the same channel paired as the x and y coordinates of a series.
+ The generation changes whenever the samples of the series change, so it can
+ be used to key anything derived from them. The sequence number of the newest
+ sample grows by one per appended sample, so a consumer that remembers it can
+ tell how many of the samples are new.
+
+ A series read from a downsampled tier has one point per bucket, with the
+ mean in y and the range of the samples of the bucket in low and high. They
+ are empty at full resolution.
+ */
+struct SeriesView
+{
+    RingView x;
+    RingView y;
+    RingView low;
+    RingView high;
+    int slot;  // Identifies the history: its store slot, or -1 if it is not kept in a store.
+    uint64_t generation;
+    uint64_t sequence;
+
+    size_t size() const { return y.size(); }
+    bool empty() const { return y.empty(); }
+};
+
+/*!
+ Owned copy of the newest samples of a series, with their range. Unlike a
+ SeriesView it stays valid while the store keeps appending, so it can be
+ handed to another thread.
+ */
+class SeriesSnapshot
+{
+public:
+    SeriesSnapshot(const SeriesView &series, size_t count);
+
+    SeriesView view() const;
+
+private:
+    std::vector<double> m_x;
+    std::vector<double> m_y;
+    SlidingExtrema<double> m_xExtrema;
+    SlidingExtrema<double> m_yExtrema;
+    int m_slot;
+    uint64_t m_generation;
+    uint64_t m_sequence;
+};
+
+/*!
+ Stores the recent history of every tracking channel.
+
+ Each satellite signal that has been seen, keyed by satelliteKey(), is
+ assigned a dense slot index, and each channel is bound to the slot of the
+ satellite it tracks. When a channel is reassigned, its binding moves and the
+ history of both satellites is kept, so a satellite that comes back to any
+ channel resumes its history. The history of a satellite no channel tracks
+ is dropped lazily, once it has been gone for the satellite timeout and a new
+ satellite needs a slot. A slot owns one ring per field, a plain vector of
+ doubles that a reader walks contiguously. Each field has its own capacity,
+ and the time ring is as long as the longest of the others.
+
+ The rings are not allocated up front. A ring starts small and doubles as
+ samples arrive until it reaches its capacity, so memory follows the history
+ actually held, and then overwrites its oldest sample. Appending is thus
+ amortized O(1): it reallocates while a ring grows, and never once the ring
+ is full. The storage of a ring starts on a cache line. Appending only
+ stores the sample: the minimum and maximum of each ring are brought up to
+ date when the ring is next viewed, from the samples appended since, so axis
+ ranges are read without a scan and fields nobody plots cost nothing. Their
+ deques grow then, up to the capacity, when longer monotonic runs of samples
+ need them.
+ Released slots are recycled, and their rings and tiers freed. Capacities
+ can be changed while channels are tracked: the rings keep their newest
+ samples, and those of the fields that did not change are untouched.
+
+ A memory budget can be set. When growing a ring or a tier takes the store
+ over it, or extrema grown by a view did since the last append, the capacity
+ of the least valuable history is lowered just enough to fit, dropping its
+ oldest samples: first the prompt I/Q, then the Doppler, then the
+ downsampled tiers and last the C/N0. When expired satellites release their
+ memory, the requested capacities are put back in force, to be lowered
+ again only if the history outgrows the budget once more.
+
+ The rings are tier 0 of the history. The time, C/N0 and Doppler of each
+ channel are also kept in coarser tiers (see HistoryTiers) that reach hours
+ back, and selectTier() picks the one that suits a plot of a given span. The
+ tiers grow with the history too, and count towards memoryUsage().
+ */
+class ChannelHistoryStore
+{
+public:
+    enum Field
+    {
+        Time = 0,
+        PromptI,
+        PromptQ,
+        Cn0,
+        Doppler,
+        FieldCount
+    };
+
+    explicit ChannelHistoryStore(size_t capacity = 0);
+
+    // Key of a satellite signal: its system, signal and PRN packed in 64 bits.
+    static uint64_t satelliteKey(uint16_t system, uint16_t signal, uint32_t prn)
+    {
+        return (static_cast<uint64_t>(system) << 48) | (static_cast<uint64_t>(signal) << 32) | prn;
+    }
+
+    void setCapacity(size_t capacity);
+    void setCapacity(Field field, size_t capacity);
+    size_t capacity(Field field) const;
+    size_t retention(Field field) const;
+
+    void setMemoryBudget(size_t bytes);
+    size_t memoryBudget() const;
+    size_t memoryUsage() const;
+    size_t tierMemoryUsage() const;
+    size_t tierCapacity() const;
+    size_t tierRetention() const;
+
+    int slotOf(int channelId) const;
+    int slotOfSatellite(uint64_t satellite) const;
+    int acquire(uint64_t satellite);
+    bool bind(int channelId, int slot);
+    void unbind(int channelId);
+    void release(int slot);
+    void clear();
+
+    void setSatelliteTimeout(double seconds);
+    double satelliteTimeout() const;
+    void evictExpired(std::vector<int> *slots);
+
+    int slotCount() const;
+    uint64_t satellite(int slot) const;
+    bool isUsed(int slot) const;
+    bool isTracked(int slot) const;
+
+    void append(int slot, double time, double promptI, double promptQ, double cn0, double doppler);
+    size_t size(int slot) const;
+    uint64_t generation(int slot) const;
+    uint64_t sequence(int slot) const;
+    RingView view(int slot, Field field) const;
+
+    int tierCount() const;
+    int selectTier(int slot, double minX, double maxX, int width) const;
+    RingView view(int slot, Field field, int tier, HistoryTiers::Statistic statistic = HistoryTiers::Mean) const;
+
+private:
+    struct Ring
+    {
+        // Grown up to the capacity of the field, and aligned to a cache line.
+        std::vector<double, boost::alignment::aligned_allocator<double, 64>> samples;
+        size_t head;  // Index of the oldest sample, 0 until the ring is full.
+        size_t size;
+        // Updated by view(), which is const, from the samples appended since,
+        // up to the capacity of the field.
+        mutable SlidingExtrema<double> extrema;
+        mutable size_t pending;
+    };
+
+    struct Slot
+    {
+        bool used;
+        uint64_t satellite;
+        int channels;        // Channels bound to the slot.
+        double unboundTime;  // Monotonic time, in seconds, of the last unbinding or acquisition.
+        uint64_t generation;
+        uint64_t sequence;  // Sequence number of the newest sample.
+        Ring rings[FieldCount];
+        HistoryTiers tiers;  // Time, C/N0 and Doppler.
+    };
+
+    bool push(Ring *ring, double value, size_t capacity);
+    void resize(Ring *ring, size_t capacity);
+    RingView samples(const Ring &ring) const;
+    void updateExtrema(const Ring &ring) const;
+    void freeRing(Ring *ring);
+    void freeTiers(HistoryTiers *tiers);
+    static size_t ringMemory(const Ring &ring);
+    void limit(Field field, size_t capacity);
+    void limitTiers(size_t capacity);
+    void applyCapacities();
+    void enforceBudget();
+
+    size_t m_retention[FieldCount];  // Capacities requested with setCapacity().
+    size_t m_capacity[FieldCount];   // Capacities in force, lowered by the budget.
+    size_t m_tierCapacity;           // Buckets per tier in force, lowered by the budget.
+    size_t m_memoryBudget;
+    mutable size_t m_memoryUsage;  // Bytes of the rings, their extrema and the tiers, see memoryUsage().
+    mutable bool m_extremaGrew;    // The extrema grew since the budget was last checked.
+    std::vector<Slot> m_slots;
+    std::vector<int> m_freeSlots;
+    std::vector<int> m_slotOfChannel;  // Indexed by channel id, -1 if none.
+    std::unordered_map<uint64_t, int> m_slotOfSatellite;
+    double m_satelliteTimeout;
+    uint64_t m_generation;
+};
+
+#endif  // GNSS_SDR_MONITOR_CHANNEL_HISTORY_STORE_H_
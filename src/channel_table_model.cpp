@@ -35,6 +35,8 @@
 #include <QDebug>
 #include <QList>
 #include <QtGui>
+#include <algorithm>
+#include <limits>
 #include <string.h>
 
 #define DEFAULT_BUFFER_SIZE 1000
@@ -42,32 +44,137 @@
 /*!
  Constructs an instance of a table model.
  */
-ChannelTableModel::ChannelTableModel()
+ChannelTableModel::ChannelTableModel() : m_history(DEFAULT_BUFFER_SIZE)
 {
-    m_mapSignalPrettyName["1C"] = "L1 C/A";
-    m_mapSignalPrettyName["1B"] = "E1";
-    m_mapSignalPrettyName["1G"] = "L1 C/A";
-    m_mapSignalPrettyName["2S"] = "L2C";
-    m_mapSignalPrettyName["2G"] = "L2 C/A";
-    m_mapSignalPrettyName["5X"] = "E5a";
-    m_mapSignalPrettyName["L5"] = "L5";
+    m_mapSignalPrettyName[packGnssCode('1', 'C')] = "L1 C/A";
+    m_mapSignalPrettyName[packGnssCode('1', 'B')] = "E1";
+    m_mapSignalPrettyName[packGnssCode('1', 'G')] = "L1 C/A";
+    m_mapSignalPrettyName[packGnssCode('2', 'S')] = "L2C";
+    m_mapSignalPrettyName[packGnssCode('2', 'G')] = "L2 C/A";
+    m_mapSignalPrettyName[packGnssCode('5', 'X')] = "E5a";
+    m_mapSignalPrettyName[packGnssCode('L', '5')] = "L5";
 
     m_columns = 11;
-    m_bufferSize = DEFAULT_BUFFER_SIZE;
+    m_viewMode = ChannelView;
+    m_updatedCells = 0;
+    m_firstVisibleRow = 0;
+    m_lastVisibleRow = std::numeric_limits<int>::max() - 1;
 }
 
 /*!
- Triggers a reset of the table model which casues the views to be repainted.
+ Notifies the views of the cells that changed since the last call. Rows
+ that are next to each other and changed in the same columns are merged into
+ a single dataChanged() range, so only those cells are repainted.
+
+ Only the rows set with setVisibleRows() are notified. The other rows keep
+ their changes pending until they are scrolled into view.
  */
 void ChannelTableModel::update()
 {
+    m_updatedCells = 0;
+
+    int row = std::max(m_firstVisibleRow, 0);
+    int rows = std::min(rowCount(QModelIndex()), m_lastVisibleRow + 1);
+    while (row < rows)
+    {
+        int slot = slotOfRow(row);
+        quint16 dirty = m_channelsDirty[slot];
+        if (!dirty)
+        {
+            row++;
+            continue;
+        }
+
+        // Extend the block over the following rows with the same dirty columns.
+        int lastRow = row;
+        while (lastRow + 1 < rows)
+        {
+            int nextSlot = slotOfRow(lastRow + 1);
+            if (m_channelsDirty[nextSlot] != dirty)
+            {
+                break;
+            }
+            m_channelsDirty[nextSlot] = 0;
+            lastRow++;
+        }
+        m_channelsDirty[slot] = 0;
+
+        // One range per run of consecutive dirty columns.
+        int column = 0;
+        while (column < m_columns)
+        {
+            if (!(dirty & (1 << column)))
+            {
+                column++;
+                continue;
+            }
+
+            int lastColumn = column;
+            while (lastColumn + 1 < m_columns && (dirty & (1 << (lastColumn + 1))))
+            {
+                lastColumn++;
+            }
+
+            emit dataChanged(index(row, column), index(lastRow, lastColumn));
+            m_updatedCells += (lastRow - row + 1) * (lastColumn - column + 1);
+
+            column = lastColumn + 1;
+        }
+
+        row = lastRow + 1;
+    }
+}
+
+/*!
+ Sets the range of rows, from \a first to \a last, that the view shows.
+ */
+void ChannelTableModel::setVisibleRows(int first, int last)
+{
+    m_firstVisibleRow = first;
+    m_lastVisibleRow = last;
+}
+
+/*!
+ Sets whether the rows of the table are the tracking channels or the
+ satellites with history. Both share the same history, so switching is only
+ a reset of the views.
+ */
+void ChannelTableModel::setViewMode(ViewMode mode)
+{
+    if (mode == m_viewMode)
+    {
+        return;
+    }
+
     beginResetModel();
+    m_viewMode = mode;
     endResetModel();
 }
 
+ChannelTableModel::ViewMode ChannelTableModel::viewMode() const
+{
+    return m_viewMode;
+}
+
+/*!
+ Returns the history slot shown in \a row, or -1 if there is no such row.
+ */
+int ChannelTableModel::slotOfRow(int row) const
+{
+    if (row < 0 || row >= rowCount(QModelIndex()))
+    {
+        return -1;
+    }
+    if (m_viewMode == SatelliteView)
+    {
+        return m_satelliteSlots[row];
+    }
+    return m_history.slotOf(m_channelsId[row]);
+}
+
 int ChannelTableModel::rowCount(const QModelIndex &parent) const
 {
-    return m_channels.size();
+    return m_viewMode == SatelliteView ? m_satelliteSlots.size() : m_channelsId.size();
 }
 
 int ChannelTableModel::columnCount(const QModelIndex &parent) const
@@ -77,147 +184,159 @@ int ChannelTableModel::columnCount(const QModelIndex &parent) const
 
 QVariant ChannelTableModel::data(const QModelIndex &index, int role) const
 {
-    if (role == Qt::DisplayRole || role == Qt::ToolTipRole || role == Qt::DecorationRole)
+    if (role == Qt::TextAlignmentRole)
     {
-        try
-        {
-            int channel_id = m_channelsId.at(index.row());
-
-            gnss_sdr::GnssSynchro channel = m_channels.at(channel_id);
-
-            QString channel_signal = m_channelsSignal.at(channel_id);
-
-            boost::circular_buffer<double> channel_time_cbuf =
-                m_channelsTime.at(channel_id);
-            boost::circular_buffer<double> channel_prompt_i_cbuf =
-                m_channelsPromptI.at(channel_id);
-            boost::circular_buffer<double> channel_prompt_q_cbuf =
-                m_channelsPromptQ.at(channel_id);
-            boost::circular_buffer<double> channel_cn0_cbuf =
-                m_channelsCn0.at(channel_id);
-            boost::circular_buffer<double> channel_doppler_cbuf =
-                m_channelsDoppler.at(channel_id);
-
-            QList<QVariant> channel_prompt_iq;
-            QList<QVariant> channel_cn0;
-            QList<QVariant> channel_doppler;
-
-            for (int i = 0; i < channel_cn0_cbuf.size(); i++)
-            {
-                channel_prompt_iq << QPointF(channel_prompt_i_cbuf.at(i),
-                    channel_prompt_q_cbuf.at(i));
-                channel_cn0 << QPointF(channel_time_cbuf.at(i), channel_cn0_cbuf.at(i));
-                channel_doppler << QPointF(channel_time_cbuf.at(i),
-                    channel_doppler_cbuf.at(i));
-            }
+        return Qt::AlignCenter;
+    }
 
-            if (role == Qt::DisplayRole)
-            {
-                switch (index.column())
-                {
-                case 0:
-                    return channel.channel_id();
+    if (role != Qt::DisplayRole && role != Qt::ToolTipRole && role != Qt::DecorationRole && role != SeriesRole)
+    {
+        return QVariant::Invalid;
+    }
 
-                case 1:
-                    return channel_signal;
+    int slot = slotOfRow(index.row());
+    if (slot < 0)
+    {
+        return QVariant::Invalid;
+    }
 
-                case 2:
-                    return channel.prn();
+    // Scalar columns are served from the latest sample, the history is only
+    // touched for SeriesRole, which hands out a view instead of a copy.
+    const ChannelSample &channel = m_channels[slot];
 
-                case 3:
-                    return channel.acq_doppler_hz();
+    if (role == Qt::DisplayRole)
+    {
+        switch (index.column())
+        {
+        case 0:
+            return channel.channel_id;
 
-                case 4:
-                    return channel.acq_delay_samples();
+        case 1:
+            return m_channelsSignal[slot];
 
-                case 5:
-                    return channel_prompt_iq;
+        case 2:
+            return channel.prn;
 
-                case 6:
-                    return channel_cn0;
+        case 3:
+            return channel.acq_doppler_hz;
 
-                case 7:
-                    return channel_doppler;
+        case 4:
+            return channel.acq_delay_samples;
 
-                case 8:
-                    return channel.tow_at_current_symbol_ms();
+        case 8:
+            return channel.tow_at_current_symbol_ms;
 
-                case 9:
-                    return channel.flag_valid_word();
+        case 9:
+            return channel.flag_valid_word;
 
-                case 10:
-                    return channel.pseudorange_m();
-                }
-            }
-            else if (role == Qt::ToolTipRole)
+        case 10:
+            return channel.pseudorange_m;
+        }
+    }
+    else if (role == SeriesRole)
+    {
+        if (index.column() >= 5 && index.column() <= 7)
+        {
+            SeriesView &series = m_channelsSeries[slot * 3 + index.column() - 5];
+            // A satellite keeps its slot, whichever channel tracks it.
+            series.slot = slot;
+            series.generation = m_history.generation(slot);
+            series.sequence = m_history.sequence(slot);
+            switch (index.column())
             {
-                switch (index.column())
-                {
-                case 0:
-                    return QVariant::Invalid;
-
-                case 1:
-                    return QVariant::Invalid;
-
-                case 2:
-                    return QVariant::Invalid;
+            case 5:
+                series.x = m_history.view(slot, ChannelHistoryStore::PromptI);
+                series.y = m_history.view(slot, ChannelHistoryStore::PromptQ);
+                break;
 
-                case 3:
-                    return QVariant::Invalid;
+            case 6:
+                series.y = m_history.view(slot, ChannelHistoryStore::Cn0);
+                series.x = m_history.view(slot, ChannelHistoryStore::Time).tail(series.y.size());
+                break;
 
-                case 4:
-                    return QVariant::Invalid;
+            case 7:
+                series.y = m_history.view(slot, ChannelHistoryStore::Doppler);
+                series.x = m_history.view(slot, ChannelHistoryStore::Time).tail(series.y.size());
+                break;
+            }
+            return QVariant::fromValue<const SeriesView *>(&series);
+        }
+    }
+    else if (role == Qt::ToolTipRole)
+    {
+        switch (index.column())
+        {
+        case 6:
+            return channel.cn0_db_hz;
 
-                case 5:
-                    return QVariant::Invalid;
+        case 7:
+            return channel.carrier_doppler_hz;
+        }
+    }
+    else if (index.column() == 1 && role == Qt::DecorationRole)
+    {
+        if (channel.system == packGnssCode('G'))
+        {
+            return QIcon(":/images/flag-us.png");
+        }
+        else if (channel.system == packGnssCode('R'))
+        {
+            return QIcon(":/images/flag-ru.png");
+        }
+        else if (channel.system == packGnssCode('E'))
+        {
+            return QIcon(":/images/flag-eu.png");
+        }
+        else if (channel.system == packGnssCode('C'))
+        {
+            return QIcon(":/images/flag-cn.png");
+        }
+    }
 
-                case 6:
-                    return channel_cn0_cbuf.back();
+    return QVariant::Invalid;
+}
 
-                case 7:
-                    return channel_doppler_cbuf.back();
+/*!
+ Returns the series plotted in the cell at \a index, read from the tier of
+ the history that suits a plot of the time span from \a minX to \a maxX that
+ is \a width pixels wide. The C/N0 and Doppler of a coarse tier come with the
+ range of each bucket. The constellation is always at full resolution. The
+ view is only valid until the model is next populated.
+ */
+SeriesView ChannelTableModel::getSeries(const QModelIndex &index, double minX, double maxX, int width) const
+{
+    SeriesView series;
+    series.slot = -1;
+    series.generation = 0;
+    series.sequence = 0;
 
-                case 8:
-                    return QVariant::Invalid;
+    int slot = slotOfRow(index.row());
+    if (slot < 0 || index.column() < 5 || index.column() > 7)
+    {
+        return series;
+    }
 
-                case 9:
-                    return QVariant::Invalid;
+    series.slot = slot;
+    series.generation = m_history.generation(slot);
+    series.sequence = m_history.sequence(slot);
 
-                case 10:
-                    return QVariant::Invalid;
-                }
-            }
-            else if (index.column() == 1 && role == Qt::DecorationRole)
-            {
-                if (channel.system() == "G")
-                {
-                    return QIcon(":/images/flag-us.png");
-                }
-                else if (channel.system() == "R")
-                {
-                    return QIcon(":/images/flag-ru.png");
-                }
-                else if (channel.system() == "E")
-                {
-                    return QIcon(":/images/flag-eu.png");
-                }
-                else if (channel.system() == "C")
-                {
-                    return QIcon(":/images/flag-cn.png");
-                }
-            }
-        }
-        catch (const std::exception &ex)
-        {
-            qDebug() << ex.what();
-            return QVariant::Invalid;
-        }
+    if (index.column() == 5)
+    {
+        series.x = m_history.view(slot, ChannelHistoryStore::PromptI);
+        series.y = m_history.view(slot, ChannelHistoryStore::PromptQ);
+        return series;
     }
-    else if (role == Qt::TextAlignmentRole)
+
+    ChannelHistoryStore::Field field = index.column() == 6 ? ChannelHistoryStore::Cn0 : ChannelHistoryStore::Doppler;
+    int tier = m_history.selectTier(slot, minX, maxX, width);
+    series.y = m_history.view(slot, field, tier, HistoryTiers::Mean);
+    series.x = m_history.view(slot, ChannelHistoryStore::Time, tier).tail(series.y.size());
+    if (tier > 0)
     {
-        return Qt::AlignCenter;
+        series.low = m_history.view(slot, field, tier, HistoryTiers::Minimum);
+        series.high = m_history.view(slot, field, tier, HistoryTiers::Maximum);
     }
-    return QVariant::Invalid;
+    return series;
 }
 
 QVariant ChannelTableModel::headerData(int section,
@@ -269,124 +388,160 @@ QVariant ChannelTableModel::headerData(int section,
 }
 
 /*!
- Populates the internal data structures of the table model with the data of the \a stocks collection of GnssSynchro objects.
- Internally, this function calls populateChannel() on each individual GnssSynchro object in the collection.
+ Populates the internal data structures of the table model with the channels of the decoded \a epoch.
+ Internally, this function calls populateChannel() on each individual channel sample of the epoch.
  */
-void ChannelTableModel::populateChannels(const gnss_sdr::Observables *stocks)
+void ChannelTableModel::populateChannels(const GnssSynchroEpoch &epoch)
 {
-    for (std::size_t i = 0; i < stocks->observable_size(); i++)
+    for (const ChannelSample &ch : epoch.channels)
     {
-        populateChannel(&stocks->observable(i));
+        populateChannel(ch);
     }
 }
 
 /*!
- Populates the internal data structures of the table model with the data of the \a ch GnssSynchro object.
+ Populates the internal data structures of the table model with the data of the \a ch channel sample.
+ The history is kept per satellite, so a channel that is reassigned to
+ another satellite shows the history that satellite already had, if any.
  */
-void ChannelTableModel::populateChannel(const gnss_sdr::GnssSynchro *ch)
+void ChannelTableModel::populateChannel(const ChannelSample &ch)
 {
     // Check if channel is valid, if not, do nothing.
-    if (ch->fs() != 0)
+    if (ch.fs != 0)
     {
-        // Channel is valid, now check if it exists in the map of channels.
-        if (m_channels.find(ch->channel_id()) != m_channels.end())
+        uint64_t satellite = ChannelHistoryStore::satelliteKey(ch.system, ch.signal, ch.prn);
+
+        // Check if the channel is tracking the same satellite as before.
+        int slot = m_history.slotOf(ch.channel_id);
+        bool newChannel = slot < 0;
+        bool newSatellite = false;
+        if (slot < 0 || m_history.satellite(slot) != satellite)
         {
-            // Channel exists, now check if its PRN is the same.
-            if (m_channels.at(ch->channel_id()).prn() != ch->prn())
+            slot = m_history.slotOfSatellite(satellite);
+            if (slot < 0)
             {
-                // PRN has changed so reset the channel.
-                clearChannel(ch->channel_id());
-            }
-        }
+                // The satellite has no history yet, so make room for it.
+                evictExpiredSatellites();
+                slot = m_history.acquire(satellite);
+                newSatellite = true;
 
-        // Check the size of the map of GnssSynchro objects before adding new data.
-        size_t map_size = m_channels.size();
+                if (m_channels.size() < static_cast<size_t>(m_history.slotCount()))
+                {
+                    m_channels.resize(m_history.slotCount());
+                    m_channelsSignal.resize(m_history.slotCount());
+                    m_channelsDirty.resize(m_history.slotCount());
+                    m_channelsSeries.resize(m_history.slotCount() * 3);
+                }
+            }
 
-        // Add the new GnssSynchro object to the map.
-        m_channels[ch->channel_id()] = *ch;
+            if (!m_history.bind(ch.channel_id, slot))
+            {
+                if (newSatellite)
+                {
+                    m_history.release(slot);
+                }
+                return;
+            }
 
-        // Time.
-        // Check if channel exists in the map of time data.
-        if (m_channelsTime.find(ch->channel_id()) == m_channelsTime.end())
-        {
-            // Channel does not exist so make room for it.
-            m_channelsTime[ch->channel_id()].resize(m_bufferSize);
-            m_channelsTime[ch->channel_id()].clear();
+            // An existing row of the channel now shows another satellite, so
+            // all of it changed. Otherwise the row of the satellite, if it is
+            // shown, changed like on any other sample. Changes still pending
+            // for the satellite are kept either way.
+            m_channelsDirty[slot] |= newChannel ? changedColumns(m_channels[slot], ch) : (1 << m_columns) - 1;
         }
-        // Populate map with new time data.
-        m_channelsTime[ch->channel_id()].push_back(ch->rx_time());
-
-        // In-phase prompt component.
-        // Check if channel exists in the map of in-phase component data.
-        if (m_channelsPromptI.find(ch->channel_id()) == m_channelsPromptI.end())
+        else
         {
-            // Channel does not exist so make room for it.
-            m_channelsPromptI[ch->channel_id()].resize(m_bufferSize);
-            m_channelsPromptI[ch->channel_id()].clear();
+            // Record which cells of the existing row have to be repainted.
+            m_channelsDirty[slot] |= changedColumns(m_channels[slot], ch);
         }
-        // Populate map with new in-phase component data.
-        m_channelsPromptI[ch->channel_id()].push_back(ch->prompt_i());
 
-        // Quadrature prompt component.
-        // Check if channel exists in the map of quadrature component data.
-        if (m_channelsPromptQ.find(ch->channel_id()) == m_channelsPromptQ.end())
+        // Signal name, only rebuilt when the signal changes.
+        if (newSatellite || m_channels[slot].system != ch.system || m_channels[slot].signal != ch.signal)
         {
-            // Channel does not exist so make room for it.
-            m_channelsPromptQ[ch->channel_id()].resize(m_bufferSize);
-            m_channelsPromptQ[ch->channel_id()].clear();
+            m_channelsSignal[slot] = getSignalPrettyName(ch);
         }
-        // Populate map with new quadrature component data.
-        m_channelsPromptQ[ch->channel_id()].push_back(ch->prompt_q());
 
-        // CN0.
-        // Check if channel exists in the map of CN0 data.
-        if (m_channelsCn0.find(ch->channel_id()) == m_channelsCn0.end())
+        // Keep the latest sample and append its time, prompt, CN0 and Doppler data to the history.
+        m_channels[slot] = ch;
+        m_history.append(slot, ch.rx_time, ch.prompt_i, ch.prompt_q, ch.cn0_db_hz, ch.carrier_doppler_hz);
+
+        if (newChannel)
         {
-            // Channel does not exist so make room for it.
-            m_channelsCn0[ch->channel_id()].resize(m_bufferSize);
-            m_channelsCn0[ch->channel_id()].clear();
+            // Record the new channel number in the vector of channel IDs.
+            appendRow(ChannelView, &m_channelsId, ch.channel_id);
         }
-        // Populate map with new CN0 data.
-        m_channelsCn0[ch->channel_id()].push_back(ch->cn0_db_hz());
-
-        // Doppler.
-        // Check if channel exists in the map of Doppler data.
-        if (m_channelsDoppler.find(ch->channel_id()) == m_channelsDoppler.end())
+        if (newSatellite)
         {
-            // Channel does not exist so make room for it.
-            m_channelsDoppler[ch->channel_id()].resize(m_bufferSize);
-            m_channelsDoppler[ch->channel_id()].clear();
+            appendRow(SatelliteView, &m_satelliteSlots, slot);
         }
-        // Populate map with new Doppler data.
-        m_channelsDoppler[ch->channel_id()].push_back(ch->carrier_doppler_hz());
+    }
+}
 
-        // Signal name.
-        // Populate map with new signal name.
-        m_channelsSignal[ch->channel_id()] = getSignalPrettyName(ch);
+/*!
+ Appends \a value to the \a rows of the given view \a mode, notifying the
+ views if that mode is the one shown.
+ */
+void ChannelTableModel::appendRow(ViewMode mode, std::vector<int> *rows, int value)
+{
+    int row = static_cast<int>(rows->size());
+    if (m_viewMode == mode)
+    {
+        beginInsertRows(QModelIndex(), row, row);
+    }
+    rows->push_back(value);
+    if (m_viewMode == mode)
+    {
+        endInsertRows();
+    }
+}
 
-        // Check the size of the map of GnssSynchro objects after adding new data.
-        if (m_channels.size() != map_size)
-        {
-            // Map size has changed so record the new channel number in the vector of channel IDs.
-            m_channelsId.push_back(ch->channel_id());
-        }
+/*!
+ Removes \a value from the \a rows of the given view \a mode, notifying
+ the views if that mode is the one shown.
+ */
+void ChannelTableModel::eraseRow(ViewMode mode, std::vector<int> *rows, int value)
+{
+    auto it = std::find(rows->begin(), rows->end(), value);
+    if (it == rows->end())
+    {
+        return;
+    }
+
+    int row = static_cast<int>(it - rows->begin());
+    if (m_viewMode == mode)
+    {
+        beginRemoveRows(QModelIndex(), row, row);
+    }
+    rows->erase(it);
+    if (m_viewMode == mode)
+    {
+        endRemoveRows();
+    }
+}
+
+/*!
+ Drops the history of the satellites that have not been tracked for longer
+ than the satellite timeout, and their rows.
+ */
+void ChannelTableModel::evictExpiredSatellites()
+{
+    std::vector<int> evicted;
+    m_history.evictExpired(&evicted);
+    for (int slot : evicted)
+    {
+        m_channelsDirty[slot] = 0;
+        eraseRow(SatelliteView, &m_satelliteSlots, slot);
     }
 }
 
 /*!
  Clears the data of a single channel specified by \a ch_id from the table model.
+ The history of the satellite it tracked is kept until it expires.
  */
 void ChannelTableModel::clearChannel(int ch_id)
 {
-    m_channelsId.erase(std::remove(m_channelsId.begin(), m_channelsId.end(), ch_id),
-        m_channelsId.end());
-    m_channels.erase(ch_id);
-    m_channelsSignal.erase(ch_id);
-    m_channelsTime.erase(ch_id);
-    m_channelsPromptI.erase(ch_id);
-    m_channelsPromptQ.erase(ch_id);
-    m_channelsCn0.erase(ch_id);
-    m_channelsDoppler.erase(ch_id);
+    eraseRow(ChannelView, &m_channelsId, ch_id);
+    m_history.unbind(ch_id);
 }
 
 /*!
@@ -394,37 +549,84 @@ void ChannelTableModel::clearChannel(int ch_id)
  */
 void ChannelTableModel::clearChannels()
 {
+    beginResetModel();
     m_channelsId.clear();
-    m_channels.clear();
-    m_channelsSignal.clear();
-    m_channelsTime.clear();
-    m_channelsPromptI.clear();
-    m_channelsPromptQ.clear();
-    m_channelsCn0.clear();
-    m_channelsDoppler.clear();
+    m_satelliteSlots.clear();
+    m_channelsDirty.assign(m_channelsDirty.size(), 0);
+    m_history.clear();
+    endResetModel();
 }
 
 /*!
- Gets the descriptive string formed by the combination of the GNSS system and signal name for a given \a ch GnssSynchro object.
+ Sets how long, in seconds, the history of a satellite that is no longer
+ tracked is kept, or 0 to keep it until the channels are cleared.
  */
-QString ChannelTableModel::getSignalPrettyName(const gnss_sdr::GnssSynchro *ch)
+void ChannelTableModel::setSatelliteTimeout(double seconds)
+{
+    m_history.setSatelliteTimeout(seconds);
+}
+
+/*!
+ Returns the columns, one bit per column, whose contents differ between the \a before and \a after samples of a channel.
+ */
+quint16 ChannelTableModel::changedColumns(const ChannelSample &before, const ChannelSample &after) const
+{
+    // Constellation, C/N0 and Doppler show the history, which grows with every sample.
+    quint16 columns = (1 << 5) | (1 << 6) | (1 << 7);
+
+    if (before.system != after.system || before.signal != after.signal)
+    {
+        columns |= 1 << 1;
+    }
+    if (before.prn != after.prn)
+    {
+        columns |= 1 << 2;
+    }
+    if (before.acq_doppler_hz != after.acq_doppler_hz)
+    {
+        columns |= 1 << 3;
+    }
+    if (before.acq_delay_samples != after.acq_delay_samples)
+    {
+        columns |= 1 << 4;
+    }
+    if (before.tow_at_current_symbol_ms != after.tow_at_current_symbol_ms)
+    {
+        columns |= 1 << 8;
+    }
+    if (before.flag_valid_word != after.flag_valid_word)
+    {
+        columns |= 1 << 9;
+    }
+    if (before.pseudorange_m != after.pseudorange_m)
+    {
+        columns |= 1 << 10;
+    }
+
+    return columns;
+}
+
+/*!
+ Gets the descriptive string formed by the combination of the GNSS system and signal name for a given \a ch channel sample.
+ */
+QString ChannelTableModel::getSignalPrettyName(const ChannelSample &ch)
 {
     QString system_name;
 
-    if (!ch->system().empty())
+    if (ch.system != 0)
     {
-        if (ch->system() == "G")
+        if (ch.system == packGnssCode('G'))
         {
             system_name = QStringLiteral("GPS");
         }
-        else if (ch->system() == "E")
+        else if (ch.system == packGnssCode('E'))
         {
             system_name = QStringLiteral("Galileo");
         }
 
-        if (m_mapSignalPrettyName.find(ch->signal()) != m_mapSignalPrettyName.end())
+        if (m_mapSignalPrettyName.find(ch.signal) != m_mapSignalPrettyName.end())
         {
-            system_name.append(" ").append(m_mapSignalPrettyName.at(ch->signal()));
+            system_name.append(" ").append(m_mapSignalPrettyName.at(ch.signal));
         }
     }
 
@@ -432,46 +634,88 @@ QString ChannelTableModel::getSignalPrettyName(const gnss_sdr::GnssSynchro *ch)
 }
 
 /*!
- Gets a list from a circular buffer \a cbuf.
+ Gets the number of columns of the table model.
  */
-QList<QVariant> ChannelTableModel::getListFromCbuf(boost::circular_buffer<double> cbuf)
+int ChannelTableModel::getColumns()
 {
-    QList<QVariant> list;
+    return m_columns;
+}
+
+/*!
+ Sets the number of samples of prompt I/Q (\a promptSize), C/N0 (\a cn0Size)
+ and Doppler (\a dopplerSize) kept per channel. The history is resized in
+ place, keeping the newest samples, and the sparklines are repainted.
+ */
+void ChannelTableModel::setRetention(size_t promptSize, size_t cn0Size, size_t dopplerSize)
+{
+    m_history.setCapacity(ChannelHistoryStore::PromptI, promptSize);
+    m_history.setCapacity(ChannelHistoryStore::Cn0, cn0Size);
+    m_history.setCapacity(ChannelHistoryStore::Doppler, dopplerSize);
+    markHistoryDirty();
+}
 
-    for (size_t i = 0; i < cbuf.size(); i++)
+/*!
+ Sets the number of bytes the full resolution history of all channels may
+ take, or 0 for no limit. See ChannelHistoryStore::setMemoryBudget().
+ */
+void ChannelTableModel::setMemoryBudget(size_t bytes)
+{
+    m_history.setMemoryBudget(bytes);
+    markHistoryDirty();
+}
+
+/*!
+ Marks the history columns of every channel for repainting on the next
+ update(), after their history was resized.
+ */
+void ChannelTableModel::markHistoryDirty()
+{
+    for (int slot = 0; slot < m_history.slotCount() && slot < static_cast<int>(m_channelsDirty.size()); slot++)
     {
-        list << cbuf.at(i);
+        if (m_history.isUsed(slot))
+        {
+            m_channelsDirty[slot] |= (1 << 5) | (1 << 6) | (1 << 7);
+        }
     }
-
-    return list;
 }
 
 /*!
- Gets the number of columns of the table model.
+ Gets the history store, to report its capacities and memory use.
  */
-int ChannelTableModel::getColumns()
+const ChannelHistoryStore &ChannelTableModel::getHistory() const
 {
-    return m_columns;
+    return m_history;
 }
 
 /*!
- Sets the size of the internal circular buffers that store the data of the table model.
+ Gets the number of cells whose change was notified to the views by the last call to update().
  */
-void ChannelTableModel::setBufferSize()
+int ChannelTableModel::getUpdatedCells()
 {
-    QSettings settings;
-    settings.beginGroup("Preferences_Dialog");
-    int size = settings.value("buffer_size", DEFAULT_BUFFER_SIZE).toInt();
-    settings.endGroup();
+    return m_updatedCells;
+}
 
-    m_bufferSize = size;
-    clearChannels();
+/*!
+ Rebuilds the latest GnssSynchro message of the channel with id \a key, for
+ export. Returns an empty message if the channel is not tracking.
+ */
+gnss_sdr::GnssSynchro ChannelTableModel::getChannelData(int key)
+{
+    gnss_sdr::GnssSynchro message;
+    int slot = m_history.slotOf(key);
+    if (slot >= 0)
+    {
+        GnssSynchroDecoder::toGnssSynchro(m_channels[slot], &message);
+    }
+    return message;
 }
 
 /*!
- Gets the id number of the channel occupying the queried \a row of the table model.
+ Gets the id number of the channel occupying the queried \a row of the table
+ model. In the satellite view, it is the last channel that tracked the satellite.
  */
 int ChannelTableModel::getChannelId(int row)
 {
-    return m_channelsId.at(row);
+    int slot = slotOfRow(row);
+    return slot < 0 ? -1 : m_channels[slot].channel_id;
 }
@@ -34,26 +34,54 @@
 #ifndef GNSS_SDR_MONITOR_CHANNEL_TABLE_MODEL_H_
 #define GNSS_SDR_MONITOR_CHANNEL_TABLE_MODEL_H_
 
+#include "channel_history_store.h"
 #include "gnss_synchro.pb.h"
-#include <boost/circular_buffer.hpp>
+#include "gnss_synchro_decoder.h"
 #include <QAbstractTableModel>
 
 class ChannelTableModel : public QAbstractTableModel
 {
 public:
+    /*!
+     Custom item roles. SeriesRole returns a const SeriesView * with the
+     history plotted in the Constellation, C/N0 and Doppler columns. The view
+     does not own the samples and is only valid until the model is next populated.
+     */
+    enum Roles
+    {
+        SeriesRole = Qt::UserRole + 1
+    };
+
+    /*!
+     What the rows of the table are: the tracking channels, or every
+     satellite that has history, tracked or not.
+     */
+    enum ViewMode
+    {
+        ChannelView,
+        SatelliteView
+    };
+
     ChannelTableModel();
 
     void update();
+    void setVisibleRows(int first, int last);
+    void setViewMode(ViewMode mode);
+    ViewMode viewMode() const;
 
-    void populateChannels(const gnss_sdr::Observables *m_stocks);
-    void populateChannel(const gnss_sdr::GnssSynchro *ch);
+    void populateChannels(const GnssSynchroEpoch &epoch);
+    void populateChannel(const ChannelSample &ch);
     void clearChannel(int ch_id);
     void clearChannels();
-    QString getSignalPrettyName(const gnss_sdr::GnssSynchro *ch);
-    QList<QVariant> getListFromCbuf(boost::circular_buffer<double> cbuf);
+    QString getSignalPrettyName(const ChannelSample &ch);
     int getColumns();
-    void setBufferSize();
+    void setRetention(size_t promptSize, size_t cn0Size, size_t dopplerSize);
+    void setMemoryBudget(size_t bytes);
+    void setSatelliteTimeout(double seconds);
+    const ChannelHistoryStore &getHistory() const;
     int getChannelId(int row);
+    int getUpdatedCells();
+    SeriesView getSeries(const QModelIndex &index, double minX, double maxX, int width) const;
 
     // List of virtual functions that must be implemented in a read-only table model.
     int rowCount(const QModelIndex &parent) const;
@@ -66,20 +94,39 @@ public slots:
 
 protected:
     int m_columns;
-    int m_bufferSize;
-    gnss_sdr::Observables m_stocks;
+    ViewMode m_viewMode;
 
+    // Rows of each view mode: channel ids, and history slots of the satellites.
     std::vector<int> m_channelsId;
-    std::map<int, gnss_sdr::GnssSynchro> m_channels;
-    std::map<int, QString> m_channelsSignal;
-    std::map<int, boost::circular_buffer<double>> m_channelsTime;
-    std::map<int, boost::circular_buffer<double>> m_channelsPromptI;
-    std::map<int, boost::circular_buffer<double>> m_channelsPromptQ;
-    std::map<int, boost::circular_buffer<double>> m_channelsCn0;
-    std::map<int, boost::circular_buffer<double>> m_channelsDoppler;
+    std::vector<int> m_satelliteSlots;
+    ChannelHistoryStore m_history;
+
+    // Latest sample and signal name of each satellite, indexed by history slot.
+    std::vector<ChannelSample> m_channels;
+    std::vector<QString> m_channelsSignal;
+
+    // Columns changed since the last update(), one bit per column, indexed by history slot.
+    std::vector<quint16> m_channelsDirty;
+    int m_updatedCells;
+
+    // Rows shown by the view, the only ones notified by update().
+    int m_firstVisibleRow;
+    int m_lastVisibleRow;
+
+    // Series handed out through SeriesRole, three per history slot.
+    mutable std::vector<SeriesView> m_channelsSeries;
 
 private:
-    std::map<std::string, QString> m_mapSignalPrettyName;
+    quint16 changedColumns(const ChannelSample &before, const ChannelSample &after) const;
+    void markHistoryDirty();
+    int slotOfRow(int row) const;
+    void appendRow(ViewMode mode, std::vector<int> *rows, int value);
+    void eraseRow(ViewMode mode, std::vector<int> *rows, int value);
+    void evictExpiredSatellites();
+
+    std::map<uint16_t, QString> m_mapSignalPrettyName;
 };
 
+Q_DECLARE_METATYPE(const SeriesView *)
+
 #endif  // GNSS_SDR_MONITOR_CHANNEL_TABLE_MODEL_H_
@@ -32,6 +32,8 @@
 
 
 #include "cn0_delegate.h"
+#include "channel_table_model.h"
+#include "series_decimator.h"
 #include <QApplication>
 #include <QDebug>
 #include <QPainter>
@@ -62,6 +64,7 @@ Cn0Delegate::~Cn0Delegate()
 void Cn0Delegate::setBufferSize(size_t size)
 {
     m_bufferSize = size;
+    m_cache.clear();
 }
 
 /*!
@@ -73,6 +76,7 @@ void Cn0Delegate::setCn0Range(double min, double max)
     {
         m_minCn0 = min;
         m_maxCn0 = max;
+        m_cache.clear();
     }
 }
 
@@ -82,30 +86,55 @@ void Cn0Delegate::setCn0Range(double min, double max)
 void Cn0Delegate::setAutoRangeEnabled(bool enabled)
 {
     m_autoRangeEnabled = enabled;
+    m_cache.clear();
 }
 
 void Cn0Delegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
     const QModelIndex &index) const
 {
-    bool outOfScale = false;
+    QStyledItemDelegate::paint(painter, option, index);
 
-    QVector<QPointF> points;
-    QVector<double> x_data, y_data;
-    QList<QVariant> var = index.data(Qt::DisplayRole).toList();
-    for (int i = 0; i < var.size(); i++)
+    // The samples are read in place from the model's history.
+    const SeriesView *series = index.data(ChannelTableModel::SeriesRole).value<const SeriesView *>();
+    if (!series || series->empty() || option.rect.isEmpty())
     {
-        points << var.at(i).toPointF();
-        x_data << var.at(i).toPointF().x();
-        y_data << var.at(i).toPointF().y();
+        return;
     }
 
+    // Blit the last rendering of this channel. A newer one is rendered on the
+    // thread pool when the data changes.
+    m_cache.setModel(index.model());
+    SparklineCache::Key key = SparklineCache::makeKey(*series, index, option, painter->device()->devicePixelRatioF());
+
+    QStyleOptionViewItem cellOption = option;
+    initStyleOption(&cellOption, index);
+    SparklineCache::prepareOption(&cellOption);
+
+    QPixmap pixmap = m_cache.pixmap(key, *series, m_bufferSize, option.widget,
+        [cellOption, bufferSize = m_bufferSize, minCn0 = m_minCn0, maxCn0 = m_maxCn0,
+            autoRangeEnabled = m_autoRangeEnabled](QPainter *pixmapPainter, const SeriesView &samples) {
+            drawSparkline(pixmapPainter, cellOption, samples, bufferSize, minCn0, maxCn0, autoRangeEnabled);
+        });
+    painter->drawPixmap(option.rect.topLeft(), pixmap);
+}
+
+/*!
+ Draws the sparkline of \a series in the cell described by \a option, which
+ is at the origin and already styled. It may run on a worker thread.
+ */
+void Cn0Delegate::drawSparkline(QPainter *painter, const QStyleOptionViewItem &option,
+    const SeriesView &series, size_t bufferSize, double minCn0, double maxCn0, bool autoRangeEnabled)
+{
+    bool outOfScale = false;
+
+
     double min_x = std::numeric_limits<double>::max();
     double max_x = -std::numeric_limits<double>::max();
 
-    double min_y = m_minCn0;
-    double max_y = m_maxCn0;
+    double min_y = minCn0;
+    double max_y = maxCn0;
 
-    if (m_autoRangeEnabled)
+    if (autoRangeEnabled)
     {
         min_y = std::numeric_limits<double>::max();
         max_y = -std::numeric_limits<double>::max();
@@ -140,61 +169,47 @@ void Cn0Delegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
     QRect sparklineRect = QRect(sparklineOrigin, QSize(sparklineWidth, contentHeight));
     QRect textRect = QRect(textOrigin, QSize(textWidth, contentHeight));
 
-    QPointF val;
     QVector<QPointF> fpoints;
-    QStyledItemDelegate::paint(painter, option, index);
 
-    if (points.isEmpty() || m_bufferSize < 1.0 || contentHeight <= 0)
+    if (series.empty() || bufferSize < 1.0 || contentHeight <= 0)
     {
         return;
     }
 
-    // Remove first points until the number of elements is within the designated buffer size.
-    while (points.length() > m_bufferSize)
-    {
-        points.removeFirst();
-    }
-
-    foreach (val, points)
-    {
-        // Find the min and max values of the time data (horizontal axis).
-        if (val.x() < min_x)
-        {
-            min_x = val.x();
-        }
+    // Skip the oldest samples so that the number of elements is within the designated buffer size.
+    size_t first = series.size() > bufferSize ? series.size() - bufferSize : 0;
 
-        if (val.x() > max_x)
-        {
-            max_x = val.x();
-        }
+    size_t count = series.size() - first;
 
-        // Find the min and max values of the CN0 data (vertical axis) if auto range is enabled.
-        if (m_autoRangeEnabled)
-        {
-            if (val.y() < min_y)
-            {
-                min_y = val.y();
-            }
+    // Get the min and max values of the time data (horizontal axis).
+    min_x = series.x.minimum(count);
+    max_x = series.x.maximum(count);
 
-            if (val.y() > max_y)
-            {
-                max_y = val.y();
-            }
-        }
+    // Get the min and max values of the CN0 data (vertical axis) if auto range is enabled.
+    if (autoRangeEnabled)
+    {
+        min_y = series.y.minimum(count);
+        max_y = series.y.maximum(count);
     }
 
+    // The sparkline cannot show more detail than its width in pixels, so only
+    // the samples that shape the line in each pixel column are drawn.
+    std::vector<size_t> indices;
+    SeriesDecimator::m4(series, first, series.size(), min_x, max_x, sparklineWidth, &indices);
+
     // Map the real CN0 data to the sparkline coordinate system.
-    foreach (val, points)
+    fpoints.reserve(indices.size() + 2);
+    for (size_t i : indices)
     {
-        double x_in = val.x();
-        double y_in = val.y();
+        double x_in = series.x[i];
+        double y_in = series.y[i];
 
         double x_out = 0;
         double y_out = 0;
 
-        if (!m_autoRangeEnabled)
+        if (!autoRangeEnabled)
         {
-            if (y_in > m_maxCn0)
+            if (y_in > maxCn0)
             {
                 // Value is out of scale!
                 outOfScale = true;
@@ -210,35 +225,25 @@ void Cn0Delegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
         fpoints.append(QPointF(x_out, y_out));
     }
 
-    QStyleOptionViewItem option_vi = option;
-    QStyledItemDelegate::initStyleOption(&option_vi, index);
-
     painter->save();
 
-    if (QApplication::style()->objectName().contains("vista"))
-    {
-        // QWindowsVistaStyle::drawControl does this internally. Unfortunately there
-        // doesn't appear to be a more general way to do this.
-        option_vi.palette.setColor(QPalette::All, QPalette::HighlightedText, option_vi.palette.color(QPalette::Active, QPalette::Text));
-    }
-
-    QPalette::ColorGroup cg = option_vi.state & QStyle::State_Enabled
+    QPalette::ColorGroup cg = option.state & QStyle::State_Enabled
                                   ? QPalette::Normal
                                   : QPalette::Disabled;
-    if (cg == QPalette::Normal && !(option_vi.state & QStyle::State_Active))
+    if (cg == QPalette::Normal && !(option.state & QStyle::State_Active))
         cg = QPalette::Inactive;
 #if defined(Q_OS_WIN)
-    if (option_vi.state & QStyle::State_Selected)
+    if (option.state & QStyle::State_Selected)
     {
 #else
-    if ((option_vi.state & QStyle::State_Selected) && !(option_vi.state & QStyle::State_MouseOver))
+    if ((option.state & QStyle::State_Selected) && !(option.state & QStyle::State_MouseOver))
     {
 #endif
-        painter->setPen(option_vi.palette.color(cg, QPalette::HighlightedText));
+        painter->setPen(option.palette.color(cg, QPalette::HighlightedText));
     }
     else
     {
-        painter->setPen(option_vi.palette.color(cg, QPalette::Text));
+        painter->setPen(option.palette.color(cg, QPalette::Text));
     }
 
     // Enable antialiasing.
@@ -288,10 +293,10 @@ void Cn0Delegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
     }
 
     // Get the value of the last CN0 smple.
-    double lastCN0 = var.last().toPointF().y();
+    double lastCN0 = series.y.back();
 
     // If the value of the last CN0 sample is outside of the designated scale use red color otherwise use black.
-    if (lastCN0 < m_minCn0 || lastCN0 > m_maxCn0)
+    if (lastCN0 < minCn0 || lastCN0 > maxCn0)
     {
         painter->setPen(Qt::red);
     }
@@ -34,6 +34,7 @@
 #ifndef GNSS_SDR_MONITOR_CN0_DELEGATE_H_
 #define GNSS_SDR_MONITOR_CN0_DELEGATE_H_
 
+#include "sparkline_cache.h"
 #include <QStyledItemDelegate>
 
 class Cn0Delegate : public QStyledItemDelegate
@@ -42,6 +43,9 @@ public:
     Cn0Delegate(QWidget *parent = nullptr);
     ~Cn0Delegate();
 
+    static void drawSparkline(QPainter *painter, const QStyleOptionViewItem &option,
+        const SeriesView &series, size_t bufferSize, double minCn0, double maxCn0, bool autoRangeEnabled);
+
 public slots:
     void setBufferSize(size_t size);
     void setCn0Range(double min, double max);
@@ -60,6 +64,8 @@ private:
     double m_minCn0;
     double m_maxCn0;
     bool m_autoRangeEnabled;
+
+    mutable SparklineCache m_cache;
 };
 
 #endif  // GNSS_SDR_MONITOR_CN0_DELEGATE_H_
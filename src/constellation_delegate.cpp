@@ -32,9 +32,12 @@
 
 
 #include "constellation_delegate.h"
+#include "channel_table_model.h"
+#include "series_decimator.h"
 #include <QApplication>
 #include <QDebug>
 #include <QPainter>
+#include <algorithm>
 
 #define SPARKLINE_MIN_EM_WIDTH 10
 
@@ -49,17 +52,38 @@ ConstellationDelegate::~ConstellationDelegate()
 void ConstellationDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
     const QModelIndex &index) const
 {
-    QList<QPointF> points;
-    QVector<double> x_data, y_data;
-    QList<QVariant> var = index.data(Qt::DisplayRole).toList();
-    for (int i = 0; i < var.size(); i++)
+    QStyledItemDelegate::paint(painter, option, index);
+
+    // The samples are read in place from the model's history.
+    const SeriesView *series = index.data(ChannelTableModel::SeriesRole).value<const SeriesView *>();
+    if (!series || series->empty() || option.rect.isEmpty())
     {
-        points << var.at(i).toPointF();
-        x_data << var.at(i).toPointF().x();
-        y_data << var.at(i).toPointF().y();
+        return;
     }
 
+    // Blit the last rendering of this channel. A newer one is rendered on the
+    // thread pool when the data changes.
+    m_cache.setModel(index.model());
+    SparklineCache::Key key = SparklineCache::makeKey(*series, index, option, painter->device()->devicePixelRatioF());
+
+    QStyleOptionViewItem cellOption = option;
+    initStyleOption(&cellOption, index);
+    SparklineCache::prepareOption(&cellOption);
+
+    QPixmap pixmap = m_cache.pixmap(key, *series, series->size(), option.widget,
+        [cellOption](QPainter *pixmapPainter, const SeriesView &samples) {
+            drawSparkline(pixmapPainter, cellOption, samples);
+        });
+    painter->drawPixmap(option.rect.topLeft(), pixmap);
+}
 
+/*!
+ Draws the sparkline of \a series in the cell described by \a option, which
+ is at the origin and already styled. It may run on a worker thread.
+ */
+void ConstellationDelegate::drawSparkline(QPainter *painter, const QStyleOptionViewItem &option,
+    const SeriesView &series)
+{
     double min_x = 0;
     double max_x = 1;
     double min_y = 0;
@@ -77,71 +101,45 @@ void ConstellationDelegate::paint(QPainter *painter, const QStyleOptionViewItem
     int button_h = option.fontMetrics.height();
     int button_w = button_h;
 
-    // Paint using default painter.
-    QStyledItemDelegate::paint(painter, option, index);
-
     // If any of this occurs, don't continue.
-    if (points.isEmpty() /* || points.size() < 4 */ || content_h <= 0)
+    if (series.empty() /* || series.size() < 4 */ || content_h <= 0)
     {
         return;
     }
 
-    QPointF p;
-    foreach (p, points)
-    {
-        if (p.x() < min_x)
-        {
-            min_x = p.x();
-        }
-
-        if (p.x() > max_x)
-        {
-            max_x = p.x();
-        }
-
-        if (p.y() < min_y)
-        {
-            min_y = p.y();
-        }
-
-        if (p.y() > max_y)
-        {
-            max_y = p.y();
-        }
-    }
+    // The range always includes the unit square.
+    min_x = std::min(min_x, series.x.minimum());
+    max_x = std::max(max_x, series.x.maximum());
+    min_y = std::min(min_y, series.y.minimum());
+    max_y = std::max(max_y, series.y.maximum());
+
+    // Points that land on the same pixel are drawn once.
+    std::vector<size_t> indices;
+    SeriesDecimator::pixelGrid(series, min_x, max_x, min_y, max_y, content_w, content_h, &indices);
 
     QVector<QPointF> fpoints;
-    foreach (p, points)
+    fpoints.reserve(indices.size());
+    for (size_t i : indices)
     {
-        fpoints.append(QPointF((qreal)content_w * (p.x() - min_x) / (max_x - min_x),
-            (qreal)content_h - (content_h * (p.y() - min_y) / (max_y - min_y))));
+        fpoints.append(QPointF((qreal)content_w * (series.x[i] - min_x) / (max_x - min_x),
+            (qreal)content_h - (content_h * (series.y[i] - min_y) / (max_y - min_y))));
     }
 
-    QStyleOptionViewItem option_vi = option;
-    QStyledItemDelegate::initStyleOption(&option_vi, index);
-
     painter->save();
 
-    if (QApplication::style()->objectName().contains("vista"))
-    {
-        // QWindowsVistaStyle::drawControl does this internally. Unfortunately there
-        // doesn't appear to be a more general way to do this.
-        option_vi.palette.setColor(QPalette::All, QPalette::HighlightedText, option_vi.palette.color(QPalette::Active, QPalette::Text));
-    }
-
-    QPalette::ColorGroup cg = option_vi.state & QStyle::State_Enabled
+    QPalette::ColorGroup cg = option.state & QStyle::State_Enabled
                                   ? QPalette::Normal
                                   : QPalette::Disabled;
-    if (cg == QPalette::Normal && !(option_vi.state & QStyle::State_Active))
+    if (cg == QPalette::Normal && !(option.state & QStyle::State_Active))
         cg = QPalette::Inactive;
 #if defined(Q_OS_WIN)
-    if (option_vi.state & QStyle::State_Selected)
+    if (option.state & QStyle::State_Selected)
     {
 #else
-    if ((option_vi.state & QStyle::State_Selected) && !(option_vi.state & QStyle::State_MouseOver))
+    if ((option.state & QStyle::State_Selected) && !(option.state & QStyle::State_MouseOver))
     {
 #endif
-        painter->setPen(option_vi.palette.color(cg, QPalette::HighlightedText));
+        painter->setPen(option.palette.color(cg, QPalette::HighlightedText));
     }
     else
     {
@@ -154,7 +152,7 @@ void ConstellationDelegate::paint(QPainter *painter, const QStyleOptionViewItem
         pen.setJoinStyle(Qt::RoundJoin);
 
         painter->setPen(pen);
-        //painter->setPen(option_vi.palette.color(cg, QPalette::Text));
+        //painter->setPen(option.palette.color(cg, QPalette::Text));
     }
 
     painter->setRenderHint(QPainter::Antialiasing, true);
@@ -163,9 +161,12 @@ void ConstellationDelegate::paint(QPainter *painter, const QStyleOptionViewItem
 
     painter->drawPoints(QPolygonF(fpoints));
 
-    painter->setPen(Qt::NoPen);
-    painter->setBrush(QBrush(QColor("#FF4136"), Qt::SolidPattern));
-    painter->drawEllipse(fpoints.last(), 2, 2);
+    if (!fpoints.isEmpty())
+    {
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(QBrush(QColor("#FF4136"), Qt::SolidPattern));
+        painter->drawEllipse(fpoints.last(), 2, 2);
+    }
 
     painter->restore();
 
@@ -34,6 +34,7 @@
 #ifndef GNSS_SDR_MONITOR_CONSTELLATION_DELEGATE_H_
 #define GNSS_SDR_MONITOR_CONSTELLATION_DELEGATE_H_
 
+#include "sparkline_cache.h"
 #include <QStyledItemDelegate>
 
 class ConstellationDelegate : public QStyledItemDelegate
@@ -48,6 +49,12 @@ protected:
 
     QSize sizeHint(const QStyleOptionViewItem &option,
         const QModelIndex &index) const;
+
+private:
+    static void drawSparkline(QPainter *painter, const QStyleOptionViewItem &option,
+        const SeriesView &series);
+
+    mutable SparklineCache m_cache;
 };
 
 #endif  // GNSS_SDR_MONITOR_CONSTELLATION_DELEGATE_H_
@@ -0,0 +1,247 @@
+/*!
+ * \file datagram_receiver.cpp
+ * \brief Implementation of the UDP receive backends used by the ingest engine.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "datagram_receiver.h"
+#include <QDebug>
+#include <QSocketNotifier>
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QUdpSocket>
+
+#if defined(Q_OS_LINUX)
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#endif
+
+/*!
+ Constructs a slab of \a capacity buffers of \a datagramSize bytes each.
+ */
+DatagramBatch::DatagramBatch(int capacity, int datagramSize) : m_datagramSize(datagramSize),
+                                                               m_size(0),
+                                                               m_slab(static_cast<size_t>(capacity) * datagramSize),
+                                                               m_lengths(capacity, 0)
+{
+}
+
+DatagramReceiver::DatagramReceiver(Backend backend, QObject *parent) : QObject(parent), m_backend(backend)
+{
+}
+
+/*!
+ Returns the backend actually used by this receiver.
+ */
+DatagramReceiver::Backend DatagramReceiver::backend() const
+{
+    return m_backend;
+}
+
+namespace
+{
+/*!
+ Portable backend that reads one datagram per call through QUdpSocket.
+ */
+class QtDatagramReceiver : public DatagramReceiver
+{
+public:
+    explicit QtDatagramReceiver(QObject *parent) : DatagramReceiver(QtSocketBackend, parent)
+    {
+        m_socket = new QUdpSocket(this);
+        connect(m_socket, &QUdpSocket::readyRead, this, &DatagramReceiver::readyRead);
+    }
+
+    bool bind(quint16 port) override
+    {
+        return m_socket->bind(QHostAddress::Any, port);
+    }
+
+    void close() override
+    {
+        m_socket->close();
+    }
+
+    int receive(DatagramBatch *batch) override
+    {
+        int n = 0;
+        while (n < batch->capacity() && m_socket->hasPendingDatagrams())
+        {
+            qint64 length = m_socket->readDatagram(batch->buffer(n), batch->datagramSize());
+            if (length < 0)
+            {
+                break;
+            }
+            batch->setLength(n, static_cast<int>(length));
+            n++;
+        }
+        batch->setSize(n);
+        return n;
+    }
+
+private:
+    QUdpSocket *m_socket;
+};
+
+#if defined(Q_OS_LINUX)
+/*!
+ Linux backend that drains up to a whole batch of datagrams with a single recvmmsg() call.
+ */
+class MmsgDatagramReceiver : public DatagramReceiver
+{
+public:
+    explicit MmsgDatagramReceiver(QObject *parent) : DatagramReceiver(RecvMmsgBackend, parent)
+    {
+    }
+
+    ~MmsgDatagramReceiver()
+    {
+        close();
+    }
+
+    bool bind(quint16 port) override
+    {
+        close();
+
+        m_fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (m_fd < 0)
+        {
+            qDebug() << "recvmmsg backend: socket() failed:" << std::strerror(errno);
+            return false;
+        }
+
+        int reuse = 1;
+        ::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(port);
+        if (::bind(m_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0)
+        {
+            qDebug() << "recvmmsg backend: bind() to port" << port << "failed:" << std::strerror(errno);
+            close();
+            return false;
+        }
+
+        m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+        connect(m_notifier, SIGNAL(activated(int)), this, SIGNAL(readyRead()));
+        return true;
+    }
+
+    void close() override
+    {
+        delete m_notifier;
+        m_notifier = nullptr;
+
+        if (m_fd >= 0)
+        {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    int receive(DatagramBatch *batch) override
+    {
+        batch->setSize(0);
+        if (m_fd < 0)
+        {
+            return 0;
+        }
+
+        const int capacity = batch->capacity();
+        if (static_cast<int>(m_headers.size()) < capacity)
+        {
+            m_headers.resize(capacity);
+            m_iovecs.resize(capacity);
+        }
+
+        for (int i = 0; i < capacity; i++)
+        {
+            m_iovecs[i].iov_base = batch->buffer(i);
+            m_iovecs[i].iov_len = batch->datagramSize();
+            std::memset(&m_headers[i], 0, sizeof(mmsghdr));
+            m_headers[i].msg_hdr.msg_iov = &m_iovecs[i];
+            m_headers[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int received = ::recvmmsg(m_fd, m_headers.data(), capacity, MSG_DONTWAIT, nullptr);
+        if (received <= 0)
+        {
+            return 0;
+        }
+
+        // Skip datagrams that did not fit in a slot rather than decoding a truncated message.
+        int n = 0;
+        for (int i = 0; i < received; i++)
+        {
+            if (m_headers[i].msg_hdr.msg_flags & MSG_TRUNC)
+            {
+                continue;
+            }
+            if (n != i)
+            {
+                std::memcpy(batch->buffer(n), batch->buffer(i), m_headers[i].msg_len);
+            }
+            batch->setLength(n, static_cast<int>(m_headers[i].msg_len));
+            n++;
+        }
+        batch->setSize(n);
+        return received;
+    }
+
+private:
+    int m_fd = -1;
+    QSocketNotifier *m_notifier = nullptr;
+    std::vector<mmsghdr> m_headers;
+    std::vector<iovec> m_iovecs;
+};
+#endif
+}  // namespace
+
+/*!
+ Creates a receiver for the requested \a backend. Falls back to the portable
+ QUdpSocket backend when recvmmsg() is not available on this platform.
+ */
+DatagramReceiver *DatagramReceiver::create(Backend backend, QObject *parent)
+{
+#if defined(Q_OS_LINUX)
+    if (backend == RecvMmsgBackend)
+    {
+        return new MmsgDatagramReceiver(parent);
+    }
+#else
+    if (backend == RecvMmsgBackend)
+    {
+        qDebug() << "recvmmsg backend not available on this platform, using QUdpSocket";
+    }
+#endif
+    return new QtDatagramReceiver(parent);
+}
@@ -0,0 +1,93 @@
+/*!
+ * \file datagram_receiver.h
+ * \brief Interface of the UDP receive backends used by the ingest engine.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#ifndef GNSS_SDR_MONITOR_DATAGRAM_RECEIVER_H_
+#define GNSS_SDR_MONITOR_DATAGRAM_RECEIVER_H_
+
+#include <QObject>
+#include <vector>
+
+/*!
+ A preallocated slab of datagram buffers that is filled by a
+ DatagramReceiver and reused from one burst to the next.
+ */
+class DatagramBatch
+{
+public:
+    DatagramBatch(int capacity, int datagramSize);
+
+    int capacity() const { return static_cast<int>(m_lengths.size()); }
+    int datagramSize() const { return m_datagramSize; }
+    int size() const { return m_size; }
+
+    const char *data(int i) const { return &m_slab[static_cast<size_t>(i) * m_datagramSize]; }
+    int length(int i) const { return m_lengths[i]; }
+
+    char *buffer(int i) { return &m_slab[static_cast<size_t>(i) * m_datagramSize]; }
+    void setLength(int i, int length) { m_lengths[i] = length; }
+    void setSize(int size) { m_size = size; }
+
+private:
+    int m_datagramSize;
+    int m_size;
+    std::vector<char> m_slab;
+    std::vector<int> m_lengths;
+};
+
+class DatagramReceiver : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Backend
+    {
+        QtSocketBackend = 0,
+        RecvMmsgBackend = 1
+    };
+
+    static DatagramReceiver *create(Backend backend, QObject *parent = nullptr);
+
+    virtual bool bind(quint16 port) = 0;
+    virtual void close() = 0;
+    virtual int receive(DatagramBatch *batch) = 0;
+
+    Backend backend() const;
+
+signals:
+    void readyRead();
+
+protected:
+    DatagramReceiver(Backend backend, QObject *parent);
+
+private:
+    Backend m_backend;
+};
+
+#endif  // GNSS_SDR_MONITOR_DATAGRAM_RECEIVER_H_
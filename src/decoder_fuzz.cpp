@@ -0,0 +1,558 @@
+/*!
+ * \file decoder_fuzz.cpp
+ * \brief Checks the GnssSynchro wire decoder against libprotobuf on random
+ * and mutated messages, and compares their throughput.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "gnss_synchro.pb.h"
+#include "gnss_synchro_decoder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <google/protobuf/unknown_field_set.h>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Channels of the epoch used for the throughput comparison, the speedup over
+// libprotobuf that the decoder is expected to reach on it, and the timing.
+#define FUZZ_BENCH_CHANNELS 64
+#define FUZZ_BENCH_TARGET_SPEEDUP 3.0
+#define FUZZ_BENCH_ROUNDS 15
+#define FUZZ_BENCH_EPOCHS 10000
+
+namespace
+{
+std::mt19937_64 rng;
+
+uint64_t randomBelow(uint64_t limit)
+{
+    return std::uniform_int_distribution<uint64_t>(0, limit - 1)(rng);
+}
+
+double randomDouble()
+{
+    switch (randomBelow(8))
+    {
+    case 0:
+        return 0.0;
+    case 1:
+    {
+        // Any bit pattern, including NaNs, infinities and denormals.
+        uint64_t bits = rng();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    default:
+        return std::uniform_real_distribution<double>(-1e8, 1e8)(rng);
+    }
+}
+
+uint64_t randomVarint()
+{
+    // Mostly small values, which encode in few bytes, and sometimes any value.
+    return randomBelow(4) == 0 ? rng() : randomBelow(1ull << (7 * (1 + randomBelow(4))));
+}
+
+std::string randomCode()
+{
+    static const char *codes[] = {"G", "E", "R", "C", "S", "1C", "1B", "2S", "5X", "L5", "7X", "", "1Cx"};
+    return codes[randomBelow(sizeof(codes) / sizeof(codes[0]))];
+}
+
+void randomGnssSynchro(gnss_sdr::GnssSynchro *message)
+{
+    // Each field is left at its default now and then, so that it is not serialized.
+    auto set = []() { return randomBelow(8) != 0; };
+    if (set()) message->set_system(randomCode());
+    if (set()) message->set_signal(randomCode());
+    if (set()) message->set_prn(static_cast<uint32_t>(randomVarint()));
+    if (set()) message->set_channel_id(static_cast<int32_t>(randomVarint()));
+    if (set()) message->set_acq_delay_samples(randomDouble());
+    if (set()) message->set_acq_doppler_hz(randomDouble());
+    if (set()) message->set_acq_samplestamp_samples(randomVarint());
+    if (set()) message->set_acq_doppler_step(static_cast<uint32_t>(randomVarint()));
+    if (set()) message->set_flag_valid_acquisition(randomBelow(2));
+    if (set()) message->set_fs(static_cast<int64_t>(randomVarint()));
+    if (set()) message->set_prompt_i(randomDouble());
+    if (set()) message->set_prompt_q(randomDouble());
+    if (set()) message->set_cn0_db_hz(randomDouble());
+    if (set()) message->set_carrier_doppler_hz(randomDouble());
+    if (set()) message->set_carrier_phase_rads(randomDouble());
+    if (set()) message->set_code_phase_samples(randomDouble());
+    if (set()) message->set_tracking_sample_counter(randomVarint());
+    if (set()) message->set_flag_valid_symbol_output(randomBelow(2));
+    if (set()) message->set_correlation_length_ms(static_cast<int32_t>(randomVarint()));
+    if (set()) message->set_flag_valid_word(randomBelow(2));
+    if (set()) message->set_tow_at_current_symbol_ms(static_cast<uint32_t>(randomVarint()));
+    if (set()) message->set_pseudorange_m(randomDouble());
+    if (set()) message->set_rx_time(randomDouble());
+    if (set()) message->set_flag_valid_pseudorange(randomBelow(2));
+    if (set()) message->set_interp_tow_ms(randomDouble());
+}
+
+void appendVarint(std::string *out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out->push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out->push_back(static_cast<char>(value));
+}
+
+/*!
+ Splits a serialized message into its fields, tag included. The input is
+ written by libprotobuf, so it is well formed and has no groups.
+ */
+std::vector<std::string> splitFields(const std::string &message)
+{
+    std::vector<std::string> fields;
+    size_t pos = 0;
+    while (pos < message.size())
+    {
+        size_t start = pos;
+        uint64_t tag = 0;
+        for (int shift = 0; message[pos] & 0x80; shift += 7)
+        {
+            tag |= static_cast<uint64_t>(message[pos++] & 0x7F) << shift;
+        }
+        tag |= static_cast<uint64_t>(message[pos] & 0x7F) << (7 * (pos - start));
+        pos++;
+
+        switch (tag & 7)
+        {
+        case 0:
+            while (message[pos++] & 0x80)
+            {
+            }
+            break;
+        case 1:
+            pos += 8;
+            break;
+        case 2:
+        {
+            uint64_t length = 0;
+            for (int shift = 0;; shift += 7)
+            {
+                uint8_t byte = static_cast<uint8_t>(message[pos++]);
+                length |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80))
+                {
+                    break;
+                }
+            }
+            pos += length;
+            break;
+        }
+        case 5:
+            pos += 4;
+            break;
+        }
+        fields.push_back(message.substr(start, pos - start));
+    }
+    return fields;
+}
+
+/*!
+ Returns a field that no version of the schema reads into a ChannelSample:
+ an unknown field number, or a known one with another wire type. Groups
+ hold up to \a depth levels of unknown fields.
+ */
+std::string unknownField(int depth = 2)
+{
+    std::string field;
+    uint64_t number = randomBelow(2) ? 26 + randomBelow(5000) : 1 + randomBelow(25);
+    std::vector<uint64_t> types = {0, 1, 2, 5};
+    if (depth > 0)
+    {
+        types.push_back(3);
+    }
+    uint64_t type = types[randomBelow(types.size())];
+    if (number <= 25)
+    {
+        // Any wire type but the declared one. Strings are the first two fields,
+        // 64-bit values the doubles and varints the rest.
+        bool isString = number <= 2;
+        bool isDouble = number == 5 || number == 6 || (number >= 11 && number <= 16) || number == 22 || number == 23 || number == 25;
+        uint64_t declared = isString ? 2 : (isDouble ? 1 : 0);
+        while (type == declared)
+        {
+            type = types[randomBelow(types.size())];
+        }
+    }
+    appendVarint(&field, (number << 3) | type);
+    switch (type)
+    {
+    case 0:
+        appendVarint(&field, randomVarint());
+        break;
+    case 1:
+        for (int i = 0; i < 8; i++) field.push_back(static_cast<char>(rng()));
+        break;
+    case 2:
+    {
+        size_t length = randomBelow(40);
+        appendVarint(&field, length);
+        for (size_t i = 0; i < length; i++) field.push_back(static_cast<char>(rng()));
+        break;
+    }
+    case 3:
+    {
+        size_t fields = randomBelow(3);
+        for (size_t i = 0; i < fields; i++) field += unknownField(depth - 1);
+        appendVarint(&field, (number << 3) | 4);
+        break;
+    }
+    case 5:
+        for (int i = 0; i < 4; i++) field.push_back(static_cast<char>(rng()));
+        break;
+    }
+    return field;
+}
+
+/*!
+ Re-encodes a serialized GnssSynchro with its fields shuffled, some of them
+ repeated with other values, and unknown fields in between. All of them are
+ valid encodings that libprotobuf accepts.
+ */
+std::string scramble(const std::string &message)
+{
+    std::vector<std::string> fields = splitFields(message);
+
+    if (randomBelow(2))
+    {
+        // The last occurrence of a repeated scalar field wins.
+        gnss_sdr::GnssSynchro other;
+        randomGnssSynchro(&other);
+        for (const std::string &field : splitFields(other.SerializeAsString()))
+        {
+            if (randomBelow(3) == 0)
+            {
+                fields.insert(fields.begin() + randomBelow(fields.size() + 1), field);
+            }
+        }
+    }
+    if (randomBelow(2))
+    {
+        std::shuffle(fields.begin(), fields.end(), rng);
+    }
+    size_t unknown = randomBelow(4);
+    for (size_t i = 0; i < unknown; i++)
+    {
+        fields.insert(fields.begin() + randomBelow(fields.size() + 1), unknownField());
+    }
+
+    std::string scrambled;
+    for (const std::string &field : fields)
+    {
+        scrambled += field;
+    }
+    return scrambled;
+}
+
+/*!
+ Builds a random Observables message, serialized as GNSS-SDR does or with
+ its fields scrambled.
+ */
+std::string randomObservables()
+{
+    size_t channels = randomBelow(5) == 0 ? 0 : randomBelow(100);
+    bool scrambled = randomBelow(2);
+    std::string observables;
+    for (size_t i = 0; i < channels; i++)
+    {
+        gnss_sdr::GnssSynchro message;
+        randomGnssSynchro(&message);
+        std::string channel = message.SerializeAsString();
+        if (scrambled)
+        {
+            channel = scramble(channel);
+            if (randomBelow(8) == 0)
+            {
+                observables += unknownField();
+            }
+        }
+        appendVarint(&observables, (1 << 3) | 2);
+        appendVarint(&observables, channel.size());
+        observables += channel;
+    }
+    return observables;
+}
+
+/*!
+ Flips, inserts or removes bytes of \a message, or truncates it.
+ */
+void mutate(std::string *message)
+{
+    size_t mutations = 1 + randomBelow(4);
+    for (size_t i = 0; i < mutations; i++)
+    {
+        size_t pos = message->empty() ? 0 : randomBelow(message->size());
+        switch (randomBelow(4))
+        {
+        case 0:
+            if (!message->empty()) (*message)[pos] = static_cast<char>(rng());
+            break;
+        case 1:
+            message->insert(message->begin() + pos, static_cast<char>(rng()));
+            break;
+        case 2:
+            if (!message->empty()) message->erase(message->begin() + pos);
+            break;
+        case 3:
+            message->resize(pos);
+            break;
+        }
+    }
+}
+
+bool sameBits(double a, double b)
+{
+    return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+uint16_t expectedCode(const std::string &text)
+{
+    return packGnssCode(text.size() > 0 ? text[0] : '\0', text.size() > 1 ? text[1] : '\0');
+}
+
+/*!
+ Returns the name of the first field where \a sample and \a message differ,
+ or nullptr if they are equal.
+ */
+const char *difference(const ChannelSample &sample, const gnss_sdr::GnssSynchro &message)
+{
+    if (sample.system != expectedCode(message.system())) return "system";
+    if (sample.signal != expectedCode(message.signal())) return "signal";
+    if (sample.prn != message.prn()) return "prn";
+    if (sample.channel_id != message.channel_id()) return "channel_id";
+    if (!sameBits(sample.acq_delay_samples, message.acq_delay_samples())) return "acq_delay_samples";
+    if (!sameBits(sample.acq_doppler_hz, message.acq_doppler_hz())) return "acq_doppler_hz";
+    if (sample.fs != message.fs()) return "fs";
+    if (!sameBits(sample.prompt_i, message.prompt_i())) return "prompt_i";
+    if (!sameBits(sample.prompt_q, message.prompt_q())) return "prompt_q";
+    if (!sameBits(sample.cn0_db_hz, message.cn0_db_hz())) return "cn0_db_hz";
+    if (!sameBits(sample.carrier_doppler_hz, message.carrier_doppler_hz())) return "carrier_doppler_hz";
+    if (sample.flag_valid_word != message.flag_valid_word()) return "flag_valid_word";
+    if (sample.tow_at_current_symbol_ms != message.tow_at_current_symbol_ms()) return "tow_at_current_symbol_ms";
+    if (!sameBits(sample.pseudorange_m, message.pseudorange_m())) return "pseudorange_m";
+    if (!sameBits(sample.rx_time, message.rx_time())) return "rx_time";
+    return nullptr;
+}
+
+/*!
+ Returns true if \a message is a well formed Observables message, whatever
+ the content of its strings.
+ */
+bool wellFormed(const std::string &message)
+{
+    google::protobuf::UnknownFieldSet observables;
+    if (!observables.ParseFromString(message))
+    {
+        return false;
+    }
+    for (int i = 0; i < observables.field_count(); i++)
+    {
+        const google::protobuf::UnknownField &field = observables.field(i);
+        google::protobuf::UnknownFieldSet channel;
+        if (field.number() == 1 && field.type() == google::protobuf::UnknownField::TYPE_LENGTH_DELIMITED &&
+            !channel.ParseFromString(field.length_delimited()))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void dump(const std::string &message)
+{
+    static const char *digits = "0123456789abcdef";
+    for (char c : message)
+    {
+        std::cerr << digits[(c >> 4) & 0xF] << digits[c & 0xF];
+    }
+    std::cerr << std::endl;
+}
+
+/*!
+ Times libprotobuf and the decoder on an epoch of FUZZ_BENCH_CHANNELS
+ channels, with every field set as GNSS-SDR sends it.
+ */
+void benchmark()
+{
+    gnss_sdr::Observables observables;
+    for (int i = 0; i < FUZZ_BENCH_CHANNELS; i++)
+    {
+        gnss_sdr::GnssSynchro *message = observables.add_observable();
+        message->set_system("G");
+        message->set_signal("1C");
+        message->set_prn(1 + i % 32);
+        message->set_channel_id(i);
+        message->set_acq_delay_samples(1234.5);
+        message->set_acq_doppler_hz(-2500);
+        message->set_acq_samplestamp_samples(123456789);
+        message->set_acq_doppler_step(250);
+        message->set_flag_valid_acquisition(true);
+        message->set_fs(4000000);
+        message->set_prompt_i(12345.6);
+        message->set_prompt_q(-78.9);
+        message->set_cn0_db_hz(44.1);
+        message->set_carrier_doppler_hz(-2456.7);
+        message->set_carrier_phase_rads(123.4);
+        message->set_code_phase_samples(0.25);
+        message->set_tracking_sample_counter(987654321);
+        message->set_flag_valid_symbol_output(true);
+        message->set_correlation_length_ms(1);
+        message->set_flag_valid_word(true);
+        message->set_tow_at_current_symbol_ms(345678000);
+        message->set_pseudorange_m(21345678.9);
+        message->set_rx_time(345678.07);
+        message->set_flag_valid_pseudorange(true);
+        message->set_interp_tow_ms(345678070.0);
+    }
+    std::string data = observables.SerializeAsString();
+
+    auto measure = [](const std::function<void()> &decode) {
+        // The best of several rounds, which is the least disturbed by the rest of the machine.
+        double best = 0;
+        for (int round = 0; round < FUZZ_BENCH_ROUNDS; round++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < FUZZ_BENCH_EPOCHS; i++)
+            {
+                decode();
+            }
+            double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / FUZZ_BENCH_EPOCHS;
+            best = round == 0 ? elapsed : std::min(best, elapsed);
+        }
+        return best;
+    };
+
+    // The monitor parsed each datagram into a member message that it reused,
+    // which is the baseline of the target. A new message per datagram is
+    // reported for comparison.
+    gnss_sdr::Observables reused;
+    double baseline = measure([&]() { reused.ParseFromArray(data.data(), static_cast<int>(data.size())); });
+    double fresh = measure([&]() {
+        gnss_sdr::Observables message;
+        message.ParseFromArray(data.data(), static_cast<int>(data.size()));
+    });
+    GnssSynchroEpoch epoch;
+    double decoder = measure([&]() { GnssSynchroDecoder::decodeObservables(data.data(), data.size(), &epoch); });
+
+    double speedup = baseline / decoder;
+    std::cout << "Epoch of " << FUZZ_BENCH_CHANNELS << " channels, " << data.size() << " bytes: decoder " << decoder
+              << " us, libprotobuf " << baseline << " us on a reused message (" << speedup << "x, "
+              << (speedup >= FUZZ_BENCH_TARGET_SPEEDUP ? "meets" : "below") << " the " << FUZZ_BENCH_TARGET_SPEEDUP
+              << "x target) and " << fresh << " us on a new one (" << fresh / decoder << "x)" << std::endl;
+}
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+    // Rejected messages are expected, do not log each of them.
+    google::protobuf::SetLogHandler(nullptr);
+
+    long iterations = argc > 1 ? std::atol(argv[1]) : 100000;
+    unsigned long long seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+    rng.seed(seed);
+
+    long equal = 0;
+    long rejectedByBoth = 0;
+    long acceptedByDecoderOnly = 0;
+    long failures = 0;
+    GnssSynchroEpoch epoch;
+    gnss_sdr::Observables reference;
+
+    for (long i = 0; i < iterations; i++)
+    {
+        std::string message = randomObservables();
+        if (i % 2)
+        {
+            mutate(&message);
+        }
+
+        bool referenceOk = reference.ParseFromArray(message.data(), static_cast<int>(message.size()));
+        bool decoderOk = GnssSynchroDecoder::decodeObservables(message.data(), message.size(), &epoch);
+        const char *field = nullptr;
+        if (!referenceOk && !decoderOk)
+        {
+            rejectedByBoth++;
+            continue;
+        }
+        if (!referenceOk)
+        {
+            // The decoder does not validate the UTF-8 of the codes, so it may
+            // accept what libprotobuf rejects, but only if it is well formed.
+            if (wellFormed(message))
+            {
+                acceptedByDecoderOnly++;
+                continue;
+            }
+            field = "the message, malformed but accepted by the decoder";
+        }
+        else if (!decoderOk)
+        {
+            field = "the message, rejected by the decoder";
+        }
+        else if (static_cast<int>(epoch.channels.size()) != reference.observable_size())
+        {
+            field = "the number of channels";
+        }
+        for (int j = 0; !field && j < reference.observable_size(); j++)
+        {
+            field = difference(epoch.channels[j], reference.observable(j));
+        }
+
+        if (field)
+        {
+            if (failures++ < 5)
+            {
+                std::cerr << "Iteration " << i << " differs in " << field << ":" << std::endl;
+                dump(message);
+            }
+            continue;
+        }
+        equal++;
+    }
+
+    std::cout << iterations << " messages (seed " << seed << "): " << equal << " decoded equal to libprotobuf, "
+              << rejectedByBoth << " rejected by both, " << acceptedByDecoderOnly << " accepted by the decoder only, "
+              << failures << " different" << std::endl;
+
+    benchmark();
+
+    google::protobuf::ShutdownProtobufLibrary();
+    return failures > 0 ? 1 : 0;
+}
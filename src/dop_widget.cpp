@@ -32,8 +32,6 @@
 
 
 #include "dop_widget.h"
-#include <QChart>
-#include <QGraphicsLayout>
 #include <QLayout>
 
 /*!
@@ -44,56 +42,24 @@ DOPWidget::DOPWidget(QWidget *parent) : QWidget(parent)
     // Default buffer size.
     m_bufferSize = 100;
 
-    m_gdopBuffer.resize(m_bufferSize);
-    m_gdopBuffer.clear();
-
-    m_pdopBuffer.resize(m_bufferSize);
-    m_pdopBuffer.clear();
-
-    m_hdopBuffer.resize(m_bufferSize);
-    m_hdopBuffer.clear();
-
-    m_vdopBuffer.resize(m_bufferSize);
-    m_vdopBuffer.clear();
-
-    m_gdopSeries = new QtCharts::QLineSeries();
-    m_gdopSeries->setName("GDOP");
+    m_gdopBuffer.setCapacity(m_bufferSize);
+    m_pdopBuffer.setCapacity(m_bufferSize);
+    m_hdopBuffer.setCapacity(m_bufferSize);
+    m_vdopBuffer.setCapacity(m_bufferSize);
+
+    // The vertical axis spans the range of all four series.
+    m_plot = new PlotWidget(this);
+    m_plot->setTitle("DOP vs Time");
+    m_plot->setAxisTitles("TOW [s]", "DOP");
+    m_plot->setLegendVisible(true);
+    m_plot->addSeries("GDOP", [this](const PlotWidget::Viewport &) { return m_gdopBuffer.view(); });
+    m_plot->addSeries("PDOP", [this](const PlotWidget::Viewport &) { return m_pdopBuffer.view(); });
+    m_plot->addSeries("HDOP", [this](const PlotWidget::Viewport &) { return m_hdopBuffer.view(); });
+    m_plot->addSeries("VDOP", [this](const PlotWidget::Viewport &) { return m_vdopBuffer.view(); });
 
-    m_pdopSeries = new QtCharts::QLineSeries();
-    m_pdopSeries->setName("PDOP");
-
-    m_hdopSeries = new QtCharts::QLineSeries();
-    m_hdopSeries->setName("HDOP");
-
-    m_vdopSeries = new QtCharts::QLineSeries();
-    m_vdopSeries->setName("VDOP");
-
-    m_chartView = new QtCharts::QChartView(this);
     QVBoxLayout *layout = new QVBoxLayout(this);
     this->setLayout(layout);
-    layout->addWidget(m_chartView);
-
-    QtCharts::QChart *chart = m_chartView->chart();
-    chart->addSeries(m_gdopSeries);
-    chart->addSeries(m_pdopSeries);
-    chart->addSeries(m_hdopSeries);
-    chart->addSeries(m_vdopSeries);
-
-    chart->setTitle("DOP vs Time");
-    chart->createDefaultAxes();
-    chart->axes(Qt::Horizontal).back()->setTitleText("TOW [s]");
-    chart->axes(Qt::Vertical).back()->setTitleText("DOP");
-    chart->layout()->setContentsMargins(0, 0, 0, 0);
-    chart->setContentsMargins(-18, -18, -14, -16);
-
-    m_chartView->setRenderHint(QPainter::Antialiasing);
-    m_chartView->setContentsMargins(0, 0, 0, 0);
-
-    min_x = std::numeric_limits<double>::max();
-    max_x = -std::numeric_limits<double>::max();
-
-    min_y = std::numeric_limits<double>::max();
-    max_y = -std::numeric_limits<double>::max();
+    layout->addWidget(m_plot);
 }
 
 /*!
@@ -101,21 +67,18 @@ DOPWidget::DOPWidget(QWidget *parent) : QWidget(parent)
  */
 void DOPWidget::addData(qreal tow, qreal gdop, qreal pdop, qreal hdop, qreal vdop)
 {
-    m_gdopBuffer.push_back(QPointF(tow, gdop));
-    m_pdopBuffer.push_back(QPointF(tow, pdop));
-    m_hdopBuffer.push_back(QPointF(tow, hdop));
-    m_vdopBuffer.push_back(QPointF(tow, vdop));
+    m_gdopBuffer.append(tow, gdop);
+    m_pdopBuffer.append(tow, pdop);
+    m_hdopBuffer.append(tow, hdop);
+    m_vdopBuffer.append(tow, vdop);
 }
 
 /*!
- Redraws the chart by calling populateSeries() on all series objects.
+ Repaints the plot if data was added since the last redraw. The plot reads the buffers in place.
  */
 void DOPWidget::redraw()
 {
-    populateSeries(m_gdopBuffer, m_gdopSeries);
-    populateSeries(m_pdopBuffer, m_pdopSeries);
-    populateSeries(m_hdopBuffer, m_hdopSeries);
-    populateSeries(m_vdopBuffer, m_vdopSeries);
+    m_plot->refresh();
 }
 
 /*!
@@ -128,59 +91,32 @@ void DOPWidget::clear()
     m_hdopBuffer.clear();
     m_vdopBuffer.clear();
 
-    m_gdopSeries->clear();
-    m_pdopSeries->clear();
-    m_hdopSeries->clear();
-    m_vdopSeries->clear();
+    m_plot->refresh();
 }
 
 /*!
- Sets the size of the internal circular buffers that store the widget's data.
+ Returns the number of bytes allocated by the widget's internal data structures.
  */
-void DOPWidget::setBufferSize(size_t size)
+size_t DOPWidget::memoryUsage() const
 {
-    m_bufferSize = size;
-
-    m_gdopBuffer.resize(m_bufferSize);
-    m_pdopBuffer.resize(m_bufferSize);
-    m_hdopBuffer.resize(m_bufferSize);
-    m_vdopBuffer.resize(m_bufferSize);
+    return m_gdopBuffer.memoryUsage() + m_pdopBuffer.memoryUsage() + m_hdopBuffer.memoryUsage() + m_vdopBuffer.memoryUsage();
 }
 
 /*!
- Replaces the old data in the \a series object with the new data from the \a buffer, casuing the chart to repaint.
+ Sets the size of the internal circular buffers that store the widget's data.
  */
-void DOPWidget::populateSeries(boost::circular_buffer<QPointF> buffer, QtCharts::QLineSeries *series)
+void DOPWidget::setBufferSize(size_t size)
 {
-    if (!buffer.empty())
+    if (size == m_bufferSize)
     {
-        double min_x = std::numeric_limits<double>::max();
-        double max_x = -std::numeric_limits<double>::max();
-
-        /*
-        double min_y = std::numeric_limits<double>::max();
-        double max_y = -std::numeric_limits<double>::max();
-        */
-
-        QtCharts::QChart *chart = m_chartView->chart();
-        QPointF p;
-        QVector<QPointF> vec;
-
-        for (size_t i = 0; i < buffer.size(); i++)
-        {
-            p = buffer.at(i);
-            vec << p;
-
-            min_x = std::min(min_x, p.x());
-            min_y = std::min(min_y, p.y());
-
-            max_x = std::max(max_x, p.x());
-            max_y = std::max(max_y, p.y());
-        }
+        return;
+    }
+    m_bufferSize = size;
 
-        series->replace(vec);
+    m_gdopBuffer.setCapacity(m_bufferSize);
+    m_pdopBuffer.setCapacity(m_bufferSize);
+    m_hdopBuffer.setCapacity(m_bufferSize);
+    m_vdopBuffer.setCapacity(m_bufferSize);
 
-        chart->axes(Qt::Horizontal).back()->setRange(min_x, max_x);
-        chart->axes(Qt::Vertical).back()->setRange(min_y, max_y);
-    }
+    m_plot->refresh();
 }
@@ -34,9 +34,8 @@
 #ifndef GNSS_SDR_MONITOR_DOP_WIDGET_H_
 #define GNSS_SDR_MONITOR_DOP_WIDGET_H_
 
-#include <boost/circular_buffer.hpp>
-#include <QChartView>
-#include <QLineSeries>
+#include "plot_widget.h"
+#include "series_buffer.h"
 #include <QWidget>
 
 class DOPWidget : public QWidget
@@ -46,6 +45,8 @@ class DOPWidget : public QWidget
 public:
     explicit DOPWidget(QWidget *parent = nullptr);
 
+    size_t memoryUsage() const;
+
 public slots:
     void addData(qreal tow, qreal gdop, qreal pdop, qreal hdop, qreal vdop);
     void redraw();
@@ -53,27 +54,14 @@ public slots:
     void setBufferSize(size_t size);
 
 private:
-    void populateSeries(boost::circular_buffer<QPointF> queue, QtCharts::QLineSeries *series);
-
     size_t m_bufferSize;
 
-    boost::circular_buffer<QPointF> m_gdopBuffer;
-    boost::circular_buffer<QPointF> m_pdopBuffer;
-    boost::circular_buffer<QPointF> m_hdopBuffer;
-    boost::circular_buffer<QPointF> m_vdopBuffer;
-
-    QtCharts::QChartView *m_chartView = nullptr;
-
-    QtCharts::QLineSeries *m_gdopSeries = nullptr;
-    QtCharts::QLineSeries *m_pdopSeries = nullptr;
-    QtCharts::QLineSeries *m_hdopSeries = nullptr;
-    QtCharts::QLineSeries *m_vdopSeries = nullptr;
-
-    double min_x;
-    double min_y;
+    SeriesBuffer m_gdopBuffer;
+    SeriesBuffer m_pdopBuffer;
+    SeriesBuffer m_hdopBuffer;
+    SeriesBuffer m_vdopBuffer;
 
-    double max_x;
-    double max_y;
+    PlotWidget *m_plot = nullptr;
 };
 
 #endif  // GNSS_SDR_MONITOR_DOP_WIDGET_H_
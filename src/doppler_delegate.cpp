@@ -32,9 +32,12 @@
 
 
 #include "doppler_delegate.h"
+#include "channel_table_model.h"
+#include "series_decimator.h"
 #include <QApplication>
 #include <QDebug>
 #include <QPainter>
+#include <algorithm>
 #include <limits>
 
 #define SPARKLINE_MIN_EM_WIDTH 10
@@ -52,21 +55,44 @@ DopplerDelegate::~DopplerDelegate()
 void DopplerDelegate::setBufferSize(int size)
 {
     m_bufferSize = size;
+    m_cache.clear();
 }
 
 void DopplerDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
     const QModelIndex &index) const
 {
-    QList<QPointF> points;
-    QVector<double> x_data, y_data;
-    QList<QVariant> var = index.data(Qt::DisplayRole).toList();
-    for (int i = 0; i < var.size(); i++)
+    QStyledItemDelegate::paint(painter, option, index);
+
+    // The samples are read in place from the model's history.
+    const SeriesView *series = index.data(ChannelTableModel::SeriesRole).value<const SeriesView *>();
+    if (!series || series->empty() || option.rect.isEmpty())
     {
-        points << var.at(i).toPointF();
-        x_data << var.at(i).toPointF().x();
-        y_data << var.at(i).toPointF().y();
+        return;
     }
 
+    // Blit the last rendering of this channel. A newer one is rendered on the
+    // thread pool when the data changes.
+    m_cache.setModel(index.model());
+    SparklineCache::Key key = SparklineCache::makeKey(*series, index, option, painter->device()->devicePixelRatioF());
+
+    QStyleOptionViewItem cellOption = option;
+    initStyleOption(&cellOption, index);
+    SparklineCache::prepareOption(&cellOption);
+
+    QPixmap pixmap = m_cache.pixmap(key, *series, static_cast<size_t>(std::max(m_bufferSize, 0)), option.widget,
+        [cellOption, bufferSize = m_bufferSize](QPainter *pixmapPainter, const SeriesView &samples) {
+            drawSparkline(pixmapPainter, cellOption, samples, bufferSize);
+        });
+    painter->drawPixmap(option.rect.topLeft(), pixmap);
+}
+
+/*!
+ Draws the sparkline of \a series in the cell described by \a option, which
+ is at the origin and already styled. It may run on a worker thread.
+ */
+void DopplerDelegate::drawSparkline(QPainter *painter, const QStyleOptionViewItem &option,
+    const SeriesView &series, int bufferSize)
+{
     double min_x = std::numeric_limits<double>::max();
     double max_x = -std::numeric_limits<double>::max();
 
@@ -102,79 +128,54 @@ void DopplerDelegate::paint(QPainter *painter, const QStyleOptionViewItem &optio
     QRect sparklineRect = QRect(sparklineOrigin, QSize(sparklineWidth, contentHeight));
     QRect textRect = QRect(textOrigin, QSize(textWidth, contentHeight));
 
-    QPointF val;
     QVector<QPointF> fpoints;
-    QStyledItemDelegate::paint(painter, option, index);
 
-    if (points.isEmpty() || m_bufferSize < 1.0 || contentHeight <= 0)
+    if (series.empty() || bufferSize < 1.0 || contentHeight <= 0)
     {
         return;
     }
 
-    while (points.length() > m_bufferSize)
-    {
-        points.removeFirst();
-    }
+    size_t first = series.size() > static_cast<size_t>(bufferSize) ? series.size() - bufferSize : 0;
 
-    foreach (val, points)
-    {
-        if (val.x() < min_x)
-        {
-            min_x = val.x();
-        }
-
-        if (val.x() > max_x)
-        {
-            max_x = val.x();
-        }
-
-        if (val.y() < min_y)
-        {
-            min_y = val.y();
-        }
-
-        if (val.y() > max_y)
-        {
-            max_y = val.y();
-        }
-    }
+    size_t count = series.size() - first;
 
-    foreach (val, points)
-    {
-        double x = sparklineWidth * (val.x() - min_x) / (max_x - min_x);
-        double y = contentHeight - (contentHeight * (val.y() - min_y) / (max_y - min_y));
-        fpoints.append(QPointF(x, y));
-    }
+    min_x = series.x.minimum(count);
+    max_x = series.x.maximum(count);
 
-    QStyleOptionViewItem option_vi = option;
-    QStyledItemDelegate::initStyleOption(&option_vi, index);
+    min_y = series.y.minimum(count);
+    max_y = series.y.maximum(count);
 
-    painter->save();
+    // Only the samples that shape the line in each pixel column are drawn.
+    std::vector<size_t> indices;
+    SeriesDecimator::m4(series, first, series.size(), min_x, max_x, sparklineWidth, &indices);
 
-    if (QApplication::style()->objectName().contains("vista"))
+    fpoints.reserve(indices.size() + 2);
+    for (size_t i : indices)
     {
-        // QWindowsVistaStyle::drawControl does this internally. Unfortunately there
-        // doesn't appear to be a more general way to do this.
-        option_vi.palette.setColor(QPalette::All, QPalette::HighlightedText, option_vi.palette.color(QPalette::Active, QPalette::Text));
+        double x = sparklineWidth * (series.x[i] - min_x) / (max_x - min_x);
+        double y = contentHeight - (contentHeight * (series.y[i] - min_y) / (max_y - min_y));
+        fpoints.append(QPointF(x, y));
     }
 
-    QPalette::ColorGroup cg = option_vi.state & QStyle::State_Enabled
+    painter->save();
+
+    QPalette::ColorGroup cg = option.state & QStyle::State_Enabled
                                   ? QPalette::Normal
                                   : QPalette::Disabled;
-    if (cg == QPalette::Normal && !(option_vi.state & QStyle::State_Active))
+    if (cg == QPalette::Normal && !(option.state & QStyle::State_Active))
         cg = QPalette::Inactive;
 #if defined(Q_OS_WIN)
-    if (option_vi.state & QStyle::State_Selected)
+    if (option.state & QStyle::State_Selected)
     {
 #else
-    if ((option_vi.state & QStyle::State_Selected) && !(option_vi.state & QStyle::State_MouseOver))
+    if ((option.state & QStyle::State_Selected) && !(option.state & QStyle::State_MouseOver))
     {
 #endif
-        painter->setPen(option_vi.palette.color(cg, QPalette::HighlightedText));
+        painter->setPen(option.palette.color(cg, QPalette::HighlightedText));
     }
     else
     {
-        painter->setPen(option_vi.palette.color(cg, QPalette::Text));
+        painter->setPen(option.palette.color(cg, QPalette::Text));
     }
 
     // Enable antialiasing.
@@ -207,7 +208,7 @@ void DopplerDelegate::paint(QPainter *painter, const QStyleOptionViewItem &optio
     painter->translate(-hGap, -vGap);
 
     // Display value of the last Doppler sample next to the sparkline.
-    painter->drawText(textRect, QString::number(var.last().toPointF().y(), 'f', 1));
+    painter->drawText(textRect, QString::number(series.y.back(), 'f', 1));
 
     // Draw visual guides for debugging.
     //drawGuides(painter, cellRect, sparklineRect, textRect);
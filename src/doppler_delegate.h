@@ -34,6 +34,7 @@
 #ifndef GNSS_SDR_MONITOR_DOPPLER_DELEGATE_H_
 #define GNSS_SDR_MONITOR_DOPPLER_DELEGATE_H_
 
+#include "sparkline_cache.h"
 #include <QStyledItemDelegate>
 
 class DopplerDelegate : public QStyledItemDelegate
@@ -53,9 +54,13 @@ protected:
         const QModelIndex &index) const;
 
 private:
+    static void drawSparkline(QPainter *painter, const QStyleOptionViewItem &option,
+        const SeriesView &series, int bufferSize);
     void drawGuides(QPainter *painter, QRect cellRect, QRect sparklineRect, QRect textRect) const;
 
     int m_bufferSize;
+
+    mutable SparklineCache m_cache;
 };
 
 #endif  // GNSS_SDR_MONITOR_DOPPLER_DELEGATE_H_
@@ -0,0 +1,121 @@
+/*!
+ * \file extrema_bench.cpp
+ * \brief Times the range step of a plot, reading the minimum and maximum of
+ * the newest samples, with SlidingExtrema and with a full rescan.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "channel_history_store.h"
+#include "sliding_extrema.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Steps timed per buffer size, and the rounds of the timing.
+#define EXTREMA_BENCH_STEPS 2000
+#define EXTREMA_BENCH_ROUNDS 5
+
+namespace
+{
+/*!
+ Returns the best time, in microseconds per step, over several rounds of \a
+ steps calls of \a step each.
+ */
+double measure(const std::function<void()> &step, int steps)
+{
+    double best = 0;
+    for (int round = 0; round < EXTREMA_BENCH_ROUNDS; round++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < steps; i++)
+        {
+            step();
+        }
+        double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / steps;
+        best = round == 0 ? elapsed : std::min(best, elapsed);
+    }
+    return best;
+}
+
+/*!
+ Times a step of a plot of \a size samples, appending one sample and reading
+ the range of the whole buffer and of its newest half, as a plot that follows
+ the latest samples does. \a next generates the samples. The extrema are
+ updated in both cases, so the difference is the cost of the range reads.
+ */
+void benchmark(size_t size, const char *name, const std::function<double()> &next)
+{
+    std::vector<double> ring(size);
+    SlidingExtrema<double> extrema(size);
+    size_t head = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        ring[i] = next();
+        extrema.push(ring[i]);
+    }
+
+    volatile double sink = 0;
+    auto append = [&]() {
+        ring[head] = next();
+        extrema.push(ring[head]);
+        head = head + 1 == size ? 0 : head + 1;
+    };
+
+    // The views a plot reads, with the extrema kept up to date and without,
+    // in which case RingView scans the samples.
+    auto step = [&](const SlidingExtrema<double> *range) {
+        append();
+        RingView view(ring.data() + head, size - head, ring.data(), head, range);
+        sink = view.minimum() + view.maximum() + view.minimum(size / 2) + view.maximum(size / 2);
+    };
+    double incremental = measure([&]() { step(&extrema); }, EXTREMA_BENCH_STEPS);
+    double rescan = measure([&]() { step(nullptr); }, size >= 100000 ? EXTREMA_BENCH_STEPS / 20 : EXTREMA_BENCH_STEPS);
+
+    std::cout << size << " samples, " << name << ": " << incremental << " us incremental, " << rescan << " us rescan ("
+              << rescan / incremental << "x), extrema " << extrema.memoryUsage() / 1024 << " KiB" << std::endl;
+}
+}  // namespace
+
+int main()
+{
+    std::mt19937_64 rng(1);
+    std::normal_distribution<double> noise(0.0, 0.5);
+    for (size_t size : {1000, 10000, 100000, 1000000})
+    {
+        // A C/N0 around 45 dB-Hz, and a Doppler drifting steadily, whose
+        // monotonic run keeps the whole window in one deque.
+        double cn0 = 45;
+        benchmark(size, "noisy", [&]() { return cn0 + noise(rng); });
+        double doppler = -2500;
+        benchmark(size, "drifting", [&]() { return doppler += 0.01; });
+    }
+    return 0;
+}
@@ -0,0 +1,476 @@
+/*!
+ * \file flight_recorder.cpp
+ * \brief Implementation of a recorder of the raw datagrams received, in an
+ * append-only log of memory-mapped segments.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "flight_recorder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#if defined(Q_OS_UNIX)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Segment and record headers, in bytes. Records are aligned to 8 bytes.
+#define FLIGHT_SEGMENT_HEADER_SIZE 16
+#define FLIGHT_RECORD_HEADER_SIZE 16
+#define FLIGHT_RECORD_ALIGNMENT 8
+#define FLIGHT_MAGIC "FLIGHTR1"
+
+// The written part of the current segment is synced at least this often,
+// and sooner once this many bytes are pending.
+#define FLIGHT_SYNC_INTERVAL_MS 500
+#define FLIGHT_SYNC_BYTES (4 * 1024 * 1024)
+
+FlightRecorder::FlightRecorder() : m_segmentSize(0), m_sequence(0), m_current(nullptr), m_spare(nullptr),
+                                   m_spareWanted(false), m_syncWanted(false), m_stopping(false), m_notifiedAt(0)
+{
+    m_recorded = 0;
+    m_dropped = 0;
+    m_bytes = 0;
+    m_segments = 0;
+    m_syncs = 0;
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    close();
+}
+
+/*!
+ Starts recording to segments of \a segmentSize bytes in \a directory, which
+ must exist. The first segment and the spare are created before returning.
+ */
+bool FlightRecorder::open(const std::string &directory, size_t segmentSize)
+{
+    close();
+
+    m_directory = directory;
+    m_segmentSize = std::max<size_t>(segmentSize, 1024 * 1024);
+    m_error.clear();
+    m_recorded = 0;
+    m_dropped = 0;
+    m_bytes = 0;
+    m_segments = 0;
+    m_syncs = 0;
+
+    m_current = createSegment();
+    m_spare = m_current ? createSegment() : nullptr;
+    if (!m_spare)
+    {
+        finishSegment(m_current);
+        m_current = nullptr;
+        return false;
+    }
+
+    m_stopping = false;
+    m_spareWanted = false;
+    m_syncWanted = false;
+    m_notifiedAt = 0;
+    m_thread = std::thread(&FlightRecorder::run, this);
+    return true;
+}
+
+/*!
+ Stops recording. The segments are synced and truncated to their content
+ before returning, which may take as long as a sync.
+ */
+void FlightRecorder::close()
+{
+    if (!m_thread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_retired.push_back(m_current);
+        m_retired.push_back(m_spare);
+        m_current = nullptr;
+        m_spare = nullptr;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+bool FlightRecorder::isOpen() const
+{
+    return m_current != nullptr;
+}
+
+/*!
+ Appends the datagram of \a length bytes at \a data, received at
+ \a receiveTime on \a stream. Returns false if it was dropped because the
+ next segment was not ready or it does not fit in a segment.
+ */
+bool FlightRecorder::record(Stream stream, qint64 receiveTime, const char *data, int length)
+{
+    if (!m_current || length < 0)
+    {
+        return false;
+    }
+
+    size_t padded = (static_cast<size_t>(length) + FLIGHT_RECORD_ALIGNMENT - 1) & ~static_cast<size_t>(FLIGHT_RECORD_ALIGNMENT - 1);
+    size_t needed = FLIGHT_RECORD_HEADER_SIZE + padded;
+    if (needed > m_segmentSize - FLIGHT_SEGMENT_HEADER_SIZE)
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    size_t used = m_current->used.load(std::memory_order_relaxed);
+    if (used + needed > m_current->size)
+    {
+        // Rotate to the spare segment, without waiting for one.
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_spareWanted = true;
+            if (m_spare)
+            {
+                m_retired.push_back(m_current);
+                m_current = m_spare;
+                m_spare = nullptr;
+            }
+        }
+        m_wake.notify_one();
+        m_notifiedAt = FLIGHT_SEGMENT_HEADER_SIZE;
+
+        used = m_current->used.load(std::memory_order_relaxed);
+        if (used + needed > m_current->size)
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    char *header = m_current->data + used;
+    quint16 streamId = static_cast<quint16>(stream);
+    quint16 reserved = 0;
+    std::memcpy(header + 4, &streamId, sizeof(streamId));
+    std::memcpy(header + 6, &reserved, sizeof(reserved));
+    std::memcpy(header + 8, &receiveTime, sizeof(receiveTime));
+    std::memcpy(header + FLIGHT_RECORD_HEADER_SIZE, data, static_cast<size_t>(length));
+
+    // The length goes last, so that a record is complete once it is nonzero.
+    // Empty datagrams are recorded with the high bit set.
+    quint32 storedLength = length > 0 ? static_cast<quint32>(length) : 0x80000000u;
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header, &storedLength, sizeof(storedLength));
+    m_current->used.store(used + needed, std::memory_order_release);
+
+    m_recorded.fetch_add(1, std::memory_order_relaxed);
+    m_bytes.fetch_add(needed, std::memory_order_relaxed);
+
+    if (used + needed - m_notifiedAt >= FLIGHT_SYNC_BYTES)
+    {
+        m_notifiedAt = used + needed;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_syncWanted = true;
+        }
+        m_wake.notify_one();
+    }
+    return true;
+}
+
+/*!
+ Returns the number of datagrams recorded and dropped since the recorder
+ was opened, and the work of the sync thread. Safe to call from any thread.
+ */
+FlightRecorder::Statistics FlightRecorder::statistics() const
+{
+    Statistics stats;
+    stats.recorded = m_recorded.load(std::memory_order_relaxed);
+    stats.dropped = m_dropped.load(std::memory_order_relaxed);
+    stats.bytes = m_bytes.load(std::memory_order_relaxed);
+    stats.segments = m_segments.load(std::memory_order_relaxed);
+    stats.syncs = m_syncs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+/*!
+ Returns the last error of the recorder, or an empty string.
+ */
+std::string FlightRecorder::error() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_error;
+}
+
+/*!
+ Returns the current time in nanoseconds since the epoch, the receive time
+ of the records.
+ */
+qint64 FlightRecorder::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/*!
+ Calls \a callback for each record of the segment at \a path, in order.
+ Returns false if the file is not a segment.
+ */
+bool FlightRecorder::readSegment(const std::string &path, const std::function<void(const Record &)> &callback)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (content.size() < FLIGHT_SEGMENT_HEADER_SIZE || std::memcmp(content.data(), FLIGHT_MAGIC, 8) != 0)
+    {
+        return false;
+    }
+
+    size_t offset = FLIGHT_SEGMENT_HEADER_SIZE;
+    while (offset + FLIGHT_RECORD_HEADER_SIZE <= content.size())
+    {
+        const char *header = content.data() + offset;
+        quint32 storedLength = 0;
+        quint16 stream = 0;
+        Record record;
+        std::memcpy(&storedLength, header, sizeof(storedLength));
+        std::memcpy(&stream, header + 4, sizeof(stream));
+        std::memcpy(&record.receiveTime, header + 8, sizeof(record.receiveTime));
+        if (storedLength == 0)
+        {
+            break;
+        }
+        record.length = storedLength == 0x80000000u ? 0 : storedLength;
+        size_t padded = (record.length + FLIGHT_RECORD_ALIGNMENT - 1) & ~static_cast<size_t>(FLIGHT_RECORD_ALIGNMENT - 1);
+        if (offset + FLIGHT_RECORD_HEADER_SIZE + padded > content.size())
+        {
+            break;
+        }
+        record.stream = stream;
+        record.data = header + FLIGHT_RECORD_HEADER_SIZE;
+        callback(record);
+        offset += FLIGHT_RECORD_HEADER_SIZE + padded;
+    }
+    return true;
+}
+
+#if defined(Q_OS_UNIX)
+
+/*!
+ Creates, allocates and maps the next segment file, and writes its header.
+ */
+FlightRecorder::Segment *FlightRecorder::createSegment()
+{
+    qint64 created = now();
+    char name[64];
+    std::snprintf(name, sizeof(name), "/flight-%010lld-%06llu.rec",
+        static_cast<long long>(created / 1000000000), static_cast<unsigned long long>(m_sequence++));
+    std::string path = m_directory + name;
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        setError("Cannot create " + path + ": " + std::strerror(errno));
+        return nullptr;
+    }
+
+    // Allocating the blocks now keeps the writes to the mapping from doing it.
+    int result = ::posix_fallocate(fd, 0, static_cast<off_t>(m_segmentSize));
+    if (result != 0 && ::ftruncate(fd, static_cast<off_t>(m_segmentSize)) != 0)
+    {
+        setError("Cannot allocate " + path + ": " + std::strerror(result));
+        ::close(fd);
+        ::unlink(path.c_str());
+        return nullptr;
+    }
+
+    void *data = ::mmap(nullptr, m_segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        setError("Cannot map " + path + ": " + std::strerror(errno));
+        ::close(fd);
+        ::unlink(path.c_str());
+        return nullptr;
+    }
+
+    Segment *segment = new Segment;
+    segment->fd = fd;
+    segment->data = static_cast<char *>(data);
+    segment->size = m_segmentSize;
+    segment->synced = 0;
+    segment->path = path;
+    std::memcpy(segment->data, FLIGHT_MAGIC, 8);
+    std::memcpy(segment->data + 8, &created, sizeof(created));
+    segment->used = FLIGHT_SEGMENT_HEADER_SIZE;
+
+    // Make the new name durable too.
+    int directory = ::open(m_directory.c_str(), O_RDONLY | O_CLOEXEC);
+    if (directory >= 0)
+    {
+        ::fsync(directory);
+        ::close(directory);
+    }
+
+    m_segments.fetch_add(1, std::memory_order_relaxed);
+    return segment;
+}
+
+/*!
+ Writes the part of \a segment recorded since the last sync to disk. Unless
+ \a all is set, the page being written is left for later: writing to a page
+ under writeback may wait for it, which would stall the recording thread.
+ */
+void FlightRecorder::syncSegment(Segment *segment, bool all)
+{
+    size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t used = segment->used.load(std::memory_order_acquire);
+    if (!all)
+    {
+        used = used / page * page;
+    }
+    if (used <= segment->synced)
+    {
+        return;
+    }
+
+    size_t first = segment->synced / page * page;
+    if (::msync(segment->data + first, used - first, MS_SYNC) != 0)
+    {
+        setError("Cannot sync " + segment->path + ": " + std::strerror(errno));
+        return;
+    }
+    segment->synced = used;
+    m_syncs.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*!
+ Syncs, unmaps and truncates \a segment to its content, and deletes it if
+ it has no records.
+ */
+void FlightRecorder::finishSegment(Segment *segment)
+{
+    if (!segment)
+    {
+        return;
+    }
+
+    syncSegment(segment, true);
+    size_t used = segment->used.load(std::memory_order_acquire);
+    ::munmap(segment->data, segment->size);
+    if (used == FLIGHT_SEGMENT_HEADER_SIZE)
+    {
+        ::unlink(segment->path.c_str());
+    }
+    else if (::ftruncate(segment->fd, static_cast<off_t>(used)) != 0 || ::fsync(segment->fd) != 0)
+    {
+        setError("Cannot close " + segment->path + ": " + std::strerror(errno));
+    }
+    ::close(segment->fd);
+    delete segment;
+}
+
+#else
+
+FlightRecorder::Segment *FlightRecorder::createSegment()
+{
+    setError("Recording is not supported on this platform");
+    return nullptr;
+}
+
+void FlightRecorder::syncSegment(Segment *, bool)
+{
+}
+
+void FlightRecorder::finishSegment(Segment *segment)
+{
+    delete segment;
+}
+
+#endif
+
+void FlightRecorder::setError(const std::string &error)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_error = error;
+}
+
+/*!
+ Body of the sync thread. The disk is only touched outside the mutex, so the
+ recording thread never waits for it.
+ */
+void FlightRecorder::run()
+{
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait_for(lock, std::chrono::milliseconds(FLIGHT_SYNC_INTERVAL_MS), [this]() {
+            return m_stopping || m_syncWanted || !m_retired.empty() || (m_spareWanted && !m_spare);
+        });
+        bool stopping = m_stopping;
+        std::vector<Segment *> retired;
+        retired.swap(m_retired);
+        Segment *current = m_current;
+        bool spareWanted = m_spareWanted && !m_spare && !stopping;
+        m_spareWanted = false;
+        m_syncWanted = false;
+        lock.unlock();
+
+        // The spare goes first, since the recording thread may be waiting
+        // for it, dropping datagrams meanwhile.
+        if (spareWanted)
+        {
+            Segment *spare = createSegment();
+            lock.lock();
+            if (m_stopping)
+            {
+                // Closed meanwhile, so it is finished on the next turn.
+                m_retired.push_back(spare);
+            }
+            else
+            {
+                m_spare = spare;
+            }
+            lock.unlock();
+        }
+        if (current)
+        {
+            syncSegment(current, false);
+        }
+        for (Segment *segment : retired)
+        {
+            finishSegment(segment);
+        }
+        if (stopping)
+        {
+            return;
+        }
+    }
+}
@@ -0,0 +1,150 @@
+/*!
+ * \file flight_recorder.h
+ * \brief Interface of a recorder of the raw datagrams received, in an
+ * append-only log of memory-mapped segments.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#ifndef GNSS_SDR_MONITOR_FLIGHT_RECORDER_H_
+#define GNSS_SDR_MONITOR_FLIGHT_RECORDER_H_
+
+#include <QtGlobal>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*!
+ Appends every datagram it is given, with its receive time and stream, to a
+ log of fixed-size segment files. Segments are allocated up front and mapped
+ in memory, so recording a datagram is a copy into the mapping and never
+ waits for the disk.
+
+ A background thread syncs the written part of the current segment to disk
+ periodically. It also closes the full segments, truncating them to their
+ content, and prepares the next one ahead of time, so that rotating is a
+ pointer swap. If the next segment is not ready in time, the datagram is
+ dropped and counted rather than waited for.
+
+ Segments are named flight-<seconds>-<sequence>.rec. Each one starts with
+ a 16 byte header, the magic FLIGHTR1 and its creation time in nanoseconds.
+ It is followed by records of a 16 byte header and the datagram padded to
+ 8 bytes. A record header holds the length, the stream, 2 reserved bytes
+ and the receive time in nanoseconds since the epoch, all native endian.
+ The length is written last, so a reader stops at the first record with a
+ zero length, which is also where an unclosed segment ends.
+
+ record() may only be called from one thread, the one that opens and closes
+ the recorder.
+ */
+class FlightRecorder
+{
+public:
+    enum Stream
+    {
+        GnssSynchroStream = 1,
+        MonitorPvtStream = 2
+    };
+
+    struct Statistics
+    {
+        quint64 recorded;
+        quint64 dropped;
+        quint64 bytes;
+        quint64 segments;
+        quint64 syncs;
+    };
+
+    struct Record
+    {
+        int stream;
+        qint64 receiveTime;
+        const char *data;
+        quint32 length;
+    };
+
+    FlightRecorder();
+    ~FlightRecorder();
+
+    bool open(const std::string &directory, size_t segmentSize);
+    void close();
+    bool isOpen() const;
+
+    bool record(Stream stream, qint64 receiveTime, const char *data, int length);
+
+    Statistics statistics() const;
+    std::string error() const;
+
+    static qint64 now();
+    static bool readSegment(const std::string &path, const std::function<void(const Record &)> &callback);
+
+private:
+    struct Segment
+    {
+        int fd;
+        char *data;
+        size_t size;
+        std::atomic<size_t> used;  // Written by the recording thread.
+        size_t synced;             // Read and written by the sync thread.
+        std::string path;
+    };
+
+    Segment *createSegment();
+    void syncSegment(Segment *segment, bool all);
+    void finishSegment(Segment *segment);
+    void setError(const std::string &error);
+    void run();
+
+    std::string m_directory;
+    size_t m_segmentSize;
+    quint64 m_sequence;
+
+    // Handed between the recording thread and the sync thread under the mutex.
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    Segment *m_current;
+    Segment *m_spare;
+    std::vector<Segment *> m_retired;
+    bool m_spareWanted;
+    bool m_syncWanted;
+    bool m_stopping;
+    std::string m_error;
+    std::thread m_thread;
+
+    size_t m_notifiedAt;  // Offset of the current segment at the last wake, recording thread only.
+
+    std::atomic<quint64> m_recorded;
+    std::atomic<quint64> m_dropped;
+    std::atomic<quint64> m_bytes;
+    std::atomic<quint64> m_segments;
+    std::atomic<quint64> m_syncs;
+};
+
+#endif  // GNSS_SDR_MONITOR_FLIGHT_RECORDER_H_
@@ -8,7 +8,6 @@ QT      += \
         core \
         gui \
         network \
-        charts \
         printsupport \
         webenginewidgets \
         location \
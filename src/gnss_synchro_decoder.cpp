@@ -0,0 +1,546 @@
+/*!
+ * \file gnss_synchro_decoder.cpp
+ * \brief Implementation of a schema-specialized decoder for the GnssSynchro
+ * wire format.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "gnss_synchro_decoder.h"
+#include "gnss_synchro.pb.h"
+#include <cstring>
+
+// Nesting of unknown groups accepted, the default recursion limit of libprotobuf.
+#define WIRE_MAX_GROUP_DEPTH 100
+
+namespace
+{
+enum WireType
+{
+    Varint = 0,
+    Fixed64 = 1,
+    LengthDelimited = 2,
+    StartGroup = 3,
+    EndGroup = 4,
+    Fixed32 = 5
+};
+
+constexpr uint32_t makeTag(uint32_t field, WireType type)
+{
+    return (field << 3) | type;
+}
+
+/*!
+ Minimal reader for the protobuf wire format. All reads are bounds-checked
+ and return false on malformed input.
+ */
+class WireReader
+{
+public:
+    WireReader(const uint8_t *begin, const uint8_t *end) : m_pos(begin), m_end(end) {}
+
+    bool atEnd() const { return m_pos == m_end; }
+
+    /*!
+     Consumes the next tag if it is \a Tag. The encoded tag is known at compile
+     time, so this is a one or two byte comparison.
+     */
+    template <uint32_t Tag>
+    bool consumeTag()
+    {
+        static_assert(Tag < 0x4000, "Tags above two varint bytes are not supported");
+        if (Tag < 0x80)
+        {
+            if (m_pos < m_end && *m_pos == Tag)
+            {
+                m_pos++;
+                return true;
+            }
+            return false;
+        }
+        if (m_end - m_pos >= 2 && m_pos[0] == ((Tag & 0x7F) | 0x80) && m_pos[1] == (Tag >> 7))
+        {
+            m_pos += 2;
+            return true;
+        }
+        return false;
+    }
+
+    bool readVarint(uint64_t *value)
+    {
+        // Fast path for the one byte varints that make up most tags and small integers.
+        if (m_pos < m_end && *m_pos < 0x80)
+        {
+            *value = *m_pos++;
+            return true;
+        }
+        return readVarintSlow(value);
+    }
+
+    /*!
+     Reads a tag as libprotobuf does: up to five varint bytes, of which only
+     the low 32 bits are kept.
+     */
+    bool readTag(uint32_t *tag)
+    {
+        uint32_t result = 0;
+        for (int i = 0; i < 5 && m_pos < m_end; i++)
+        {
+            uint8_t byte = *m_pos++;
+            result |= static_cast<uint32_t>(byte & 0x7F) << (7 * i);
+            if (!(byte & 0x80))
+            {
+                *tag = result;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool readFixed64(uint64_t *value)
+    {
+        if (m_end - m_pos < 8)
+        {
+            return false;
+        }
+        uint64_t result;
+        std::memcpy(&result, m_pos, sizeof(result));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        // The wire format is little-endian regardless of the host.
+        result = __builtin_bswap64(result);
+#endif
+        m_pos += 8;
+        *value = result;
+        return true;
+    }
+
+    bool skipVarint()
+    {
+        // Only look for the terminating byte, the value itself is not needed.
+        const uint8_t *limit = (m_end - m_pos > 10) ? m_pos + 10 : m_end;
+        for (const uint8_t *p = m_pos; p < limit; p++)
+        {
+            if (!(*p & 0x80))
+            {
+                m_pos = p + 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool skipBytes(size_t count)
+    {
+        if (static_cast<size_t>(m_end - m_pos) < count)
+        {
+            return false;
+        }
+        m_pos += count;
+        return true;
+    }
+
+    bool readLengthDelimited(const uint8_t **data, size_t *size)
+    {
+        uint64_t length = 0;
+        if (!readVarint(&length) || length > static_cast<uint64_t>(m_end - m_pos))
+        {
+            return false;
+        }
+        *data = m_pos;
+        *size = static_cast<size_t>(length);
+        m_pos += length;
+        return true;
+    }
+
+    /*!
+     Skips the value of the field of \a tag, which is nested in \a depth
+     groups.
+     */
+    bool skip(uint32_t tag, int depth = 0)
+    {
+        const uint8_t *data = nullptr;
+        size_t size = 0;
+        switch (tag & 7)
+        {
+        case Varint:
+            return skipVarint();
+        case Fixed64:
+            return skipBytes(8);
+        case LengthDelimited:
+            return readLengthDelimited(&data, &size);
+        case StartGroup:
+            return skipGroup(tag, depth + 1);
+        case Fixed32:
+            return skipBytes(4);
+        default:
+            // An end of group without a start.
+            return false;
+        }
+    }
+
+    /*!
+     Skips the fields of the group started by \a tag up to its end. The
+     GNSS-SDR messages do not use groups, but libprotobuf accepts unknown ones.
+     */
+    bool skipGroup(uint32_t tag, int depth)
+    {
+        if (depth > WIRE_MAX_GROUP_DEPTH)
+        {
+            return false;
+        }
+        uint32_t endTag = (tag & ~7u) | EndGroup;
+        while (true)
+        {
+            uint32_t next = 0;
+            if (!readTag(&next) || (next >> 3) == 0)
+            {
+                return false;
+            }
+            if (next == endTag)
+            {
+                return true;
+            }
+            if (!skip(next, depth))
+            {
+                return false;
+            }
+        }
+    }
+
+    // Typed field readers. The overload is picked at compile time from the
+    // destination member, the wire type has already been checked by the tag.
+    bool read(double *value)
+    {
+        uint64_t bits = 0;
+        if (!readFixed64(&bits))
+        {
+            return false;
+        }
+        std::memcpy(value, &bits, sizeof(bits));
+        return true;
+    }
+
+    bool read(int64_t *value)
+    {
+        uint64_t raw = 0;
+        if (!readVarint(&raw))
+        {
+            return false;
+        }
+        *value = static_cast<int64_t>(raw);
+        return true;
+    }
+
+    bool read(uint32_t *value)
+    {
+        uint64_t raw = 0;
+        if (!readVarint(&raw))
+        {
+            return false;
+        }
+        *value = static_cast<uint32_t>(raw);
+        return true;
+    }
+
+    bool read(int32_t *value)
+    {
+        uint64_t raw = 0;
+        if (!readVarint(&raw))
+        {
+            return false;
+        }
+        *value = static_cast<int32_t>(raw);
+        return true;
+    }
+
+    bool read(bool *value)
+    {
+        uint64_t raw = 0;
+        if (!readVarint(&raw))
+        {
+            return false;
+        }
+        *value = raw != 0;
+        return true;
+    }
+
+    // Stores the first two characters of a string field as a packed code.
+    bool read(uint16_t *value)
+    {
+        const uint8_t *data = nullptr;
+        size_t size = 0;
+        if (!readLengthDelimited(&data, &size))
+        {
+            return false;
+        }
+        *value = packGnssCode(size > 0 ? static_cast<char>(data[0]) : '\0',
+            size > 1 ? static_cast<char>(data[1]) : '\0');
+        return true;
+    }
+
+private:
+    // Kept out of line so that the fast path of readVarint() stays small enough to be inlined.
+    bool readVarintSlow(uint64_t *value);
+
+    const uint8_t *m_pos;
+    const uint8_t *m_end;
+};
+
+bool WireReader::readVarintSlow(uint64_t *value)
+{
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (m_pos == m_end)
+        {
+            return false;
+        }
+        uint8_t byte = *m_pos++;
+        result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*!
+ Reads the field into \a value if the next tag is \a Tag, otherwise leaves the reader untouched.
+ */
+template <uint32_t Tag, typename T>
+inline bool readIf(WireReader &reader, T *value)
+{
+    return !reader.consumeTag<Tag>() || reader.read(value);
+}
+
+/*!
+ Skips the field if the next tag is \a Tag, otherwise leaves the reader untouched.
+ */
+template <uint32_t Tag>
+inline bool skipIf(WireReader &reader)
+{
+    static_assert((Tag & 7) == Varint || (Tag & 7) == Fixed64, "Only scalar fields are skipped in the fast path");
+    if (!reader.consumeTag<Tag>())
+    {
+        return true;
+    }
+    return ((Tag & 7) == Fixed64) ? reader.skipBytes(8) : reader.skipVarint();
+}
+}  // namespace
+
+/*!
+ Decodes a serialized gnss_sdr::Observables message of \a size bytes from \a data
+ into \a epoch. Returns false if the message is malformed.
+ */
+bool GnssSynchroDecoder::decodeObservables(const char *data, size_t size, GnssSynchroEpoch *epoch)
+{
+    const uint8_t *begin = reinterpret_cast<const uint8_t *>(data);
+    WireReader reader(begin, begin + size);
+
+    // Reuse the existing elements instead of clearing the vector, they are
+    // overwritten by decodeGnssSynchro() anyway.
+    size_t count = 0;
+
+    while (!reader.atEnd())
+    {
+        uint32_t tag = 0;
+        if (!reader.readTag(&tag) || (tag >> 3) == 0)
+        {
+            return false;
+        }
+
+        if (tag == makeTag(1, LengthDelimited))  // repeated GnssSynchro observable = 1;
+        {
+            const uint8_t *field = nullptr;
+            size_t fieldSize = 0;
+            if (!reader.readLengthDelimited(&field, &fieldSize))
+            {
+                return false;
+            }
+
+            if (count == epoch->channels.size())
+            {
+                epoch->channels.emplace_back();
+            }
+            if (!decodeGnssSynchro(reinterpret_cast<const char *>(field), fieldSize, &epoch->channels[count]))
+            {
+                epoch->channels.resize(count);
+                return false;
+            }
+            count++;
+        }
+        else if (!reader.skip(tag))
+        {
+            epoch->channels.resize(count);
+            return false;
+        }
+    }
+
+    epoch->channels.resize(count);
+    return true;
+}
+
+/*!
+ Decodes a serialized gnss_sdr::GnssSynchro message of \a size bytes from \a data
+ into \a sample. Fields not needed by the views are skipped. Returns false if
+ the message is malformed.
+ */
+bool GnssSynchroDecoder::decodeGnssSynchro(const char *data, size_t size, ChannelSample *sample)
+{
+    const uint8_t *begin = reinterpret_cast<const uint8_t *>(data);
+    WireReader reader(begin, begin + size);
+
+    *sample = ChannelSample();
+
+    // Fast path. GNSS-SDR serializes the fields in declaration order, so try
+    // them in that order first: every tag check is a compare against a
+    // constant and the branches are predictable from one channel to the next.
+    bool ok = readIf<makeTag(1, LengthDelimited)>(reader, &sample->system) &&
+              readIf<makeTag(2, LengthDelimited)>(reader, &sample->signal) &&
+              readIf<makeTag(3, Varint)>(reader, &sample->prn) &&
+              readIf<makeTag(4, Varint)>(reader, &sample->channel_id) &&
+              readIf<makeTag(5, Fixed64)>(reader, &sample->acq_delay_samples) &&
+              readIf<makeTag(6, Fixed64)>(reader, &sample->acq_doppler_hz) &&
+              skipIf<makeTag(7, Varint)>(reader) &&
+              skipIf<makeTag(8, Varint)>(reader) &&
+              skipIf<makeTag(9, Varint)>(reader) &&
+              readIf<makeTag(10, Varint)>(reader, &sample->fs) &&
+              readIf<makeTag(11, Fixed64)>(reader, &sample->prompt_i) &&
+              readIf<makeTag(12, Fixed64)>(reader, &sample->prompt_q) &&
+              readIf<makeTag(13, Fixed64)>(reader, &sample->cn0_db_hz) &&
+              readIf<makeTag(14, Fixed64)>(reader, &sample->carrier_doppler_hz) &&
+              skipIf<makeTag(15, Fixed64)>(reader) &&
+              skipIf<makeTag(16, Fixed64)>(reader) &&
+              skipIf<makeTag(17, Varint)>(reader) &&
+              skipIf<makeTag(18, Varint)>(reader) &&
+              skipIf<makeTag(19, Varint)>(reader) &&
+              readIf<makeTag(20, Varint)>(reader, &sample->flag_valid_word) &&
+              readIf<makeTag(21, Varint)>(reader, &sample->tow_at_current_symbol_ms) &&
+              readIf<makeTag(22, Fixed64)>(reader, &sample->pseudorange_m) &&
+              readIf<makeTag(23, Fixed64)>(reader, &sample->rx_time) &&
+              skipIf<makeTag(24, Varint)>(reader) &&
+              skipIf<makeTag(25, Fixed64)>(reader);
+    if (!ok)
+    {
+        return false;
+    }
+
+    // Slow path for out of order, repeated or unknown fields.
+    while (!reader.atEnd())
+    {
+        uint32_t tag = 0;
+        if (!reader.readTag(&tag) || (tag >> 3) == 0)
+        {
+            return false;
+        }
+
+        switch (tag)
+        {
+        case makeTag(1, LengthDelimited):
+            ok = reader.read(&sample->system);
+            break;
+        case makeTag(2, LengthDelimited):
+            ok = reader.read(&sample->signal);
+            break;
+        case makeTag(3, Varint):
+            ok = reader.read(&sample->prn);
+            break;
+        case makeTag(4, Varint):
+            ok = reader.read(&sample->channel_id);
+            break;
+        case makeTag(5, Fixed64):
+            ok = reader.read(&sample->acq_delay_samples);
+            break;
+        case makeTag(6, Fixed64):
+            ok = reader.read(&sample->acq_doppler_hz);
+            break;
+        case makeTag(10, Varint):
+            ok = reader.read(&sample->fs);
+            break;
+        case makeTag(11, Fixed64):
+            ok = reader.read(&sample->prompt_i);
+            break;
+        case makeTag(12, Fixed64):
+            ok = reader.read(&sample->prompt_q);
+            break;
+        case makeTag(13, Fixed64):
+            ok = reader.read(&sample->cn0_db_hz);
+            break;
+        case makeTag(14, Fixed64):
+            ok = reader.read(&sample->carrier_doppler_hz);
+            break;
+        case makeTag(20, Varint):
+            ok = reader.read(&sample->flag_valid_word);
+            break;
+        case makeTag(21, Varint):
+            ok = reader.read(&sample->tow_at_current_symbol_ms);
+            break;
+        case makeTag(22, Fixed64):
+            ok = reader.read(&sample->pseudorange_m);
+            break;
+        case makeTag(23, Fixed64):
+            ok = reader.read(&sample->rx_time);
+            break;
+        default:
+            // Field not used by any view, or unknown.
+            ok = reader.skip(tag);
+            break;
+        }
+
+        if (!ok)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+ Fills \a message with the fields of \a sample, for export. The fields that
+ the decoder skips are left at their default values.
+ */
+void GnssSynchroDecoder::toGnssSynchro(const ChannelSample &sample, gnss_sdr::GnssSynchro *message)
+{
+    message->Clear();
+    message->set_system(unpackGnssCode(sample.system));
+    message->set_signal(unpackGnssCode(sample.signal));
+    message->set_prn(sample.prn);
+    message->set_channel_id(sample.channel_id);
+    message->set_acq_delay_samples(sample.acq_delay_samples);
+    message->set_acq_doppler_hz(sample.acq_doppler_hz);
+    message->set_fs(sample.fs);
+    message->set_prompt_i(sample.prompt_i);
+    message->set_prompt_q(sample.prompt_q);
+    message->set_cn0_db_hz(sample.cn0_db_hz);
+    message->set_carrier_doppler_hz(sample.carrier_doppler_hz);
+    message->set_flag_valid_word(sample.flag_valid_word);
+    message->set_tow_at_current_symbol_ms(sample.tow_at_current_symbol_ms);
+    message->set_pseudorange_m(sample.pseudorange_m);
+    message->set_rx_time(sample.rx_time);
+}
@@ -0,0 +1,111 @@
+/*!
+ * \file gnss_synchro_decoder.h
+ * \brief Interface of a schema-specialized decoder for the GnssSynchro
+ * wire format.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#ifndef GNSS_SDR_MONITOR_GNSS_SYNCHRO_DECODER_H_
+#define GNSS_SDR_MONITOR_GNSS_SYNCHRO_DECODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace gnss_sdr
+{
+class GnssSynchro;
+}
+
+/*!
+ Packs a GNSS system or signal code of up to two characters ("G", "1C", ...) into 16 bits.
+ */
+constexpr uint16_t packGnssCode(char first, char second = '\0')
+{
+    return static_cast<uint16_t>(static_cast<uint8_t>(first) | (static_cast<uint8_t>(second) << 8));
+}
+
+/*!
+ Unpacks a code packed with packGnssCode() back into its characters.
+ */
+inline std::string unpackGnssCode(uint16_t code)
+{
+    std::string text;
+    for (int shift = 0; shift < 16 && (code >> shift) & 0xFF; shift += 8)
+    {
+        text += static_cast<char>((code >> shift) & 0xFF);
+    }
+    return text;
+}
+
+/*!
+ The subset of a gnss_sdr::GnssSynchro message used by the views. It is a
+ plain struct without heap storage, so the latest sample of each channel is
+ kept and overwritten in place, and a gnss_sdr::GnssSynchro is only rebuilt
+ from it on demand, see GnssSynchroDecoder::toGnssSynchro().
+ */
+struct ChannelSample
+{
+    double acq_delay_samples;
+    double acq_doppler_hz;
+    double prompt_i;
+    double prompt_q;
+    double cn0_db_hz;
+    double carrier_doppler_hz;
+    double pseudorange_m;
+    double rx_time;
+    int64_t fs;
+    uint32_t prn;
+    int32_t channel_id;
+    uint32_t tow_at_current_symbol_ms;
+    uint16_t system;
+    uint16_t signal;
+    bool flag_valid_word;
+};
+
+static_assert(std::is_trivially_copyable<ChannelSample>::value, "ChannelSample must stay a plain struct");
+
+/*!
+ The channels of one gnss_sdr::Observables message. The vector keeps its
+ capacity when the epoch is reused, so decoding does not allocate in steady state.
+ */
+struct GnssSynchroEpoch
+{
+    std::vector<ChannelSample> channels;
+};
+
+class GnssSynchroDecoder
+{
+public:
+    static bool decodeObservables(const char *data, size_t size, GnssSynchroEpoch *epoch);
+    static bool decodeGnssSynchro(const char *data, size_t size, ChannelSample *sample);
+    static void toGnssSynchro(const ChannelSample &sample, gnss_sdr::GnssSynchro *message);
+};
+
+#endif  // GNSS_SDR_MONITOR_GNSS_SYNCHRO_DECODER_H_
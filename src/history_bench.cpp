@@ -0,0 +1,205 @@
+/*!
+ * \file history_bench.cpp
+ * \brief Compares the channel history store with the per-channel circular
+ * buffers it replaced, at 16, 64 and 256 channels.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "channel_history_store.h"
+#include <boost/circular_buffer.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+
+// Samples kept per field and channel, and the rounds of the timing.
+#define HISTORY_BENCH_CAPACITY 1000
+#define HISTORY_BENCH_ROUNDS 7
+#define HISTORY_BENCH_EPOCHS 5000
+
+namespace
+{
+/*!
+ Per-channel history as the channel table model kept it before the store,
+ one circular buffer per field in maps keyed by channel id.
+ */
+struct CircularBuffers
+{
+    std::map<int, boost::circular_buffer<double>> time;
+    std::map<int, boost::circular_buffer<double>> promptI;
+    std::map<int, boost::circular_buffer<double>> promptQ;
+    std::map<int, boost::circular_buffer<double>> cn0;
+    std::map<int, boost::circular_buffer<double>> doppler;
+
+    void append(int channel, double t, double i, double q, double c, double d)
+    {
+        if (time.find(channel) == time.end())
+        {
+            for (auto *field : {&time, &promptI, &promptQ, &cn0, &doppler})
+            {
+                (*field)[channel].set_capacity(HISTORY_BENCH_CAPACITY);
+            }
+        }
+        time.at(channel).push_back(t);
+        promptI.at(channel).push_back(i);
+        promptQ.at(channel).push_back(q);
+        cn0.at(channel).push_back(c);
+        doppler.at(channel).push_back(d);
+    }
+};
+
+/*!
+ Returns the best time, in nanoseconds per call of \a step, over several
+ rounds of \a calls calls each. \a setup runs before each round, untimed.
+ */
+double measure(const std::function<void()> &setup, const std::function<void()> &step, long calls)
+{
+    double best = 0;
+    for (int round = 0; round < HISTORY_BENCH_ROUNDS; round++)
+    {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < calls; i++)
+        {
+            step();
+        }
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / calls;
+        best = round == 0 ? elapsed : std::min(best, elapsed);
+    }
+    return best;
+}
+
+double sample(long epoch, int channel)
+{
+    return static_cast<double>((epoch * 7919 + channel * 104729) % 1000) * 0.01;
+}
+
+/*!
+ Times appending epochs of \a channels channels, while the rings grow from
+ empty and once they are full, and reading a whole ring of every channel.
+ */
+void benchmark(int channels)
+{
+    std::unique_ptr<CircularBuffers> buffers;
+    std::unique_ptr<ChannelHistoryStore> store;
+    long epoch = 0;
+
+    auto resetBuffers = [&]() {
+        buffers.reset(new CircularBuffers);
+        epoch = 0;
+    };
+    auto resetStore = [&]() {
+        store.reset(new ChannelHistoryStore(HISTORY_BENCH_CAPACITY));
+        for (int channel = 0; channel < channels; channel++)
+        {
+            store->bind(channel, store->acquire(ChannelHistoryStore::satelliteKey('G', 1, channel + 1)));
+        }
+        epoch = 0;
+    };
+    auto appendBuffers = [&]() {
+        for (int channel = 0; channel < channels; channel++)
+        {
+            double value = sample(epoch, channel);
+            buffers->append(channel, epoch, value, -value, value, value);
+        }
+        epoch++;
+    };
+    auto appendStore = [&]() {
+        for (int channel = 0; channel < channels; channel++)
+        {
+            double value = sample(epoch, channel);
+            store->append(store->slotOf(channel), epoch, value, -value, value, value);
+        }
+        epoch++;
+    };
+    auto fill = [&](const std::function<void()> &reset, const std::function<void()> &append) {
+        return [=]() {
+            reset();
+            for (int i = 0; i < HISTORY_BENCH_CAPACITY; i++)
+            {
+                append();
+            }
+        };
+    };
+
+    // Filling from empty includes the allocations of the growing rings.
+    double growingBuffers = measure(resetBuffers, appendBuffers, HISTORY_BENCH_CAPACITY) / channels;
+    double growingStore = measure(resetStore, appendStore, HISTORY_BENCH_CAPACITY) / channels;
+    double fullBuffers = measure(fill(resetBuffers, appendBuffers), appendBuffers, HISTORY_BENCH_EPOCHS) / channels;
+    double fullStore = measure(fill(resetStore, appendStore), appendStore, HISTORY_BENCH_EPOCHS) / channels;
+
+    // Reading sums a ring as the delegates walk it, so the loop is not optimized away.
+    // The first view of each round also brings the extrema of the filled ring up to date.
+    volatile double sink = 0;
+    auto readBuffers = [&]() {
+        double sum = 0;
+        for (const auto &entry : buffers->cn0)
+        {
+            for (double value : entry.second)
+            {
+                sum += value;
+            }
+        }
+        sink = sum;
+    };
+    auto readStore = [&]() {
+        double sum = 0;
+        for (int channel = 0; channel < channels; channel++)
+        {
+            RingView ring = store->view(store->slotOf(channel), ChannelHistoryStore::Cn0);
+            for (size_t i = 0; i < ring.firstSize(); i++)
+            {
+                sum += ring.firstData()[i];
+            }
+            for (size_t i = 0; i < ring.secondSize(); i++)
+            {
+                sum += ring.secondData()[i];
+            }
+        }
+        sink = sum;
+    };
+    double readingBuffers = measure(fill(resetBuffers, appendBuffers), readBuffers, HISTORY_BENCH_ROUNDS) / channels;
+    double readingStore = measure(fill(resetStore, appendStore), readStore, HISTORY_BENCH_ROUNDS) / channels;
+
+    std::cout << channels << " channels: append " << growingBuffers << " / " << growingStore << " ns per sample while growing, "
+              << fullBuffers << " / " << fullStore << " ns once full, read " << readingBuffers / 1000 << " / "
+              << readingStore / 1000 << " us per ring" << std::endl;
+}
+}  // namespace
+
+int main()
+{
+    std::cout << "Circular buffers / history store, " << HISTORY_BENCH_CAPACITY << " samples per field:" << std::endl;
+    for (int channels : {16, 64, 256})
+    {
+        benchmark(channels);
+    }
+    return 0;
+}
@@ -0,0 +1,371 @@
+/*!
+ * \file history_tiers.cpp
+ * \brief Implementation of the downsampled tiers of a long sample history, kept
+ * as minimum, mean and maximum per bucket.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "history_tiers.h"
+#include "channel_history_store.h"
+#include <algorithm>
+#include <limits>
+
+// Buckets a tier is first allocated for. It then doubles as needed.
+#define HISTORY_TIERS_INITIAL_CAPACITY 64
+
+/*!
+ Constructs \a tierCount tiers of \a capacity buckets for \a fieldCount
+ fields, each bucket summarizing \a factor buckets of the tier below.
+ */
+HistoryTiers::HistoryTiers(int fieldCount, int tierCount, size_t factor, size_t capacity)
+    : m_fieldCount(fieldCount), m_factor(std::max<size_t>(factor, 1)), m_capacity(capacity), m_stagedCount(0), m_memoryUsage(0)
+{
+    m_tiers.resize(tierCount);
+    for (Tier &tier : m_tiers)
+    {
+        tier.minimum.resize(fieldCount);
+        tier.sum.resize(fieldCount);
+        tier.maximum.resize(fieldCount);
+    }
+    m_bucket.resize(StatisticCount * fieldCount);
+    m_staged.resize((1 + fieldCount) * m_factor);
+
+    clear();
+}
+
+/*!
+ Drops the whole history and releases the storage of the rings.
+ */
+void HistoryTiers::clear()
+{
+    m_memoryUsage = (m_bucket.capacity() + m_staged.capacity()) * sizeof(double);
+    m_stagedCount = 0;
+    for (Tier &tier : m_tiers)
+    {
+        std::vector<double>().swap(tier.rings);
+        tier.allocated = 0;
+        m_memoryUsage += (tier.minimum.capacity() + tier.sum.capacity() + tier.maximum.capacity()) * sizeof(double);
+        tier.head = 0;
+        tier.size = 0;
+        tier.complete = true;
+        tier.count = 0;
+    }
+}
+
+/*!
+ Adds a sample taken at \a time with one value per field in \a values.
+ Returns true if a tier had to grow its storage.
+ */
+bool HistoryTiers::append(double time, const double *values)
+{
+    if (m_capacity == 0 || m_tiers.empty())
+    {
+        return false;
+    }
+
+    m_staged[m_stagedCount] = time;
+    for (int field = 0; field < m_fieldCount; field++)
+    {
+        m_staged[(1 + field) * m_factor + m_stagedCount] = values[field];
+    }
+    if (++m_stagedCount < m_factor)
+    {
+        return false;
+    }
+    m_stagedCount = 0;
+
+    // Summed in order, as add() does for the coarser tiers.
+    double timeSum = 0;
+    for (size_t i = 0; i < m_factor; i++)
+    {
+        timeSum += m_staged[i];
+    }
+    for (int field = 0; field < m_fieldCount; field++)
+    {
+        const double *samples = m_staged.data() + (1 + field) * m_factor;
+        double minimum = std::numeric_limits<double>::max();
+        double sum = 0;
+        double maximum = -std::numeric_limits<double>::max();
+        for (size_t i = 0; i < m_factor; i++)
+        {
+            minimum = std::min(minimum, samples[i]);
+            sum += samples[i];
+            maximum = std::max(maximum, samples[i]);
+        }
+        m_bucket[field] = minimum;
+        m_bucket[m_fieldCount + field] = sum / m_factor;
+        m_bucket[2 * m_fieldCount + field] = maximum;
+    }
+    return close(0, timeSum / m_factor);
+}
+
+/*!
+ Sets the number of buckets each tier keeps, keeping the newest ones that fit.
+ The storage of the tiers that hold more is reallocated to release the rest.
+ */
+void HistoryTiers::setCapacity(size_t capacity)
+{
+    size_t rings = 1 + StatisticCount * m_fieldCount;
+    for (Tier &tier : m_tiers)
+    {
+        size_t kept = std::min(tier.size, capacity);
+        size_t allocated = std::min(tier.allocated, capacity);
+        if (tier.head == 0 && kept == tier.size && allocated == tier.allocated)
+        {
+            continue;
+        }
+
+        // The rings are unwrapped, so that they can grow again.
+        std::vector<double> storage(rings * allocated);
+        size_t first = tier.size - kept;
+        for (size_t i = 0; i < rings; i++)
+        {
+            const double *ring = tier.rings.data() + i * tier.allocated;
+            for (size_t k = 0; k < kept; k++)
+            {
+                size_t index = tier.head + first + k;
+                storage[i * allocated + k] = ring[index >= tier.allocated ? index - tier.allocated : index];
+            }
+        }
+
+        m_memoryUsage -= tier.rings.capacity() * sizeof(double);
+        m_memoryUsage += storage.capacity() * sizeof(double);
+        tier.rings.swap(storage);
+        tier.allocated = allocated;
+        tier.head = 0;
+        tier.complete = tier.complete && kept == tier.size;
+        tier.size = kept;
+    }
+    m_capacity = capacity;
+}
+
+int HistoryTiers::fieldCount() const
+{
+    return m_fieldCount;
+}
+
+int HistoryTiers::tierCount() const
+{
+    return static_cast<int>(m_tiers.size());
+}
+
+/*!
+ Returns the number of buckets of a tier that make up one of the next tier,
+ which for tier 0 is a number of samples.
+ */
+size_t HistoryTiers::factor() const
+{
+    return m_factor;
+}
+
+size_t HistoryTiers::capacity() const
+{
+    return m_capacity;
+}
+
+/*!
+ Returns the number of buckets the largest tier has storage for.
+ */
+size_t HistoryTiers::allocated() const
+{
+    size_t allocated = 0;
+    for (const Tier &tier : m_tiers)
+    {
+        allocated = std::max(allocated, tier.allocated);
+    }
+    return allocated;
+}
+
+/*!
+ Returns the number of bytes allocated by the tiers. It is kept up to date
+ as they grow and are cleared.
+ */
+size_t HistoryTiers::memoryUsage() const
+{
+    return m_memoryUsage;
+}
+
+/*!
+ Returns the number of buckets in \a tier.
+ */
+size_t HistoryTiers::size(int tier) const
+{
+    return m_tiers[tier].size;
+}
+
+/*!
+ Returns true if \a tier still holds the oldest samples appended since the
+ last clear(), that is, if it has not evicted any bucket.
+ */
+bool HistoryTiers::isComplete(int tier) const
+{
+    return m_tiers[tier].complete;
+}
+
+/*!
+ Returns the mean times of the buckets of \a tier, oldest first.
+ */
+RingView HistoryTiers::time(int tier) const
+{
+    return ring(tier, 0);
+}
+
+/*!
+ Returns the \a statistic of \a field over each bucket of \a tier, oldest first.
+ */
+RingView HistoryTiers::view(int tier, int field, Statistic statistic) const
+{
+    return ring(tier, 1 + field * StatisticCount + statistic);
+}
+
+/*!
+ Accumulates a bucket of the tier below into the open bucket of \a tier,
+ and closes it once it summarizes factor() of them. Tier 0 is fed by
+ append() instead. Returns true if this or a coarser tier had to grow its
+ storage.
+ */
+bool HistoryTiers::add(int tier, double time, const double *minimum, const double *mean, const double *maximum)
+{
+    Tier &t = m_tiers[tier];
+    if (t.count == 0)
+    {
+        t.timeSum = 0;
+        std::fill(t.minimum.begin(), t.minimum.end(), std::numeric_limits<double>::max());
+        std::fill(t.sum.begin(), t.sum.end(), 0.0);
+        std::fill(t.maximum.begin(), t.maximum.end(), -std::numeric_limits<double>::max());
+    }
+
+    t.timeSum += time;
+    for (int field = 0; field < m_fieldCount; field++)
+    {
+        t.minimum[field] = std::min(t.minimum[field], minimum[field]);
+        t.sum[field] += mean[field];
+        t.maximum[field] = std::max(t.maximum[field], maximum[field]);
+    }
+
+    if (++t.count < m_factor)
+    {
+        return false;
+    }
+
+    // The inputs of a bucket summarize the same number of samples each, so
+    // the mean of their means is the mean of the samples.
+    double bucketTime = t.timeSum / t.count;
+    for (int field = 0; field < m_fieldCount; field++)
+    {
+        m_bucket[field] = t.minimum[field];
+        m_bucket[m_fieldCount + field] = t.sum[field] / t.count;
+        m_bucket[2 * m_fieldCount + field] = t.maximum[field];
+    }
+    t.count = 0;
+    return close(tier, bucketTime);
+}
+
+/*!
+ Stores the bucket whose statistics are in the bucket buffer, taken at \a
+ time, into the ring of \a tier, and adds it to the next tier. Returns true
+ if this or a coarser tier had to grow its storage.
+ */
+bool HistoryTiers::close(int tier, double time)
+{
+    Tier &t = m_tiers[tier];
+    const double *bucketMinimum = m_bucket.data();
+    const double *bucketMean = bucketMinimum + m_fieldCount;
+    const double *bucketMaximum = bucketMean + m_fieldCount;
+
+    // The ring has not wrapped around while it grows, so it is full when its storage is.
+    bool grew = t.size == t.allocated && t.allocated < m_capacity;
+    if (grew)
+    {
+        grow(&t);
+    }
+
+    size_t index = t.head + t.size;
+    if (index >= m_capacity)
+    {
+        index -= m_capacity;
+    }
+
+    size_t stride = t.allocated;
+    t.rings[index] = time;
+    for (int field = 0; field < m_fieldCount; field++)
+    {
+        double *rings = t.rings.data() + (1 + field * StatisticCount) * stride;
+        rings[Minimum * stride + index] = bucketMinimum[field];
+        rings[Mean * stride + index] = bucketMean[field];
+        rings[Maximum * stride + index] = bucketMaximum[field];
+    }
+
+    if (t.size < m_capacity)
+    {
+        t.size++;
+    }
+    else
+    {
+        t.complete = false;
+        if (++t.head == m_capacity)
+        {
+            t.head = 0;
+        }
+    }
+
+    if (tier + 1 < tierCount())
+    {
+        // The buffer is only read before the next tier closes its own bucket.
+        grew |= add(tier + 1, time, bucketMinimum, bucketMean, bucketMaximum);
+    }
+    return grew;
+}
+
+/*!
+ Doubles the storage of \a tier, without exceeding the capacity, moving each
+ of its rings to its place in the new layout.
+ */
+void HistoryTiers::grow(Tier *tier)
+{
+    size_t allocated = std::min(std::max<size_t>(2 * tier->allocated, HISTORY_TIERS_INITIAL_CAPACITY), m_capacity);
+    size_t rings = 1 + StatisticCount * m_fieldCount;
+    std::vector<double> storage(rings * allocated);
+    for (size_t i = 0; i < rings; i++)
+    {
+        const double *ring = tier->rings.data() + i * tier->allocated;
+        std::copy(ring, ring + tier->size, storage.begin() + i * allocated);
+    }
+
+    m_memoryUsage += (storage.capacity() - tier->rings.capacity()) * sizeof(double);
+    tier->rings.swap(storage);
+    tier->allocated = allocated;
+}
+
+RingView HistoryTiers::ring(int tier, int index) const
+{
+    const Tier &t = m_tiers[tier];
+    const double *data = t.rings.data() + index * t.allocated;
+
+    size_t firstSize = std::min(t.size, t.allocated - t.head);
+    return RingView(data + t.head, firstSize, data, t.size - firstSize, nullptr);
+}
@@ -0,0 +1,120 @@
+/*!
+ * \file history_tiers.h
+ * \brief Interface of the downsampled tiers of a long sample history, kept
+ * as minimum, mean and maximum per bucket.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#ifndef GNSS_SDR_MONITOR_HISTORY_TIERS_H_
+#define GNSS_SDR_MONITOR_HISTORY_TIERS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class RingView;
+
+/*!
+ Keeps a long history of one channel at decreasing resolutions, so that a
+ plot of any time span can be drawn from a bounded number of points.
+
+ Tier 0 summarizes every factor() samples in one bucket, and each following
+ tier summarizes factor() buckets of the tier before it. A bucket holds the
+ mean time of its samples and, for every field, their minimum, mean and
+ maximum. Each tier is a ring of at most capacity() buckets, so memory is
+ bounded and an append is amortized O(1). An append only stores the sample,
+ and the statistics of a bucket of tier 0 are computed in one pass once it
+ holds factor() samples. A bucket only appears once it is complete, so tier
+ n trails the newest sample by less than factor()^(n + 1) samples.
+
+ The rings are not allocated up front. A tier allocates its storage when its
+ first bucket closes and doubles it as buckets arrive, so a short history
+ takes little memory, and clear() releases it. Lowering the capacity drops
+ the oldest buckets and releases the storage beyond it.
+ */
+class HistoryTiers
+{
+public:
+    enum Statistic
+    {
+        Minimum = 0,
+        Mean,
+        Maximum,
+        StatisticCount
+    };
+
+    HistoryTiers(int fieldCount = 0, int tierCount = 0, size_t factor = 1, size_t capacity = 0);
+
+    void clear();
+    bool append(double time, const double *values);
+    void setCapacity(size_t capacity);
+
+    int fieldCount() const;
+    int tierCount() const;
+    size_t factor() const;
+    size_t capacity() const;
+    size_t allocated() const;
+    size_t memoryUsage() const;
+
+    size_t size(int tier) const;
+    bool isComplete(int tier) const;
+    RingView time(int tier) const;
+    RingView view(int tier, int field, Statistic statistic) const;
+
+private:
+    struct Tier
+    {
+        std::vector<double> rings;  // The time ring, then the statistic rings of every field.
+        size_t allocated;           // Buckets each ring has room for, up to the capacity.
+        size_t head;
+        size_t size;
+        bool complete;  // No bucket has been evicted since the last clear().
+
+        // Bucket being accumulated.
+        size_t count;
+        double timeSum;
+        std::vector<double> minimum;
+        std::vector<double> sum;
+        std::vector<double> maximum;
+    };
+
+    bool add(int tier, double time, const double *minimum, const double *mean, const double *maximum);
+    bool close(int tier, double time);
+    void grow(Tier *tier);
+    RingView ring(int tier, int index) const;
+
+    int m_fieldCount;
+    size_t m_factor;
+    size_t m_capacity;
+    std::vector<Tier> m_tiers;
+    std::vector<double> m_bucket;  // Statistics of the bucket being closed.
+    std::vector<double> m_staged;  // Samples of the open bucket of tier 0: their times, then the values of each field.
+    size_t m_stagedCount;
+    size_t m_memoryUsage;
+};
+
+#endif  // GNSS_SDR_MONITOR_HISTORY_TIERS_H_
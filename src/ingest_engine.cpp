@@ -0,0 +1,312 @@
+/*!
+ * \file ingest_engine.cpp
+ * \brief Implementation of an engine that receives and decodes the GNSS-SDR
+ * monitoring streams in a dedicated thread.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "ingest_engine.h"
+#include <QDebug>
+#include <QDir>
+
+// Number of decoded epochs that can be waiting for the GUI thread. At 100 Hz
+// this gives the GUI a couple of seconds of slack before epochs are dropped.
+#define GNSS_SYNCHRO_QUEUE_SIZE 256
+#define MONITOR_PVT_QUEUE_SIZE 128
+
+// Maximum number of datagrams pulled from a socket per receive call, and the
+// size of each slot of the receive slab (the largest possible UDP payload).
+#define RECEIVE_BATCH_SIZE 16
+#define MAX_DATAGRAM_SIZE 65536
+
+/*!
+ Constructs an ingest engine. The engine is meant to be moved to its own
+ thread; the sockets are created lazily in that thread by setPorts().
+ */
+IngestEngine::IngestEngine(QObject *parent) : QObject(parent),
+                                              m_batch(RECEIVE_BATCH_SIZE, MAX_DATAGRAM_SIZE),
+                                              m_gnssSynchroQueue(GNSS_SYNCHRO_QUEUE_SIZE),
+                                              m_monitorPvtQueue(MONITOR_PVT_QUEUE_SIZE)
+{
+    m_backend = DatagramReceiver::QtSocketBackend;
+    m_portGnssSynchro = 0;
+    m_portMonitorPvt = 0;
+
+    m_gnssSynchroQueued = 0;
+    m_gnssSynchroDropped = 0;
+    m_monitorPvtQueued = 0;
+    m_monitorPvtDropped = 0;
+    m_datagramsReceived = 0;
+    m_receiveCalls = 0;
+    m_recordSegmentSize = 0;
+    m_recording = false;
+}
+
+/*!
+ Returns the queue of decoded GnssSynchro epochs. Only the GUI thread may consume from it.
+ */
+SpscQueue<GnssSynchroSlot> *IngestEngine::gnssSynchroQueue()
+{
+    return &m_gnssSynchroQueue;
+}
+
+/*!
+ Returns the queue of decoded MonitorPvt epochs. Only the GUI thread may consume from it.
+ */
+SpscQueue<MonitorPvtSlot> *IngestEngine::monitorPvtQueue()
+{
+    return &m_monitorPvtQueue;
+}
+
+/*!
+ Returns the number of epochs queued and dropped so far, and the number of
+ datagrams recorded. Safe to call from any thread.
+ */
+IngestEngine::Statistics IngestEngine::statistics() const
+{
+    Statistics stats;
+    stats.gnssSynchroQueued = m_gnssSynchroQueued.load(std::memory_order_relaxed);
+    stats.gnssSynchroDropped = m_gnssSynchroDropped.load(std::memory_order_relaxed);
+    stats.monitorPvtQueued = m_monitorPvtQueued.load(std::memory_order_relaxed);
+    stats.monitorPvtDropped = m_monitorPvtDropped.load(std::memory_order_relaxed);
+    stats.datagramsReceived = m_datagramsReceived.load(std::memory_order_relaxed);
+    stats.receiveCalls = m_receiveCalls.load(std::memory_order_relaxed);
+
+    FlightRecorder::Statistics recorder = m_recorder.statistics();
+    stats.datagramsRecorded = recorder.recorded;
+    stats.recordingDropped = recorder.dropped;
+    stats.recording = m_recording.load(std::memory_order_relaxed);
+    return stats;
+}
+
+/*!
+ Selects the receive \a backend (a DatagramReceiver::Backend value). If the
+ sockets are already bound they are recreated and rebound with the new backend.
+ Must run in the engine's thread.
+ */
+void IngestEngine::setBackend(int backend)
+{
+    if (m_backend == static_cast<DatagramReceiver::Backend>(backend))
+    {
+        return;
+    }
+
+    m_backend = static_cast<DatagramReceiver::Backend>(backend);
+
+    if (m_receiverGnssSynchro || m_receiverMonitorPvt)
+    {
+        setPorts(m_portGnssSynchro, m_portMonitorPvt);
+    }
+}
+
+/*!
+ Binds the sockets to \a portGnssSynchro and \a portMonitorPvt. Must run in the engine's thread.
+ */
+void IngestEngine::setPorts(quint16 portGnssSynchro, quint16 portMonitorPvt)
+{
+    m_portGnssSynchro = portGnssSynchro;
+    m_portMonitorPvt = portMonitorPvt;
+
+    createReceivers();
+
+    bindReceiver(&m_receiverGnssSynchro, m_portGnssSynchro);
+    connect(m_receiverGnssSynchro, &DatagramReceiver::readyRead, this, &IngestEngine::receiveGnssSynchro, Qt::UniqueConnection);
+
+    bindReceiver(&m_receiverMonitorPvt, m_portMonitorPvt);
+    connect(m_receiverMonitorPvt, &DatagramReceiver::readyRead, this, &IngestEngine::receiveMonitorPvt, Qt::UniqueConnection);
+}
+
+/*!
+ Records every datagram received to segments of \a segmentSize MiB in
+ \a directory, or stops recording if \a directory is empty. A recording to
+ the same place goes on undisturbed. Must run in the engine's thread.
+ */
+void IngestEngine::setRecording(const QString &directory, int segmentSize)
+{
+    if (m_recorder.isOpen() && directory == m_recordDirectory && segmentSize == m_recordSegmentSize)
+    {
+        return;
+    }
+    m_recordDirectory = directory;
+    m_recordSegmentSize = segmentSize;
+
+    m_recording = false;
+    m_recorder.close();
+
+    if (directory.isEmpty())
+    {
+        return;
+    }
+
+    if (!QDir().mkpath(directory) ||
+        !m_recorder.open(QDir(directory).absolutePath().toStdString(), static_cast<size_t>(segmentSize) * 1024 * 1024))
+    {
+        qDebug() << "Cannot record to" << directory << QString::fromStdString(m_recorder.error());
+        return;
+    }
+
+    m_recording = true;
+    qDebug() << "Recording datagrams to" << directory;
+}
+
+/*!
+ Creates the receivers for the selected backend, replacing the existing ones if they use a different backend.
+ */
+void IngestEngine::createReceivers()
+{
+    if (m_receiverGnssSynchro && m_receiverGnssSynchro->backend() != m_backend)
+    {
+        delete m_receiverGnssSynchro;
+        m_receiverGnssSynchro = nullptr;
+    }
+
+    if (m_receiverMonitorPvt && m_receiverMonitorPvt->backend() != m_backend)
+    {
+        delete m_receiverMonitorPvt;
+        m_receiverMonitorPvt = nullptr;
+    }
+
+    if (!m_receiverGnssSynchro)
+    {
+        m_receiverGnssSynchro = DatagramReceiver::create(m_backend, this);
+    }
+
+    if (!m_receiverMonitorPvt)
+    {
+        m_receiverMonitorPvt = DatagramReceiver::create(m_backend, this);
+    }
+}
+
+/*!
+ Binds \a receiver to \a port. If the batched backend cannot be bound, the
+ receiver is replaced by a QUdpSocket one.
+ */
+bool IngestEngine::bindReceiver(DatagramReceiver **receiver, quint16 port)
+{
+    (*receiver)->close();
+    if ((*receiver)->bind(port))
+    {
+        return true;
+    }
+
+    if ((*receiver)->backend() != DatagramReceiver::QtSocketBackend)
+    {
+        qDebug() << "Falling back to the QUdpSocket receive backend on port" << port;
+        delete *receiver;
+        *receiver = DatagramReceiver::create(DatagramReceiver::QtSocketBackend, this);
+        return (*receiver)->bind(port);
+    }
+
+    return false;
+}
+
+void IngestEngine::receiveGnssSynchro()
+{
+    bool newData = false;
+    int received = 0;
+    while ((received = m_receiverGnssSynchro->receive(&m_batch)) > 0)
+    {
+        m_receiveCalls.fetch_add(1, std::memory_order_relaxed);
+        m_datagramsReceived.fetch_add(received, std::memory_order_relaxed);
+
+        // The whole batch shares one receive time. Datagrams are recorded
+        // before decoding, so the ones dropped below are kept too.
+        qint64 receiveTime = m_recorder.isOpen() ? FlightRecorder::now() : 0;
+
+        for (int i = 0; i < m_batch.size(); i++)
+        {
+            if (receiveTime)
+            {
+                m_recorder.record(FlightRecorder::GnssSynchroStream, receiveTime, m_batch.data(i), m_batch.length(i));
+            }
+
+            GnssSynchroSlot *slot = m_gnssSynchroQueue.acquire();
+            if (!slot)
+            {
+                // The GUI thread is not keeping up, drop the epoch.
+                m_gnssSynchroDropped.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            // Decode straight from the receive slab into the slot.
+            if (GnssSynchroDecoder::decodeObservables(m_batch.data(i), m_batch.length(i), slot))
+            {
+                m_gnssSynchroQueue.publish();
+                m_gnssSynchroQueued.fetch_add(1, std::memory_order_relaxed);
+                newData = true;
+            }
+        }
+    }
+
+    if (newData)
+    {
+        emit gnssSynchroReady();
+    }
+}
+
+void IngestEngine::receiveMonitorPvt()
+{
+    bool newData = false;
+    int received = 0;
+    while ((received = m_receiverMonitorPvt->receive(&m_batch)) > 0)
+    {
+        m_receiveCalls.fetch_add(1, std::memory_order_relaxed);
+        m_datagramsReceived.fetch_add(received, std::memory_order_relaxed);
+
+        // The whole batch shares one receive time. Datagrams are recorded
+        // before decoding, so the ones dropped below are kept too.
+        qint64 receiveTime = m_recorder.isOpen() ? FlightRecorder::now() : 0;
+
+        for (int i = 0; i < m_batch.size(); i++)
+        {
+            if (receiveTime)
+            {
+                m_recorder.record(FlightRecorder::MonitorPvtStream, receiveTime, m_batch.data(i), m_batch.length(i));
+            }
+
+            MonitorPvtSlot *slot = m_monitorPvtQueue.acquire();
+            if (!slot)
+            {
+                // The GUI thread is not keeping up, drop the epoch.
+                m_monitorPvtDropped.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            if (slot->parse(m_batch.data(i), m_batch.length(i)))
+            {
+                m_monitorPvtQueue.publish();
+                m_monitorPvtQueued.fetch_add(1, std::memory_order_relaxed);
+                newData = true;
+            }
+        }
+    }
+
+    if (newData)
+    {
+        emit monitorPvtReady();
+    }
+}
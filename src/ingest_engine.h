@@ -0,0 +1,114 @@
+/*!
+ * \file ingest_engine.h
+ * \brief Interface of an engine that receives and decodes the GNSS-SDR
+ * monitoring streams in a dedicated thread.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#ifndef GNSS_SDR_MONITOR_INGEST_ENGINE_H_
+#define GNSS_SDR_MONITOR_INGEST_ENGINE_H_
+
+#include "arena_message.h"
+#include "datagram_receiver.h"
+#include "flight_recorder.h"
+#include "gnss_synchro_decoder.h"
+#include "monitor_pvt.pb.h"
+#include "spsc_queue.h"
+#include <QObject>
+#include <atomic>
+
+// Queue slots, reused in place so the GUI thread can read them without a copy.
+// GnssSynchro epochs are decoded into plain channel samples whose storage is
+// kept between uses; MonitorPvt messages are decoded into a per-slot arena.
+typedef GnssSynchroEpoch GnssSynchroSlot;
+typedef ArenaMessage<gnss_sdr::MonitorPvt, 1024> MonitorPvtSlot;
+
+class IngestEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Statistics
+    {
+        quint64 gnssSynchroQueued;
+        quint64 gnssSynchroDropped;
+        quint64 monitorPvtQueued;
+        quint64 monitorPvtDropped;
+        quint64 datagramsReceived;
+        quint64 receiveCalls;
+        quint64 datagramsRecorded;
+        quint64 recordingDropped;
+        bool recording;
+    };
+
+    explicit IngestEngine(QObject *parent = nullptr);
+
+    SpscQueue<GnssSynchroSlot> *gnssSynchroQueue();
+    SpscQueue<MonitorPvtSlot> *monitorPvtQueue();
+
+    Statistics statistics() const;
+
+signals:
+    void gnssSynchroReady();
+    void monitorPvtReady();
+
+public slots:
+    void setBackend(int backend);
+    void setPorts(quint16 portGnssSynchro, quint16 portMonitorPvt);
+    void setRecording(const QString &directory, int segmentSize);
+
+private slots:
+    void receiveGnssSynchro();
+    void receiveMonitorPvt();
+
+private:
+    void createReceivers();
+    bool bindReceiver(DatagramReceiver **receiver, quint16 port);
+
+    DatagramReceiver::Backend m_backend;
+    DatagramReceiver *m_receiverGnssSynchro = nullptr;
+    DatagramReceiver *m_receiverMonitorPvt = nullptr;
+    quint16 m_portGnssSynchro;
+    quint16 m_portMonitorPvt;
+    DatagramBatch m_batch;
+    FlightRecorder m_recorder;
+    QString m_recordDirectory;
+    int m_recordSegmentSize;
+    std::atomic<bool> m_recording;
+
+    SpscQueue<GnssSynchroSlot> m_gnssSynchroQueue;
+    SpscQueue<MonitorPvtSlot> m_monitorPvtQueue;
+
+    std::atomic<quint64> m_gnssSynchroQueued;
+    std::atomic<quint64> m_gnssSynchroDropped;
+    std::atomic<quint64> m_monitorPvtQueued;
+    std::atomic<quint64> m_monitorPvtDropped;
+    std::atomic<quint64> m_datagramsReceived;
+    std::atomic<quint64> m_receiveCalls;
+};
+
+#endif  // GNSS_SDR_MONITOR_INGEST_ENGINE_H_
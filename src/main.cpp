@@ -31,19 +31,27 @@
 
 
 #include "main_window.h"
+#include "startup_trace.h"
 #include <QApplication>
 #include <QDesktopWidget>
 #include <QStyle>
+#include <QTimer>
 
 int main(int argc, char *argv[])
 {
+    StartupTrace::start();
+
     QApplication app(argc, argv);
     app.setOrganizationName("gnss-sdr");
     app.setOrganizationDomain("gnss-sdr.org");
     app.setApplicationName("gnss-sdr-monitor");
+    StartupTrace::mark("application created");
 
     MainWindow w;
+    StartupTrace::mark("main window created");
     w.show();
+    StartupTrace::mark("main window shown");
+    QTimer::singleShot(0, []() { StartupTrace::mark("event loop running"); });
 
     return app.exec();
 }
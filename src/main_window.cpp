@@ -36,60 +36,53 @@
 #include "doppler_delegate.h"
 #include "led_delegate.h"
 #include "preferences_dialog.h"
+#include "startup_trace.h"
 #include "ui_main_window.h"
+#include <QApplication>
+#include <QCloseEvent>
 #include <QDebug>
+#include <QDockWidget>
+#include <QElapsedTimer>
+#include <QMessageBox>
 #include <QQmlContext>
-#include <QtCharts>
-#include <QtNetwork/QHostAddress>
-#include <QtNetwork/QNetworkDatagram>
+#include <QTimer>
+#include <QToolBar>
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), ui(new Ui::MainWindow)
 {
-    // Use a timer to delay updating the model to a fixed amount of times per
-    // second.
-    m_updateTimer.setInterval(500);
-    m_updateTimer.setSingleShot(true);
-    connect(&m_updateTimer, &QTimer::timeout, [this] { m_model->update(); });
+    // The model is updated at most once per frame of the refresh scheduler,
+    // however often data arrives.
+    m_refreshScheduler = new RefreshScheduler(this);
+    connect(m_refreshScheduler, &RefreshScheduler::frameStarted, [this] {
+        drainIngestQueues();
+        updateIngestStatus();
+        updateMemoryStatus();
+    });
 
     ui->setupUi(this);
 
     // Monitor_Pvt_Wrapper.
     m_monitorPvtWrapper = new MonitorPvtWrapper();
 
-    // Telecommand widget.
-    m_telecommandDockWidget = new QDockWidget("Telecommand", this);
-    m_telecommandWidget = new TelecommandWidget(m_telecommandDockWidget);
-    m_telecommandDockWidget->setWidget(m_telecommandWidget);
-    addDockWidget(Qt::TopDockWidgetArea, m_telecommandDockWidget);
-    connect(m_telecommandWidget, &TelecommandWidget::resetClicked, this, &MainWindow::clearEntries);
-
-    // Map widget.
-    m_mapDockWidget = new QDockWidget("Map", this);
-    m_mapWidget = new QQuickWidget(this);
-    m_mapWidget->rootContext()->setContextProperty("m_monitor_pvt_wrapper", m_monitorPvtWrapper);
-    m_mapWidget->setSource(QUrl(QStringLiteral("qrc:/qml/main.qml")));
-    m_mapWidget->setResizeMode(QQuickWidget::SizeRootObjectToView);
-    m_mapDockWidget->setWidget(m_mapWidget);
-    addDockWidget(Qt::TopDockWidgetArea, m_mapDockWidget);
-
-    // Altitude widget.
-    m_altitudeDockWidget = new QDockWidget("Altitude", this);
-    m_altitudeWidget = new AltitudeWidget(m_altitudeDockWidget);
-    m_altitudeDockWidget->setWidget(m_altitudeWidget);
-    addDockWidget(Qt::TopDockWidgetArea, m_altitudeDockWidget);
-    connect(m_monitorPvtWrapper, &MonitorPvtWrapper::altitudeChanged, m_altitudeWidget, &AltitudeWidget::addData);
-    connect(&m_updateTimer, &QTimer::timeout, m_altitudeWidget, &AltitudeWidget::redraw);
-
-    // Dilution of precision widget.
-    m_DOPDockWidget = new QDockWidget("DOP", this);
-    m_DOPWidget = new DOPWidget(m_DOPDockWidget);
-    m_DOPDockWidget->setWidget(m_DOPWidget);
-    addDockWidget(Qt::TopDockWidgetArea, m_DOPDockWidget);
-    connect(m_monitorPvtWrapper, &MonitorPvtWrapper::dopChanged, m_DOPWidget, &DOPWidget::addData);
-    connect(&m_updateTimer, &QTimer::timeout, m_DOPWidget, &DOPWidget::redraw);
+    // Docks. Their widgets are created the first time they are shown, so the
+    // map, which loads QtLocation, and the charts cost nothing at startup
+    // when their docks are closed. The data they show is kept meanwhile by
+    // the MonitorPvt wrapper.
+    m_telecommandWidget = nullptr;
+    m_mapWidget = nullptr;
+    m_altitudeWidget = nullptr;
+    m_DOPWidget = nullptr;
+    m_tileServer = nullptr;
+
+    m_telecommandDockWidget = createDock("Telecommand", [this]() { createTelecommandWidget(); });
+    m_mapDockWidget = createDock("Map", [this]() { createMapWidget(); });
+    m_altitudeDockWidget = createDock("Altitude", [this]() { createAltitudeWidget(); });
+    m_DOPDockWidget = createDock("DOP", [this]() { createDOPWidget(); });
+    StartupTrace::mark("docks created");
 
     // QMenuBar.
     ui->actionQuit->setIcon(QIcon::fromTheme("application-exit"));
@@ -107,6 +100,9 @@ MainWindow::MainWindow(QWidget *parent)
     m_clear = ui->mainToolBar->addAction("Clear");
     ui->mainToolBar->addSeparator();
     m_closePlotsAction = ui->mainToolBar->addAction("Close Plots");
+    m_satelliteViewAction = ui->mainToolBar->addAction("Satellites");
+    m_satelliteViewAction->setCheckable(true);
+    m_satelliteViewAction->setToolTip("Show one row per satellite, tracked or not, instead of one per channel");
     ui->mainToolBar->addSeparator();
     ui->mainToolBar->addAction(m_telecommandDockWidget->toggleViewAction());
     ui->mainToolBar->addAction(m_mapDockWidget->toggleViewAction());
@@ -119,6 +115,7 @@ MainWindow::MainWindow(QWidget *parent)
     connect(m_stop, &QAction::triggered, this, &MainWindow::toggleCapture);
     connect(m_clear, &QAction::triggered, this, &MainWindow::clearEntries);
     connect(m_closePlotsAction, &QAction::triggered, this, &MainWindow::closePlots);
+    connect(m_satelliteViewAction, &QAction::toggled, this, &MainWindow::setSatelliteView);
 
     // Model.
     m_model = new ChannelTableModel();
@@ -135,14 +132,28 @@ MainWindow::MainWindow(QWidget *parent)
     ui->tableView->setItemDelegateForColumn(9, new LedDelegate());
     // ui->tableView->setAlternatingRowColors(true);
     // ui->tableView->setSelectionBehavior(QTableView::SelectRows);
-
-    // Sockets.
-    m_socketGnssSynchro = new QUdpSocket(this);
-    m_socketMonitorPvt = new QUdpSocket(this);
+    m_refreshScheduler->addView(ui->tableView, [this]() { updateTable(); });
+
+    // Ingest engine.
+    // Receives and decodes the datagrams in its own thread so that a busy GUI
+    // thread does not stall the sockets.
+    m_ingestEngine = new IngestEngine();
+    m_ingestEngine->moveToThread(&m_ingestThread);
+    connect(&m_ingestThread, &QThread::finished, m_ingestEngine, &QObject::deleteLater);
+    connect(m_ingestEngine, &IngestEngine::gnssSynchroReady, m_refreshScheduler, &RefreshScheduler::requestFrame);
+    connect(m_ingestEngine, &IngestEngine::monitorPvtReady, m_refreshScheduler, &RefreshScheduler::requestFrame);
+    m_ingestThread.setObjectName("IngestThread");
+    m_ingestThread.start();
+
+    // Status bar.
+    m_ingestStatusLabel = new QLabel(this);
+    ui->statusBar->addPermanentWidget(m_ingestStatusLabel);
+    updateIngestStatus();
+    m_memoryBudget = 0;
+    m_memoryStatusLabel = new QLabel(this);
+    ui->statusBar->addPermanentWidget(m_memoryStatusLabel);
 
     // Connect Signals & Slots.
-    connect(m_socketGnssSynchro, &QUdpSocket::readyRead, this, &MainWindow::receiveGnssSynchro);
-    connect(m_socketMonitorPvt, &QUdpSocket::readyRead, this, &MainWindow::receiveMonitorPvt);
     connect(qApp, &QApplication::aboutToQuit, this, &MainWindow::quit);
     connect(ui->tableView, &QTableView::clicked, this, &MainWindow::expandPlot);
     connect(ui->actionAbout, &QAction::triggered, this, &MainWindow::about);
@@ -150,45 +161,142 @@ MainWindow::MainWindow(QWidget *parent)
 
     // Load settings from last session.
     loadSettings();
+    StartupTrace::mark("settings loaded");
 }
 
-MainWindow::~MainWindow() { delete ui; }
+MainWindow::~MainWindow()
+{
+    m_ingestThread.quit();
+    m_ingestThread.wait();
 
-void MainWindow::closeEvent(QCloseEvent *event)
+    delete ui;
+}
+
+/*!
+ Creates a dock titled \a title whose widget is created by \a create the
+ first time the dock is shown, once the event loop runs, so that the main
+ window is up before it.
+ */
+QDockWidget *MainWindow::createDock(const QString &title, const std::function<void()> &create)
 {
-    deletePlots();
+    QDockWidget *dock = new QDockWidget(title, this);
+    dock->setObjectName(title + "_Dock");
+    addDockWidget(Qt::TopDockWidgetArea, dock);
 
-    QMainWindow::closeEvent(event);
+    connect(dock, &QDockWidget::visibilityChanged, this, [dock, title, create](bool visible) {
+        if (!visible || dock->widget())
+        {
+            return;
+        }
+        QTimer::singleShot(0, dock, [dock, title, create]() {
+            if (dock->widget())
+            {
+                return;
+            }
+            QElapsedTimer timer;
+            timer.start();
+            create();
+            StartupTrace::mark(QString("%1 dock built in %2 ms").arg(title).arg(timer.nsecsElapsed() / 1e6, 0, 'f', 1));
+        });
+    });
+
+    return dock;
 }
 
-void MainWindow::updateChart(QtCharts::QChart *chart, QtCharts::QXYSeries *series, const QModelIndex &index)
+void MainWindow::createTelecommandWidget()
 {
-    QPointF p;
-    QVector<QPointF> points;
+    m_telecommandWidget = new TelecommandWidget(m_telecommandDockWidget);
+    m_telecommandDockWidget->setWidget(m_telecommandWidget);
+    connect(m_telecommandWidget, &TelecommandWidget::resetClicked, this, &MainWindow::clearEntries);
+}
 
-    double min_x = std::numeric_limits<double>::max();
-    double max_x = -std::numeric_limits<double>::max();
+/*!
+ Creates the map and its tile server. The positions received before are in
+ the path model already, and are published by the first refresh of the map.
+ */
+void MainWindow::createMapWidget()
+{
+    // Map tiles, served locally from the caches, the tile package or the upstream.
+    m_tileServer = new TileServer(this);
+    m_tileServer->loadSettings();
+    m_tileServer->listen();
 
-    double min_y = std::numeric_limits<double>::max();
-    double max_y = -std::numeric_limits<double>::max();
+    m_mapWidget = new QQuickWidget(m_mapDockWidget);
+    m_mapWidget->rootContext()->setContextProperty("m_monitor_pvt_wrapper", m_monitorPvtWrapper);
+    m_mapWidget->rootContext()->setContextProperty("m_tile_server_url", m_tileServer->url());
+    m_mapWidget->setSource(QUrl(QStringLiteral("qrc:/qml/main.qml")));
+    m_mapWidget->setResizeMode(QQuickWidget::SizeRootObjectToView);
+    m_mapDockWidget->setWidget(m_mapWidget);
+    m_refreshScheduler->addView(m_mapWidget, [this]() { m_monitorPvtWrapper->publish(); });
+}
 
-    QList<QVariant> var = index.data(Qt::DisplayRole).toList();
-    for (int i = 0; i < var.size(); i++)
+/*!
+ Creates the altitude chart and fills it with the history of the MonitorPvt wrapper.
+ */
+void MainWindow::createAltitudeWidget()
+{
+    m_altitudeWidget = new AltitudeWidget(m_altitudeDockWidget);
+    m_altitudeWidget->setBufferSize(m_monitorPvtWrapper->bufferSize());
+    for (const gnss_sdr::MonitorPvt &monitorPvt : m_monitorPvtWrapper->history())
     {
-        p = var.at(i).toPointF();
-        points << p;
-
-        min_x = std::min(min_x, p.x());
-        min_y = std::min(min_y, p.y());
+        m_altitudeWidget->addData(monitorPvt.tow_at_current_symbol_ms(), monitorPvt.height());
+    }
+    m_altitudeDockWidget->setWidget(m_altitudeWidget);
+    connect(m_monitorPvtWrapper, &MonitorPvtWrapper::altitudeChanged, m_altitudeWidget, &AltitudeWidget::addData);
+    m_refreshScheduler->addView(m_altitudeWidget, [this]() { m_altitudeWidget->redraw(); });
+    setMemoryBudget();
+}
 
-        max_x = std::max(max_x, p.x());
-        max_y = std::max(max_y, p.y());
+/*!
+ Creates the DOP chart and fills it with the history of the MonitorPvt wrapper.
+ */
+void MainWindow::createDOPWidget()
+{
+    m_DOPWidget = new DOPWidget(m_DOPDockWidget);
+    m_DOPWidget->setBufferSize(m_monitorPvtWrapper->bufferSize());
+    for (const gnss_sdr::MonitorPvt &monitorPvt : m_monitorPvtWrapper->history())
+    {
+        m_DOPWidget->addData(monitorPvt.tow_at_current_symbol_ms(), monitorPvt.gdop(), monitorPvt.pdop(),
+            monitorPvt.hdop(), monitorPvt.vdop());
     }
+    m_DOPDockWidget->setWidget(m_DOPWidget);
+    connect(m_monitorPvtWrapper, &MonitorPvtWrapper::dopChanged, m_DOPWidget, &DOPWidget::addData);
+    m_refreshScheduler->addView(m_DOPWidget, [this]() { m_DOPWidget->redraw(); });
+    setMemoryBudget();
+}
+
+void MainWindow::closeEvent(QCloseEvent *event)
+{
+    deletePlots();
+
+    QMainWindow::closeEvent(event);
+}
+
+/*!
+ Creates a plot window that shows, as a series of the given \a style, the
+ history served by the model at \a index, and refreshes it on every update tick.
+ */
+PlotWidget *MainWindow::createChannelPlot(const QModelIndex &index, const QString &title,
+    const QString &xTitle, const QString &yTitle, PlotWidget::SeriesStyle style)
+{
+    PlotWidget *plot = new PlotWidget();  // has no parent!
+    plot->setTitle(title);
+    plot->setAxisTitles(xTitle, yTitle);
+
+    // The samples are read in place from the model's history when the plot is
+    // painted, from the tier that matches the span shown.
+    plot->addSeries(title, [this, index](const PlotWidget::Viewport &viewport) {
+        return m_model->getSeries(index, viewport.minX, viewport.maxX, viewport.width);
+    },
+        style);
+
+    // Delete the plot window when MainWindow is closed.
+    connect(this, &QMainWindow::destroyed, plot, &QObject::deleteLater);
 
-    series->replace(points);
+    // Repaint the plot on every frame in which it is shown, if its data changed.
+    m_refreshScheduler->addView(plot, [plot]() { plot->refresh(); });
 
-    chart->axes(Qt::Horizontal).back()->setRange(min_x, max_x);
-    chart->axes(Qt::Vertical).back()->setRange(min_y, max_y);
+    return plot;
 }
 
 void MainWindow::toggleCapture()
@@ -205,91 +313,169 @@ void MainWindow::toggleCapture()
     }
 }
 
-void MainWindow::receiveGnssSynchro()
+/*!
+ Moves all the epochs decoded by the ingest engine into the model and the
+ MonitorPvt wrapper. Epochs received while capture is stopped are discarded.
+ */
+void MainWindow::drainIngestQueues()
 {
-    bool newData = false;
-    while (m_socketGnssSynchro->hasPendingDatagrams())
+    // The epochs are read in place from the queue slots, they are not copied.
+    SpscQueue<GnssSynchroSlot> *gnssSynchroQueue = m_ingestEngine->gnssSynchroQueue();
+    while (GnssSynchroSlot *slot = gnssSynchroQueue->front())
     {
-        newData = true;
-        QNetworkDatagram datagram = m_socketGnssSynchro->receiveDatagram();
-        m_stocks = readGnssSynchro(datagram.data().data(), datagram.data().size());
-
         if (m_stop->isEnabled())
         {
-            m_model->populateChannels(&m_stocks);
+            m_model->populateChannels(*slot);
             m_clear->setEnabled(true);
         }
+        gnssSynchroQueue->pop();
     }
-    if (newData && !m_updateTimer.isActive())
-    {
-        m_updateTimer.start();
-    }
-}
 
-void MainWindow::receiveMonitorPvt()
-{
-    while (m_socketMonitorPvt->hasPendingDatagrams())
+    SpscQueue<MonitorPvtSlot> *monitorPvtQueue = m_ingestEngine->monitorPvtQueue();
+    while (MonitorPvtSlot *slot = monitorPvtQueue->front())
     {
-        QNetworkDatagram datagram = m_socketMonitorPvt->receiveDatagram();
-        m_monitorPvt =
-            readMonitorPvt(datagram.data().data(), datagram.data().size());
-
         if (m_stop->isEnabled())
         {
-            m_monitorPvtWrapper->addMonitorPvt(m_monitorPvt);
-            // clear->setEnabled(true);
+            m_monitorPvtWrapper->addMonitorPvt(*slot->message());
         }
+        monitorPvtQueue->pop();
     }
 }
 
-void MainWindow::clearEntries()
+/*!
+ Notifies the table view of the changes in the rows it currently shows.
+ */
+void MainWindow::updateTable()
 {
-    m_model->clearChannels();
+    QTableView *view = ui->tableView;
+    int first = view->rowAt(0);
+    int last = view->rowAt(view->viewport()->height() - 1);
+    if (first < 0)
+    {
+        first = 0;
+    }
+    if (last < 0)
+    {
+        // The rows do not fill the view, so the last one is shown.
+        last = m_model->rowCount(QModelIndex()) - 1;
+    }
+    m_model->setVisibleRows(first, last);
     m_model->update();
-
-    m_altitudeWidget->clear();
-    m_DOPWidget->clear();
-
-    m_clear->setEnabled(false);
 }
 
-void MainWindow::quit() { saveSettings(); }
+/*!
+ Shows the number of epochs queued and dropped by the ingest engine, and the
+ number of table cells updated by the last refresh, in the status bar. While
+ recording, the number of datagrams recorded and dropped is shown too.
+ */
+void MainWindow::updateIngestStatus()
+{
+    IngestEngine::Statistics stats = m_ingestEngine->statistics();
+    double datagramsPerCall = stats.receiveCalls ? double(stats.datagramsReceived) / stats.receiveCalls : 0.0;
+    m_ingestStatusLabel->setText(QString("GnssSynchro: %1 queued, %2 dropped | MonitorPvt: %3 queued, %4 dropped | %5 datagrams/receive | %6 cells updated | %7 FPS, %8 ms/frame")
+                                     .arg(stats.gnssSynchroQueued)
+                                     .arg(stats.gnssSynchroDropped)
+                                     .arg(stats.monitorPvtQueued)
+                                     .arg(stats.monitorPvtDropped)
+                                     .arg(datagramsPerCall, 0, 'f', 1)
+                                     .arg(m_model->getUpdatedCells())
+                                     .arg(m_refreshScheduler->currentFps(), 0, 'f', 1)
+                                     .arg(m_refreshScheduler->frameCost(), 0, 'f', 1));
+    if (stats.recording)
+    {
+        m_ingestStatusLabel->setText(m_ingestStatusLabel->text() + QString(" | Recording: %1 datagrams, %2 dropped")
+                                                                       .arg(stats.datagramsRecorded)
+                                                                       .arg(stats.recordingDropped));
+    }
+}
 
-gnss_sdr::Observables MainWindow::readGnssSynchro(char buff[], int bytes)
+/*!
+ Shows the memory taken by the history of the channels and of the PVT views
+ in the status bar, with the share of each of them in the tooltip.
+ */
+void MainWindow::updateMemoryStatus()
 {
-    try
+    const ChannelHistoryStore &history = m_model->getHistory();
+    size_t channels = history.memoryUsage();
+    size_t tiers = history.tierMemoryUsage();
+    size_t pvt = m_monitorPvtWrapper->memoryUsage();
+    size_t altitude = m_altitudeWidget ? m_altitudeWidget->memoryUsage() : 0;
+    size_t dop = m_DOPWidget ? m_DOPWidget->memoryUsage() : 0;
+    const double MiB = 1024.0 * 1024.0;
+
+    QString text = QString("Memory: %1 MiB").arg((channels + pvt + altitude + dop) / MiB, 0, 'f', 1);
+    if (m_memoryBudget > 0)
     {
-        std::string data(buff, bytes);
-        m_stocks.ParseFromString(data);
+        text += QString(" of %1 MiB").arg(m_memoryBudget / MiB, 0, 'f', 1);
     }
-    catch (std::exception &e)
+    m_memoryStatusLabel->setText(text);
+
+    QString tooltip = QString("Channel history: %1 MiB, of which %2 MiB in downsampled tiers\nPVT: %3 MiB\nAltitude: %4 MiB\nDOP: %5 MiB")
+                          .arg(channels / MiB, 0, 'f', 2)
+                          .arg(tiers / MiB, 0, 'f', 2)
+                          .arg(pvt / MiB, 0, 'f', 2)
+                          .arg(altitude / MiB, 0, 'f', 2)
+                          .arg(dop / MiB, 0, 'f', 2);
+    if (m_tileServer)
     {
-        qDebug() << e.what();
+        tooltip += QString("\nMap tiles: %1 MiB in memory (not budgeted), %2 MiB on disk")
+                       .arg(m_tileServer->cache()->memoryUsage() / MiB, 0, 'f', 2)
+                       .arg(m_tileServer->cache()->diskUsage() / MiB, 0, 'f', 2);
     }
 
-    return m_stocks;
+    // Report the fields whose history was shortened to fit in the budget.
+    static const struct
+    {
+        ChannelHistoryStore::Field field;
+        const char *name;
+    } fields[] = {{ChannelHistoryStore::PromptI, "I/Q"}, {ChannelHistoryStore::Cn0, "C/N0"},
+        {ChannelHistoryStore::Doppler, "Doppler"}};
+    for (const auto &entry : fields)
+    {
+        if (history.capacity(entry.field) < history.retention(entry.field))
+        {
+            tooltip += QString("\n%1 history limited to %2 of %3 samples")
+                           .arg(entry.name)
+                           .arg(history.capacity(entry.field))
+                           .arg(history.retention(entry.field));
+        }
+    }
+    if (history.tierCapacity() < history.tierRetention())
+    {
+        tooltip += QString("\nDownsampled history limited to %1 of %2 buckets per tier")
+                       .arg(history.tierCapacity())
+                       .arg(history.tierRetention());
+    }
+    m_memoryStatusLabel->setToolTip(tooltip);
 }
 
-gnss_sdr::MonitorPvt MainWindow::readMonitorPvt(char buff[], int bytes)
+void MainWindow::clearEntries()
 {
-    try
+    m_model->clearChannels();
+    m_model->update();
+
+    // The PVT history is cleared too, or the docks opened later would replay it.
+    m_monitorPvtWrapper->clearData();
+    if (m_altitudeWidget)
     {
-        std::string data(buff, bytes);
-        m_monitorPvt.ParseFromString(data);
+        m_altitudeWidget->clear();
     }
-    catch (std::exception &e)
+    if (m_DOPWidget)
     {
-        qDebug() << e.what();
+        m_DOPWidget->clear();
     }
 
-    return m_monitorPvt;
+    m_clear->setEnabled(false);
 }
 
+void MainWindow::quit() { saveSettings(); }
+
 void MainWindow::saveSettings()
 {
     m_settings.beginGroup("Main_Window");
     m_settings.setValue("pos", pos());
     m_settings.setValue("size", size());
+    m_settings.setValue("state", saveState());
     m_settings.endGroup();
 
     m_settings.beginGroup("tableView");
@@ -310,6 +496,8 @@ void MainWindow::loadSettings()
     m_settings.beginGroup("Main_Window");
     move(m_settings.value("pos", QPoint(0, 0)).toPoint());
     resize(m_settings.value("size", QSize(1400, 600)).toSize());
+    // The docks closed in the last session stay closed, and so are not built.
+    restoreState(m_settings.value("state").toByteArray());
     m_settings.endGroup();
 
     m_settings.beginGroup("tableView");
@@ -323,6 +511,10 @@ void MainWindow::loadSettings()
     m_settings.endGroup();
 
     setPort();
+    setRefreshRate();
+    setRetention();
+    setMapTiles();
+    setRecording();
 
     qDebug() << "Settings Loaded";
 }
@@ -330,10 +522,16 @@ void MainWindow::loadSettings()
 void MainWindow::showPreferences()
 {
     PreferencesDialog *preferences = new PreferencesDialog(this);
-    connect(preferences, &PreferencesDialog::accepted, m_model,
-        &ChannelTableModel::setBufferSize);
+    connect(preferences, &PreferencesDialog::accepted, this,
+        &MainWindow::setRetention);
     connect(preferences, &PreferencesDialog::accepted, this,
         &MainWindow::setPort);
+    connect(preferences, &PreferencesDialog::accepted, this,
+        &MainWindow::setRefreshRate);
+    connect(preferences, &PreferencesDialog::accepted, this,
+        &MainWindow::setMapTiles);
+    connect(preferences, &PreferencesDialog::accepted, this,
+        &MainWindow::setRecording);
     preferences->exec();
 }
 
@@ -343,11 +541,120 @@ void MainWindow::setPort()
     settings.beginGroup("Preferences_Dialog");
     m_portGnssSynchro = settings.value("port_gnss_synchro", 1111).toInt();
     m_portMonitorPvt = settings.value("port_monitor_pvt", 1112).toInt();
+    int backend = settings.value("receive_backend", DatagramReceiver::QtSocketBackend).toInt();
+    settings.endGroup();
+
+    // The sockets live in the ingest thread, so bind them from there.
+    QMetaObject::invokeMethod(m_ingestEngine, "setBackend", Qt::QueuedConnection, Q_ARG(int, backend));
+    QMetaObject::invokeMethod(m_ingestEngine, "setPorts", Qt::QueuedConnection,
+        Q_ARG(quint16, m_portGnssSynchro), Q_ARG(quint16, m_portMonitorPvt));
+}
+
+/*!
+ Applies the target refresh rate of the views set in the preferences.
+ */
+void MainWindow::setRefreshRate()
+{
+    QSettings settings;
+    settings.beginGroup("Preferences_Dialog");
+    int refreshRate = settings.value("refresh_rate", 10).toInt();
     settings.endGroup();
 
-    m_socketGnssSynchro->disconnectFromHost();
-    m_socketGnssSynchro->bind(QHostAddress::Any, m_portGnssSynchro);
-    m_socketMonitorPvt->bind(QHostAddress::Any, m_portMonitorPvt);
+    m_refreshScheduler->setTargetFps(refreshRate);
+}
+
+/*!
+ Applies the history retention of each field and the memory budget set in the
+ preferences. The PVT views keep their whole history, so the channels get
+ whatever part of the budget they leave.
+ */
+void MainWindow::setRetention()
+{
+    QSettings settings;
+    settings.beginGroup("Preferences_Dialog");
+    int bufferSize = settings.value("buffer_size", 1000).toInt();
+    int promptSize = settings.value("retention_prompt", bufferSize).toInt();
+    int cn0Size = settings.value("retention_cn0", bufferSize).toInt();
+    int dopplerSize = settings.value("retention_doppler", bufferSize).toInt();
+    int pvtSize = settings.value("retention_pvt", bufferSize).toInt();
+    int budgetMiB = settings.value("memory_budget", 0).toInt();
+    int satelliteTimeout = settings.value("satellite_timeout", 600).toInt();
+    settings.endGroup();
+
+    m_model->setSatelliteTimeout(satelliteTimeout);
+
+    m_model->setRetention(promptSize, cn0Size, dopplerSize);
+    m_monitorPvtWrapper->setBufferSize(pvtSize);
+    if (m_altitudeWidget)
+    {
+        m_altitudeWidget->setBufferSize(pvtSize);
+    }
+    if (m_DOPWidget)
+    {
+        m_DOPWidget->setBufferSize(pvtSize);
+    }
+
+    m_memoryBudget = static_cast<size_t>(std::max(budgetMiB, 0)) * 1024 * 1024;
+    setMemoryBudget();
+}
+
+/*!
+ Gives the channel history whatever part of the memory budget the PVT views
+ leave. It is called again when a PVT view is created.
+ */
+void MainWindow::setMemoryBudget()
+{
+    size_t channelBudget = 0;
+    if (m_memoryBudget > 0)
+    {
+        size_t pvtUsage = m_monitorPvtWrapper->memoryUsage();
+        pvtUsage += m_altitudeWidget ? m_altitudeWidget->memoryUsage() : 0;
+        pvtUsage += m_DOPWidget ? m_DOPWidget->memoryUsage() : 0;
+        // A budget the PVT views already exceed leaves the channels at their minimum history.
+        channelBudget = m_memoryBudget > pvtUsage ? m_memoryBudget - pvtUsage : 1;
+    }
+    m_model->setMemoryBudget(channelBudget);
+
+    updateMemoryStatus();
+}
+
+/*!
+ Applies the tile package, the upstream and the tile cache limits set in the
+ preferences. The tile server reads them when it is created with the map.
+ */
+void MainWindow::setMapTiles()
+{
+    if (m_tileServer)
+    {
+        m_tileServer->loadSettings();
+    }
+}
+
+/*!
+ Starts or stops recording the raw datagrams as set in the preferences. The
+ recorder belongs to the ingest engine, so it is opened from its thread.
+ */
+void MainWindow::setRecording()
+{
+    QSettings settings;
+    settings.beginGroup("Preferences_Dialog");
+    QString directory = settings.value("record_directory", QString()).toString();
+    int segmentSize = settings.value("record_segment_size", 64).toInt();
+    settings.endGroup();
+
+    QMetaObject::invokeMethod(m_ingestEngine, "setRecording", Qt::QueuedConnection,
+        Q_ARG(QString, directory), Q_ARG(int, segmentSize));
+}
+
+/*!
+ Shows one row per satellite with history if \a enabled, or one row per
+ tracking channel otherwise. The plot windows are tied to rows, so they are deleted.
+ */
+void MainWindow::setSatelliteView(bool enabled)
+{
+    deletePlots();
+    m_model->setViewMode(enabled ? ChannelTableModel::SatelliteView : ChannelTableModel::ChannelView);
+    updateTable();
 }
 
 void MainWindow::expandPlot(const QModelIndex &index)
@@ -356,163 +663,90 @@ void MainWindow::expandPlot(const QModelIndex &index)
 
     int channel_id = m_model->getChannelId(index.row());
 
-    QChartView *chartView = nullptr;
+    PlotWidget *plot = nullptr;
 
     if (index.column() == 5)  // Constellation
     {
         if (m_plotsConstellation.find(index.row()) == m_plotsConstellation.end())
         {
-            QChart *chart = new QChart();  // has no parent!
-            chart->setTitle("Constellation CH " + QString::number(channel_id));
-            chart->legend()->hide();
-
-            QScatterSeries *series = new QScatterSeries(chart);
-            series->setMarkerSize(8);
-            chart->addSeries(series);
-            chart->createDefaultAxes();
-            chart->axes(Qt::Horizontal).back()->setTitleText("I prompt");
-            chart->axes(Qt::Vertical).back()->setTitleText("Q prompt");
-            chart->layout()->setContentsMargins(0, 0, 0, 0);
-            chart->setContentsMargins(-18, -18, -14, -16);
-
-            chartView = new QChartView(chart);
-            chartView->setRenderHint(QPainter::Antialiasing);
-            chartView->setContentsMargins(0, 0, 0, 0);
-
-            // Draw chart now.
-            updateChart(chart, series, index);
-
-            // Delete the chartView object when MainWindow is closed.
-            connect(this, &QMainWindow::destroyed, chartView, &QObject::deleteLater);
-
-            // Remove element from map when chartView widget is closed.
-            connect(chartView, &QObject::destroyed,
-                [this, index]() { m_plotsConstellation.erase(index.row()); });
+            plot = createChannelPlot(index, "Constellation CH " + QString::number(channel_id),
+                "I prompt", "Q prompt", PlotWidget::Points);
 
-            // Update chart on timer timeout.
-            connect(&m_updateTimer, &QTimer::timeout, chart, [this, chart, series, index]() {
-                updateChart(chart, series, index);
-            });
+            // Remove element from map when the plot widget is destroyed.
+            connect(plot, &QObject::destroyed,
+                [this, index]() { m_plotsConstellation.erase(index.row()); });
 
-            m_plotsConstellation[index.row()] = chartView;
+            m_plotsConstellation[index.row()] = plot;
         }
         else
         {
-            chartView = m_plotsConstellation.at(index.row());
+            plot = m_plotsConstellation.at(index.row());
         }
     }
     else if (index.column() == 6)  // CN0
     {
         if (m_plotsCn0.find(index.row()) == m_plotsCn0.end())
         {
-            QChart *chart = new QChart();  // has no parent!
-            chart->setTitle("CN0 CH " + QString::number(channel_id));
-            chart->legend()->hide();
-
-            QLineSeries *series = new QLineSeries(chart);
-            chart->addSeries(series);
-            chart->createDefaultAxes();
-            chart->axes(Qt::Horizontal).back()->setTitleText("TOW [s]");
-            chart->axes(Qt::Vertical).back()->setTitleText("C/N0 [db-Hz]");
-            chart->layout()->setContentsMargins(0, 0, 0, 0);
-            chart->setContentsMargins(-18, -18, -14, -16);
-
-            chartView = new QChartView(chart);
-            chartView->setRenderHint(QPainter::Antialiasing);
-            chartView->setContentsMargins(0, 0, 0, 0);
-
-            // Draw chart now.
-            updateChart(chart, series, index);
-
-            // Delete the chartView object when MainWindow is closed.
-            connect(this, &QMainWindow::destroyed, chartView, &QObject::deleteLater);
-
-            // Remove element from map when chartView widget is closed.
-            connect(chartView, &QObject::destroyed,
-                [this, index]() { m_plotsCn0.erase(index.row()); });
+            plot = createChannelPlot(index, "CN0 CH " + QString::number(channel_id),
+                "TOW [s]", "C/N0 [db-Hz]", PlotWidget::Lines);
 
-            // Update chart on timer timeout.
-            connect(&m_updateTimer, &QTimer::timeout, chart, [this, chart, series, index]() {
-                updateChart(chart, series, index);
-            });
+            // Remove element from map when the plot widget is destroyed.
+            connect(plot, &QObject::destroyed,
+                [this, index]() { m_plotsCn0.erase(index.row()); });
 
-            m_plotsCn0[index.row()] = chartView;
+            m_plotsCn0[index.row()] = plot;
         }
         else
         {
-            chartView = m_plotsCn0.at(index.row());
+            plot = m_plotsCn0.at(index.row());
         }
     }
     else if (index.column() == 7)  // Doppler
     {
         if (m_plotsDoppler.find(index.row()) == m_plotsDoppler.end())
         {
-            QChart *chart = new QChart();  // has no parent!
-            chart->setTitle("Doppler CH " + QString::number(channel_id));
-            chart->legend()->hide();
-
-            QLineSeries *series = new QLineSeries(chart);
-            chart->addSeries(series);
-            chart->createDefaultAxes();
-            chart->axes(Qt::Horizontal).back()->setTitleText("TOW [s]");
-            chart->axes(Qt::Vertical).back()->setTitleText("Doppler [Hz]");
-            chart->layout()->setContentsMargins(0, 0, 0, 0);
-            chart->setContentsMargins(-18, -18, -14, -16);
-
-            chartView = new QChartView(chart);
-            chartView->setRenderHint(QPainter::Antialiasing);
-            chartView->setContentsMargins(0, 0, 0, 0);
-
-            // Draw chart now.
-            updateChart(chart, series, index);
-
-            // Delete the chartView object when MainWindow is closed.
-            connect(this, &QMainWindow::destroyed, chartView, &QObject::deleteLater);
-
-            // Remove element from map when chartView widget is closed.
-            connect(chartView, &QObject::destroyed,
-                [this, index]() { m_plotsDoppler.erase(index.row()); });
+            plot = createChannelPlot(index, "Doppler CH " + QString::number(channel_id),
+                "TOW [s]", "Doppler [Hz]", PlotWidget::Lines);
 
-            // Update chart on timer timeout.
-            connect(&m_updateTimer, &QTimer::timeout, chart, [this, chart, series, index]() {
-                updateChart(chart, series, index);
-            });
+            // Remove element from map when the plot widget is destroyed.
+            connect(plot, &QObject::destroyed,
+                [this, index]() { m_plotsDoppler.erase(index.row()); });
 
-            m_plotsDoppler[index.row()] = chartView;
+            m_plotsDoppler[index.row()] = plot;
         }
         else
         {
-            chartView = m_plotsDoppler.at(index.row());
+            plot = m_plotsDoppler.at(index.row());
         }
     }
 
-    if (!chartView)  // Equivalent to: if (chartView == nullptr)
+    if (!plot)  // Equivalent to: if (plot == nullptr)
     {
         return;
     }
 
-    chartView->resize(400, 180);
-    chartView->show();
+    plot->resize(400, 180);
+    plot->show();
 }
 
 void MainWindow::closePlots()
 {
     for (auto const &ch : m_plotsConstellation)
     {
-        auto const &chartView = ch.second;
-        chartView->close();
+        auto const &plot = ch.second;
+        plot->close();
     }
 
     for (auto const &ch : m_plotsCn0)
     {
-        auto const &chartView = ch.second;
-        chartView->close();
+        auto const &plot = ch.second;
+        plot->close();
     }
 
     for (auto const &ch : m_plotsDoppler)
     {
-        auto const &chartView = ch.second;
-        chartView->close();
+        auto const &plot = ch.second;
+        plot->close();
     }
 }
 
@@ -520,22 +754,22 @@ void MainWindow::deletePlots()
 {
     for (auto const &ch : m_plotsConstellation)
     {
-        auto const &chartView = ch.second;
-        chartView->deleteLater();
+        auto const &plot = ch.second;
+        plot->deleteLater();
     }
     m_plotsConstellation.clear();
 
     for (auto const &ch : m_plotsCn0)
     {
-        auto const &chartView = ch.second;
-        chartView->deleteLater();
+        auto const &plot = ch.second;
+        plot->deleteLater();
     }
     m_plotsCn0.clear();
 
     for (auto const &ch : m_plotsDoppler)
     {
-        auto const &chartView = ch.second;
-        chartView->deleteLater();
+        auto const &plot = ch.second;
+        plot->deleteLater();
     }
     m_plotsDoppler.clear();
 }
@@ -36,30 +36,25 @@
 #include "altitude_widget.h"
 #include "channel_table_model.h"
 #include "dop_widget.h"
-#include "gnss_synchro.pb.h"
-#include "monitor_pvt.pb.h"
+#include "ingest_engine.h"
 #include "monitor_pvt_wrapper.h"
+#include "plot_widget.h"
+#include "refresh_scheduler.h"
 #include "telecommand_widget.h"
+#include "tile_server.h"
 #include <QAbstractTableModel>
-#include <QChart>
-#include <QChartView>
 #include <QMainWindow>
 #include <QQuickWidget>
+#include <QLabel>
 #include <QSettings>
-#include <QTimer>
-#include <QXYSeries>
-#include <QtNetwork/QUdpSocket>
+#include <QThread>
+#include <functional>
 
 namespace Ui
 {
 class MainWindow;
 }
 
-namespace QtCharts
-{
-class QChart;
-}
-
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -68,19 +63,21 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
-    gnss_sdr::Observables readGnssSynchro(char buff[], int bytes);
-    gnss_sdr::MonitorPvt readMonitorPvt(char buff[], int bytes);
     void saveSettings();
     void loadSettings();
 
 public slots:
     void toggleCapture();
-    void receiveGnssSynchro();
-    void receiveMonitorPvt();
+    void drainIngestQueues();
     void clearEntries();
     void quit();
     void showPreferences();
     void setPort();
+    void setRefreshRate();
+    void setRetention();
+    void setMapTiles();
+    void setRecording();
+    void setSatelliteView(bool enabled);
     void expandPlot(const QModelIndex &index);
     void closePlots();
     void deletePlots();
@@ -90,7 +87,18 @@ protected:
     void closeEvent(QCloseEvent *event) override;
 
 private:
-    void updateChart(QtCharts::QChart *chart, QtCharts::QXYSeries *series, const QModelIndex &index);
+    PlotWidget *createChannelPlot(const QModelIndex &index, const QString &title,
+        const QString &xTitle, const QString &yTitle, PlotWidget::SeriesStyle style);
+    void updateTable();
+    void updateIngestStatus();
+    void updateMemoryStatus();
+    void setMemoryBudget();
+
+    QDockWidget *createDock(const QString &title, const std::function<void()> &create);
+    void createTelecommandWidget();
+    void createMapWidget();
+    void createAltitudeWidget();
+    void createDOPWidget();
 
     Ui::MainWindow *ui;
 
@@ -105,27 +113,29 @@ private:
     DOPWidget *m_DOPWidget;
 
     ChannelTableModel *m_model;
-    QUdpSocket *m_socketGnssSynchro;
-    QUdpSocket *m_socketMonitorPvt;
-    gnss_sdr::Observables m_stocks;
+    IngestEngine *m_ingestEngine;
+    QThread m_ingestThread;
+    QLabel *m_ingestStatusLabel;
+    QLabel *m_memoryStatusLabel;
     MonitorPvtWrapper *m_monitorPvtWrapper;
-    gnss_sdr::MonitorPvt m_monitorPvt;
+    TileServer *m_tileServer;
     std::vector<int> m_channels;
     quint16 m_portGnssSynchro;
     quint16 m_portMonitorPvt;
     QSettings m_settings;
-    QTimer m_updateTimer;
+    RefreshScheduler *m_refreshScheduler;
 
     QAction *m_start;
     QAction *m_stop;
     QAction *m_clear;
     QAction *m_closePlotsAction;
+    QAction *m_satelliteViewAction;
 
-    int m_bufferSize;
+    size_t m_memoryBudget;
 
-    std::map<int, QtCharts::QChartView *> m_plotsConstellation;
-    std::map<int, QtCharts::QChartView *> m_plotsCn0;
-    std::map<int, QtCharts::QChartView *> m_plotsDoppler;
+    std::map<int, PlotWidget *> m_plotsConstellation;
+    std::map<int, PlotWidget *> m_plotsCn0;
+    std::map<int, PlotWidget *> m_plotsDoppler;
 };
 
 #endif  // GNSS_SDR_MONITOR_MAIN_WINDOW_H_
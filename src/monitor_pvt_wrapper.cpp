@@ -40,12 +40,13 @@
 MonitorPvtWrapper::MonitorPvtWrapper(QObject *parent) : QObject(parent)
 {
     m_bufferSize = 100;
+    m_unpublished = false;
 
     m_bufferMonitorPvt.resize(m_bufferSize);
     m_bufferMonitorPvt.clear();
 
-    m_path.resize(m_bufferSize);
-    m_path.clear();
+    m_pathModel = new PathModel(this);
+    m_pathModel->setCapacity(m_bufferSize);
 }
 
 /*!
@@ -55,16 +56,29 @@ void MonitorPvtWrapper::addMonitorPvt(const gnss_sdr::MonitorPvt &monitor_pvt)
 {
     m_bufferMonitorPvt.push_back(monitor_pvt);
 
-    Coordinates coord;
-    coord.latitude = monitor_pvt.latitude();
-    coord.longitude = monitor_pvt.longitude();
-    m_path.push_back(coord);
+    // The map is notified by publish(), at most once per refresh.
+    m_pathModel->append(monitor_pvt.latitude(), monitor_pvt.longitude());
+    m_unpublished = true;
 
-    emit dataChanged();
     emit altitudeChanged(monitor_pvt.tow_at_current_symbol_ms(), monitor_pvt.height());
     emit dopChanged(monitor_pvt.tow_at_current_symbol_ms(), monitor_pvt.gdop(), monitor_pvt.pdop(), monitor_pvt.hdop(), monitor_pvt.vdop());
 }
 
+/*!
+ Notifies the map of the positions added since the last call, if any. Only
+ the chunks of the path that changed are notified. It is only called while
+ the map is shown, so a hidden map does not rebuild its path.
+ */
+void MonitorPvtWrapper::publish()
+{
+    if (m_unpublished)
+    {
+        m_unpublished = false;
+        m_pathModel->publish();
+        emit dataChanged();
+    }
+}
+
 /*!
  Gets the last MonitorPvt object.
  */
@@ -73,13 +87,31 @@ gnss_sdr::MonitorPvt MonitorPvtWrapper::getLastMonitorPvt()
     return m_bufferMonitorPvt.back();
 }
 
+/*!
+ Returns the MonitorPvt objects kept, oldest first, so that views created
+ late can catch up with them.
+ */
+const boost::circular_buffer<gnss_sdr::MonitorPvt> &MonitorPvtWrapper::history() const
+{
+    return m_bufferMonitorPvt;
+}
+
+/*!
+ Returns the number of MonitorPvt objects kept.
+ */
+size_t MonitorPvtWrapper::bufferSize() const
+{
+    return m_bufferSize;
+}
+
 /*!
  Clears all the data from the internal data structures.
  */
 void MonitorPvtWrapper::clearData()
 {
     m_bufferMonitorPvt.clear();
-    m_path.clear();
+    m_pathModel->clear();
+    m_unpublished = false;
 
     emit dataChanged();
 }
@@ -89,8 +121,24 @@ void MonitorPvtWrapper::clearData()
  */
 void MonitorPvtWrapper::setBufferSize(size_t size)
 {
+    if (size == m_bufferSize)
+    {
+        return;
+    }
     m_bufferSize = size;
-    m_bufferMonitorPvt.resize(m_bufferSize);
+
+    // The newest messages and positions are kept.
+    m_bufferMonitorPvt.rset_capacity(m_bufferSize);
+    m_pathModel->setCapacity(m_bufferSize);
+    m_unpublished = true;
+}
+
+/*!
+ Returns the number of bytes allocated by the internal circular buffer and the path.
+ */
+size_t MonitorPvtWrapper::memoryUsage() const
+{
+    return m_bufferMonitorPvt.capacity() * sizeof(gnss_sdr::MonitorPvt) + m_pathModel->memoryUsage();
 }
 
 /*!
@@ -110,22 +158,9 @@ QVariant MonitorPvtWrapper::position() const
 }
 
 /*!
- Returns the path formed by the history of recorded positions.
+ Returns the model of the path formed by the history of recorded positions.
  */
-QVariantList MonitorPvtWrapper::path() const
+QObject *MonitorPvtWrapper::pathModel() const
 {
-    if (!m_path.empty())
-    {
-        QVariantList list;
-        for (size_t i = 0; i < m_path.size(); i++)
-        {
-            Coordinates coord = m_path.at(i);
-            list << QVariant::fromValue(QGeoCoordinate(coord.latitude, coord.longitude));
-        }
-        return list;
-    }
-    else
-    {
-        return QVariantList();
-    }
+    return m_pathModel;
 }
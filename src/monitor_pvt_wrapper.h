@@ -34,6 +34,7 @@
 #define GNSS_SDR_MONITOR_MONITOR_PVT_WRAPPER_H_
 
 #include "monitor_pvt.pb.h"
+#include "path_model.h"
 #include <boost/circular_buffer.hpp>
 #include <QObject>
 #include <QVariant>
@@ -42,22 +43,19 @@ class MonitorPvtWrapper : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(QVariant position READ position NOTIFY dataChanged)
-    Q_PROPERTY(QVariantList path READ path NOTIFY dataChanged)
+    Q_PROPERTY(QObject *pathModel READ pathModel CONSTANT)
 
 public:
     explicit MonitorPvtWrapper(QObject *parent = nullptr);
     void addMonitorPvt(const gnss_sdr::MonitorPvt &monitor_pvt);
 
     gnss_sdr::MonitorPvt getLastMonitorPvt();
+    const boost::circular_buffer<gnss_sdr::MonitorPvt> &history() const;
+    size_t bufferSize() const;
+    size_t memoryUsage() const;
 
     QVariant position() const;
-    QVariantList path() const;
-
-    struct Coordinates
-    {
-        double latitude;
-        double longitude;
-    };
+    QObject *pathModel() const;
 
 signals:
     void dataChanged();
@@ -66,12 +64,14 @@ signals:
 
 public slots:
     void clearData();
+    void publish();
     void setBufferSize(size_t size);
 
 private:
     size_t m_bufferSize;
+    bool m_unpublished;
     boost::circular_buffer<gnss_sdr::MonitorPvt> m_bufferMonitorPvt;
-    boost::circular_buffer<Coordinates> m_path;
+    PathModel *m_pathModel;
 };
 
 #endif  // GNSS_SDR_MONITOR_MONITOR_PVT_WRAPPER_H_
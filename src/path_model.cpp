@@ -0,0 +1,482 @@
+/*!
+ * \file path_model.cpp
+ * \brief Implementation of a list model that exposes the path of the
+ * receiver to the map in chunks that are updated incrementally.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "path_model.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+// Positions per chunk, and so per polyline rebuilt when the path grows.
+#define PATH_CHUNK_SIZE 256
+
+// Tolerance of the finest simplified level, in meters. Each level doubles it.
+#define PATH_BASE_TOLERANCE 0.25
+
+// Number of simplified levels. The coarsest one has a tolerance of 8 km.
+#define PATH_LEVEL_COUNT 16
+
+// Largest deviation from the path allowed on the map, in pixels.
+#define PATH_TOLERANCE_PIXELS 0.5
+
+// Level of detail with all the positions, and level of a chunk out of view.
+#define PATH_FULL_DETAIL -1
+#define PATH_HIDDEN -2
+
+// Meters per degree of latitude, and of longitude at the equator.
+#define PATH_METERS_PER_DEGREE 111319.49
+
+// Meters per pixel at zoom level 0 of the map, at the equator.
+#define PATH_METERS_PER_PIXEL 156543.03
+
+PathModel::PathModel(QObject *parent) : QAbstractListModel(parent), m_capacity(0), m_size(0),
+                                        m_level(PATH_FULL_DETAIL), m_hasViewport(false),
+                                        m_minLatitude(0), m_maxLatitude(0),
+                                        m_minLongitude(0), m_maxLongitude(0)
+{
+}
+
+/*!
+ Appends a position to the path. The views are notified by the next publish().
+ */
+void PathModel::append(double latitude, double longitude)
+{
+    if (m_capacity == 0)
+    {
+        return;
+    }
+
+    // The pending buffer holds at most capacity() positions, so a map that is
+    // not shown, and thus not published, does not make it grow.
+    m_pending.push_back({latitude, longitude});
+}
+
+/*!
+ Moves the pending positions into the chunks and notifies the views of the
+ chunks that changed: the last one, the new ones and the trimmed ones.
+ */
+void PathModel::publish()
+{
+    if (m_pending.empty())
+    {
+        return;
+    }
+
+    if (m_pending.full() && !m_chunks.empty())
+    {
+        // The pending positions replace the whole path.
+        beginRemoveRows(QModelIndex(), 0, static_cast<int>(m_chunks.size()) - 1);
+        m_chunks.clear();
+        m_size = 0;
+        endRemoveRows();
+    }
+
+    size_t next = 0;
+
+    // Fill the last chunk first.
+    if (!m_chunks.empty() && m_chunks.back().positions.size() < PATH_CHUNK_SIZE)
+    {
+        Chunk &last = m_chunks.back();
+        while (next < m_pending.size() && last.positions.size() < PATH_CHUNK_SIZE)
+        {
+            add(&last, m_pending[next++]);
+            last.fixes++;
+            m_size++;
+        }
+        rank(&last);
+        if (refresh(&last, true))
+        {
+            QModelIndex lastIndex = index(static_cast<int>(m_chunks.size()) - 1);
+            emit dataChanged(lastIndex, lastIndex, {PathRole});
+        }
+    }
+
+    // Then start new chunks with the rest.
+    if (next < m_pending.size())
+    {
+        std::deque<Chunk> chunks;
+        bool hasJoint = !m_chunks.empty();
+        Position joint = hasJoint ? m_chunks.back().positions.back() : Position();
+        while (next < m_pending.size())
+        {
+            Chunk chunk;
+            chunk.positions.reserve(PATH_CHUNK_SIZE);
+            chunk.fixes = 0;
+            chunk.minLatitude = std::numeric_limits<double>::max();
+            chunk.maxLatitude = -std::numeric_limits<double>::max();
+            chunk.minLongitude = std::numeric_limits<double>::max();
+            chunk.maxLongitude = -std::numeric_limits<double>::max();
+            chunk.level = PATH_HIDDEN;
+            if (hasJoint)
+            {
+                add(&chunk, joint);
+            }
+            while (next < m_pending.size() && chunk.positions.size() < PATH_CHUNK_SIZE)
+            {
+                add(&chunk, m_pending[next++]);
+                chunk.fixes++;
+            }
+            rank(&chunk);
+            refresh(&chunk, true);
+            joint = chunk.positions.back();
+            hasJoint = true;
+            m_size += chunk.fixes;
+            chunks.push_back(std::move(chunk));
+        }
+
+        int first = static_cast<int>(m_chunks.size());
+        beginInsertRows(QModelIndex(), first, first + static_cast<int>(chunks.size()) - 1);
+        std::move(chunks.begin(), chunks.end(), std::back_inserter(m_chunks));
+        endInsertRows();
+    }
+
+    m_pending.clear();
+    trim();
+}
+
+/*!
+ Drops the whole path, including the positions not published yet.
+ */
+void PathModel::clear()
+{
+    beginResetModel();
+    m_chunks.clear();
+    m_size = 0;
+    m_pending.clear();
+    endResetModel();
+}
+
+/*!
+ Sets the number of positions kept. The newest positions are kept, and
+ only the chunks that fall out of the new capacity are removed.
+ */
+void PathModel::setCapacity(size_t capacity)
+{
+    m_capacity = capacity;
+    m_pending.rset_capacity(capacity);
+    trim();
+}
+
+size_t PathModel::capacity() const
+{
+    return m_capacity;
+}
+
+/*!
+ Returns the number of positions held, published or not.
+ */
+size_t PathModel::size() const
+{
+    return m_size + m_pending.size();
+}
+
+/*!
+ Returns an estimate of the number of bytes taken by the positions and their
+ significance, plus the variant and the shared data of each position served.
+ */
+size_t PathModel::memoryUsage() const
+{
+    const size_t perShown = sizeof(QVariant) + sizeof(QGeoCoordinate) + 4 * sizeof(double);
+    size_t usage = m_pending.capacity() * sizeof(Position);
+    for (const Chunk &chunk : m_chunks)
+    {
+        usage += chunk.positions.capacity() * sizeof(Position);
+        usage += chunk.significance.capacity() * sizeof(float);
+        usage += chunk.shown.size() * perShown;
+    }
+    return usage;
+}
+
+/*!
+ Sets the view of the map: its \a zoomLevel and the corners of the area
+ shown. The level of detail is the coarsest one whose tolerance is within
+ PATH_TOLERANCE_PIXELS at that zoom, and the chunks are served if they are
+ within half a view of the area, so that panning does not show them late.
+ If a corner is invalid, as on a tilted map, all the chunks are served.
+ Only the chunks that enter or leave the view, or change level, are
+ rebuilt and notified.
+ */
+void PathModel::setView(double zoomLevel, const QGeoCoordinate &topLeft, const QGeoCoordinate &bottomRight)
+{
+    m_hasViewport = topLeft.isValid() && bottomRight.isValid();
+    double latitude = 0;
+    if (m_hasViewport)
+    {
+        double latitudeMargin = (topLeft.latitude() - bottomRight.latitude()) / 2;
+        m_minLatitude = bottomRight.latitude() - latitudeMargin;
+        m_maxLatitude = topLeft.latitude() + latitudeMargin;
+        latitude = (topLeft.latitude() + bottomRight.latitude()) / 2;
+
+        if (topLeft.longitude() <= bottomRight.longitude())
+        {
+            double longitudeMargin = (bottomRight.longitude() - topLeft.longitude()) / 2;
+            m_minLongitude = topLeft.longitude() - longitudeMargin;
+            m_maxLongitude = bottomRight.longitude() + longitudeMargin;
+        }
+        else
+        {
+            // The view crosses the antimeridian.
+            m_minLongitude = -180;
+            m_maxLongitude = 180;
+        }
+    }
+
+    // Web Mercator scale at the center of the view.
+    double metersPerPixel = PATH_METERS_PER_PIXEL * std::cos(latitude * M_PI / 180) / std::pow(2, zoomLevel);
+    double tolerance = metersPerPixel * PATH_TOLERANCE_PIXELS;
+    if (tolerance < PATH_BASE_TOLERANCE || !std::isfinite(tolerance))
+    {
+        m_level = PATH_FULL_DETAIL;
+    }
+    else
+    {
+        m_level = std::min(static_cast<int>(std::log2(tolerance / PATH_BASE_TOLERANCE)), PATH_LEVEL_COUNT - 1);
+    }
+
+    // Notify the changed chunks in runs of consecutive rows.
+    int first = -1;
+    for (size_t row = 0; row <= m_chunks.size(); row++)
+    {
+        bool changed = row < m_chunks.size() && refresh(&m_chunks[row], false);
+        if (changed && first < 0)
+        {
+            first = static_cast<int>(row);
+        }
+        else if (!changed && first >= 0)
+        {
+            emit dataChanged(index(first), index(static_cast<int>(row) - 1), {PathRole});
+            first = -1;
+        }
+    }
+}
+
+/*!
+ Returns the level of detail served, from PATH_FULL_DETAIL up to
+ PATH_LEVEL_COUNT - 1.
+ */
+int PathModel::level() const
+{
+    return m_level;
+}
+
+/*!
+ Returns the number of positions served to the map.
+ */
+size_t PathModel::shownSize() const
+{
+    size_t size = 0;
+    for (const Chunk &chunk : m_chunks)
+    {
+        size += chunk.shown.size();
+    }
+    return size;
+}
+
+int PathModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_chunks.size());
+}
+
+QVariant PathModel::data(const QModelIndex &index, int role) const
+{
+    if (role != PathRole || index.row() < 0 || static_cast<size_t>(index.row()) >= m_chunks.size())
+    {
+        return QVariant();
+    }
+
+    // The list is implicitly shared, so it is not copied here.
+    return m_chunks[index.row()].shown;
+}
+
+QHash<int, QByteArray> PathModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles[PathRole] = "path";
+    return roles;
+}
+
+/*!
+ Appends \a position to \a chunk and grows its bounding box.
+ */
+void PathModel::add(Chunk *chunk, const Position &position) const
+{
+    chunk->positions.push_back(position);
+    chunk->minLatitude = std::min(chunk->minLatitude, position.latitude);
+    chunk->maxLatitude = std::max(chunk->maxLatitude, position.latitude);
+    chunk->minLongitude = std::min(chunk->minLongitude, position.longitude);
+    chunk->maxLongitude = std::max(chunk->maxLongitude, position.longitude);
+}
+
+/*!
+ Computes the significance of the positions of \a chunk with the
+ Douglas-Peucker algorithm. The position farthest from the segment between
+ the ends of a span gets its distance, capped by the significance of the
+ span, and splits it in two. The ends are always kept. Distances are
+ measured on a plane tangent at the first position, which is accurate over
+ the extent of a chunk.
+ */
+void PathModel::rank(Chunk *chunk) const
+{
+    const std::vector<Position> &positions = chunk->positions;
+    std::vector<float> &significance = chunk->significance;
+    significance.assign(positions.size(), std::numeric_limits<float>::infinity());
+    if (positions.size() < 3)
+    {
+        return;
+    }
+
+    const double scaleY = PATH_METERS_PER_DEGREE;
+    const double scaleX = PATH_METERS_PER_DEGREE * std::cos(positions.front().latitude * M_PI / 180);
+
+    struct Span
+    {
+        size_t first;
+        size_t last;
+        float significance;
+    };
+    std::vector<Span> spans;
+    spans.push_back({0, positions.size() - 1, std::numeric_limits<float>::infinity()});
+
+    while (!spans.empty())
+    {
+        Span span = spans.back();
+        spans.pop_back();
+        if (span.last - span.first < 2)
+        {
+            continue;
+        }
+
+        double ax = positions[span.first].longitude * scaleX;
+        double ay = positions[span.first].latitude * scaleY;
+        double dx = positions[span.last].longitude * scaleX - ax;
+        double dy = positions[span.last].latitude * scaleY - ay;
+        double length2 = dx * dx + dy * dy;
+
+        size_t farthest = span.first + 1;
+        double farthestDistance2 = -1;
+        for (size_t i = span.first + 1; i < span.last; i++)
+        {
+            double px = positions[i].longitude * scaleX - ax;
+            double py = positions[i].latitude * scaleY - ay;
+
+            // Distance to the segment, or to its start if it is degenerate.
+            double t = length2 > 0 ? std::max(0.0, std::min(1.0, (px * dx + py * dy) / length2)) : 0;
+            double ex = px - t * dx;
+            double ey = py - t * dy;
+            double distance2 = ex * ex + ey * ey;
+            if (distance2 > farthestDistance2)
+            {
+                farthest = i;
+                farthestDistance2 = distance2;
+            }
+        }
+
+        float value = std::min(static_cast<float>(std::sqrt(farthestDistance2)), span.significance);
+        significance[farthest] = value;
+        spans.push_back({span.first, farthest, value});
+        spans.push_back({farthest, span.last, value});
+    }
+}
+
+/*!
+ Returns true if the bounding box of \a chunk overlaps the area of the map.
+ */
+bool PathModel::isVisible(const Chunk &chunk) const
+{
+    if (!m_hasViewport)
+    {
+        return true;
+    }
+    return chunk.maxLatitude >= m_minLatitude && chunk.minLatitude <= m_maxLatitude &&
+           chunk.maxLongitude >= m_minLongitude && chunk.minLongitude <= m_maxLongitude;
+}
+
+/*!
+ Rebuilds the positions of \a chunk served to the map if it entered or left
+ the view or its level changed, or always if \a force is set and it is in
+ view. Returns true if they changed.
+ */
+bool PathModel::refresh(Chunk *chunk, bool force) const
+{
+    if (!isVisible(*chunk))
+    {
+        if (chunk->level == PATH_HIDDEN)
+        {
+            return false;
+        }
+        chunk->shown = QVariantList();
+        chunk->level = PATH_HIDDEN;
+        return true;
+    }
+
+    if (!force && chunk->level == m_level)
+    {
+        return false;
+    }
+
+    float threshold = m_level == PATH_FULL_DETAIL ? 0 : static_cast<float>(std::ldexp(PATH_BASE_TOLERANCE, m_level));
+    QVariantList shown;
+    for (size_t i = 0; i < chunk->positions.size(); i++)
+    {
+        if (chunk->significance[i] >= threshold)
+        {
+            shown.append(QVariant::fromValue(QGeoCoordinate(chunk->positions[i].latitude, chunk->positions[i].longitude)));
+        }
+    }
+    chunk->shown = shown;
+    chunk->level = m_level;
+    return true;
+}
+
+/*!
+ Removes the oldest chunks whose positions are all beyond the capacity.
+ */
+void PathModel::trim()
+{
+    size_t count = 0;
+    size_t size = m_size;
+    while (count < m_chunks.size() && size - m_chunks[count].fixes >= m_capacity && size > 0)
+    {
+        size -= m_chunks[count].fixes;
+        count++;
+    }
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), 0, static_cast<int>(count) - 1);
+    m_chunks.erase(m_chunks.begin(), m_chunks.begin() + count);
+    m_size = size;
+    endRemoveRows();
+}
@@ -0,0 +1,132 @@
+/*!
+ * \file path_model.h
+ * \brief Interface of a list model that exposes the path of the receiver
+ * to the map in chunks that are updated incrementally.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#ifndef GNSS_SDR_MONITOR_PATH_MODEL_H_
+#define GNSS_SDR_MONITOR_PATH_MODEL_H_
+
+#include <boost/circular_buffer.hpp>
+#include <QAbstractListModel>
+#include <QGeoCoordinate>
+#include <QVariant>
+#include <deque>
+#include <vector>
+
+/*!
+ The path of the receiver as a list of chunks of up to a fixed number of
+ positions, each one drawn by its own MapPolyline. Positions are appended to
+ a pending buffer and moved into the chunks by publish(), once per refresh,
+ which notifies the views of the last chunk and of the chunks added and
+ removed. A polyline is only rebuilt when its chunk changes, so the cost of a
+ position is bounded by the chunk size instead of the length of the path.
+
+ Each chunk ranks its positions with a Douglas-Peucker hierarchy: the
+ significance of a position is the tolerance, in meters, below which the
+ simplification keeps it. It is computed as the chunk fills, so a chunk can
+ be drawn at any level of detail by filtering its positions. setView() picks
+ the level that matches the zoom of the map, a power of two of a base
+ tolerance, and the chunks outside the viewport are served empty, so only
+ the chunks that enter the view or change level are rebuilt.
+
+ The path keeps at least capacity() positions. The oldest chunk is dropped
+ once all its positions are older than that, so up to a chunk more is shown.
+ Each chunk after the first starts at the last position of the one before,
+ so the polylines join.
+ */
+class PathModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles
+    {
+        PathRole = Qt::UserRole + 1
+    };
+
+    explicit PathModel(QObject *parent = nullptr);
+
+    void append(double latitude, double longitude);
+    void publish();
+    void clear();
+
+    void setCapacity(size_t capacity);
+    size_t capacity() const;
+    size_t size() const;
+    size_t memoryUsage() const;
+
+    Q_INVOKABLE void setView(double zoomLevel, const QGeoCoordinate &topLeft, const QGeoCoordinate &bottomRight);
+    int level() const;
+    size_t shownSize() const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+private:
+    struct Position
+    {
+        double latitude;
+        double longitude;
+    };
+
+    struct Chunk
+    {
+        std::vector<Position> positions;
+        std::vector<float> significance;  // Per position, in meters.
+        size_t fixes;                     // Positions, without the one shared with the previous chunk.
+        double minLatitude;
+        double maxLatitude;
+        double minLongitude;
+        double maxLongitude;
+        QVariantList shown;  // Positions served to the map.
+        int level;           // Level of detail of shown, or PATH_HIDDEN.
+    };
+
+    void add(Chunk *chunk, const Position &position) const;
+    void rank(Chunk *chunk) const;
+    bool isVisible(const Chunk &chunk) const;
+    bool refresh(Chunk *chunk, bool force) const;
+    void trim();
+
+    size_t m_capacity;
+    std::deque<Chunk> m_chunks;
+    size_t m_size;  // Positions in the chunks.
+    boost::circular_buffer<Position> m_pending;
+
+    // Level of detail and area requested by the map.
+    int m_level;
+    bool m_hasViewport;
+    double m_minLatitude;
+    double m_maxLatitude;
+    double m_minLongitude;
+    double m_maxLongitude;
+};
+
+#endif  // GNSS_SDR_MONITOR_PATH_MODEL_H_
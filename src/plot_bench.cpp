@@ -0,0 +1,172 @@
+/*!
+ * \file plot_bench.cpp
+ * \brief Renders a PlotWidget offscreen with a million points per series
+ * and reports its frame times.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "plot_widget.h"
+#include "series_buffer.h"
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QImage>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+/*!
+ Prints the mean, median, 95th percentile and maximum of the frame \a times, in milliseconds.
+ */
+void report(const char *name, std::vector<double> times)
+{
+    std::sort(times.begin(), times.end());
+    double sum = 0;
+    for (double time : times)
+    {
+        sum += time;
+    }
+    double mean = sum / times.size();
+    std::cout << std::left << std::setw(10) << name << std::right << std::setw(10) << mean << std::setw(10)
+              << times[times.size() / 2] << std::setw(10) << times[times.size() * 95 / 100] << std::setw(10) << times.back()
+              << std::setw(10) << 1000 / mean << std::endl;
+}
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+    // Render without a display unless a platform was chosen.
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders the raster plot of gnss-sdr-monitor offscreen with long series "
+                                     "and reports its frame times.");
+    parser.addHelpOption();
+    parser.addOption({"points", "Points per series.", "count", "1000000"});
+    parser.addOption({"lines", "Line series, such as C/N0 or Doppler plots.", "count", "3"});
+    parser.addOption({"scatter", "Point series, such as constellation plots.", "count", "1"});
+    parser.addOption({"frames", "Frames rendered per measurement.", "count", "100"});
+    parser.addOption({"append", "Points appended to each series before each streaming frame.", "count", "50"});
+    parser.addOption({"size", "Size of the plot in pixels.", "WxH", "1280x720"});
+    parser.process(app);
+
+    size_t points = parser.value("points").toULongLong();
+    int lines = parser.value("lines").toInt();
+    int scatter = parser.value("scatter").toInt();
+    int frames = parser.value("frames").toInt();
+    int append = parser.value("append").toInt();
+    QStringList size = parser.value("size").split('x');
+    int width = size.size() == 2 ? size[0].toInt() : 0;
+    int height = size.size() == 2 ? size[1].toInt() : 0;
+    if (points == 0 || lines < 0 || scatter < 0 || lines + scatter == 0 || frames <= 0 || append < 0 || width <= 0 || height <= 0)
+    {
+        parser.showHelp(1);
+    }
+
+    // Random walks, sampled at 50 Hz for the lines, and a noisy cloud for the points.
+    std::mt19937_64 rng(1);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::vector<std::unique_ptr<SeriesBuffer>> buffers;
+    std::vector<double> levels;
+    long sample = 0;
+    auto next = [&]() {
+        for (size_t i = 0; i < buffers.size(); i++)
+        {
+            if (static_cast<int>(i) < lines)
+            {
+                levels[i] += noise(rng);
+                buffers[i]->append(sample / 50.0, levels[i]);
+            }
+            else
+            {
+                buffers[i]->append(1000 * noise(rng), 1000 * noise(rng));
+            }
+        }
+        sample++;
+    };
+
+    PlotWidget plot;
+    plot.resize(width, height);
+    plot.setTitle("Benchmark");
+    plot.setAxisTitles("Time [s]", "Value");
+    for (int i = 0; i < lines + scatter; i++)
+    {
+        buffers.emplace_back(new SeriesBuffer(points));
+        levels.push_back(0);
+        SeriesBuffer *buffer = buffers.back().get();
+        plot.addSeries(QString("Series %1").arg(i + 1), [buffer](const PlotWidget::Viewport &) { return buffer->view(); },
+            i < lines ? PlotWidget::Lines : PlotWidget::Points);
+    }
+    for (size_t i = 0; i < points; i++)
+    {
+        next();
+    }
+
+    QImage image(plot.size(), QImage::Format_ARGB32_Premultiplied);
+    QElapsedTimer timer;
+    auto render = [&]() {
+        timer.start();
+        plot.render(&image);
+        return timer.nsecsElapsed() / 1e6;
+    };
+
+    std::cout << lines << " line and " << scatter << " point series of " << points << " points, " << width << "x"
+              << height << " pixels, " << frames << " frames" << std::endl;
+    std::cout << std::left << std::setw(10) << "frames" << std::right << std::setw(10) << "mean ms" << std::setw(10)
+              << "median" << std::setw(10) << "95%" << std::setw(10) << "max" << std::setw(10) << "fps" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+
+    // The same data every frame, as when the view is repainted for another reason.
+    std::vector<double> times;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        times.push_back(render());
+    }
+    report("static", times);
+
+    // New points every frame, as when the receiver is running.
+    times.clear();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (int i = 0; i < append; i++)
+        {
+            next();
+        }
+        times.push_back(render());
+    }
+    report("streaming", times);
+    return 0;
+}
@@ -0,0 +1,677 @@
+/*!
+ * \file plot_widget.cpp
+ * \brief Implementation of a lightweight raster plot widget for long time
+ * series.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "plot_widget.h"
+#include "series_decimator.h"
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPixmap>
+#include <QWheelEvent>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Colors given to the series that are added without one.
+#define PLOT_DEFAULT_COLORS {"#1f77b4", "#ff7f0e", "#2ca02c", "#d62728", "#9467bd", "#8c564b"}
+
+// Zoom factor per degree of wheel rotation.
+#define PLOT_ZOOM_PER_DEGREE 1.01
+
+// Smallest horizontal range, relative to the values, that can be zoomed into.
+#define PLOT_MIN_RELATIVE_RANGE 1e-9
+
+// Relative margin added above and below the data when following it.
+#define PLOT_VERTICAL_MARGIN 0.05
+
+/*!
+ Constructs an empty plot.
+ */
+PlotWidget::PlotWidget(QWidget *parent) : QWidget(parent)
+{
+    m_legendVisible = false;
+    m_markerSize = 8;
+
+    m_followData = true;
+    m_minX = 0;
+    m_maxX = 1;
+    m_minY = 0;
+    m_maxY = 1;
+
+    m_paintedKey = 0;
+    m_dragging = false;
+    m_dragMinX = 0;
+    m_dragMaxX = 0;
+    m_dragMinY = 0;
+    m_dragMaxY = 0;
+
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setBackgroundRole(QPalette::Base);
+}
+
+/*!
+ Adds a series called \a name whose samples are returned by \a source, and
+ returns its index. If \a color is not valid, one is picked.
+ */
+int PlotWidget::addSeries(const QString &name, const SeriesSource &source, SeriesStyle style, const QColor &color)
+{
+    static const char *colors[] = PLOT_DEFAULT_COLORS;
+    static const size_t colorCount = sizeof(colors) / sizeof(colors[0]);
+
+    Series series;
+    series.name = name;
+    series.source = source;
+    series.style = style;
+    series.color = color.isValid() ? color : QColor(colors[m_series.size() % colorCount]);
+    m_series.push_back(series);
+
+    update();
+    return static_cast<int>(m_series.size()) - 1;
+}
+
+int PlotWidget::seriesCount() const
+{
+    return static_cast<int>(m_series.size());
+}
+
+void PlotWidget::setTitle(const QString &title)
+{
+    m_title = title;
+    update();
+}
+
+void PlotWidget::setAxisTitles(const QString &xTitle, const QString &yTitle)
+{
+    m_xTitle = xTitle;
+    m_yTitle = yTitle;
+    update();
+}
+
+void PlotWidget::setLegendVisible(bool visible)
+{
+    m_legendVisible = visible;
+    update();
+}
+
+/*!
+ Sets the diameter, in pixels, of the markers of point series.
+ */
+void PlotWidget::setMarkerSize(int size)
+{
+    m_markerSize = std::max(size, 1);
+    update();
+}
+
+QSize PlotWidget::sizeHint() const
+{
+    return QSize(400, 180);
+}
+
+/*!
+ Schedules a repaint if the data of any series changed since the last frame.
+ Meant to be called on every refresh tick.
+ */
+void PlotWidget::refresh()
+{
+    std::vector<SeriesView> views;
+    readSeries(&views);
+
+    if (dataKey(views) != m_paintedKey)
+    {
+        update();
+    }
+}
+
+/*!
+ Makes the axes follow the range of the data again.
+ */
+void PlotWidget::resetView()
+{
+    m_followData = true;
+    update();
+}
+
+void PlotWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    std::vector<SeriesView> views;
+    readSeries(&views);
+
+    if (m_followData)
+    {
+        fitToData(views);
+    }
+
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().color(QPalette::Base));
+
+    int xDecimals = 0;
+    int yDecimals = 0;
+    std::vector<double> yTicks = ticks(m_minY, m_maxY, std::max(height() / (3 * fontMetrics().height()), 2), &yDecimals);
+    QRect area = plotArea(yTicks, yDecimals);
+    std::vector<double> xTicks = ticks(m_minX, m_maxX, std::max(area.width() / (fontMetrics().width("0000000.0") + fontMetrics().height()), 2), &xDecimals);
+
+    drawAxes(&painter, area, xTicks, xDecimals, yTicks, yDecimals);
+
+    if (area.width() > 0 && area.height() > 0)
+    {
+        painter.save();
+        painter.setClipRect(area);
+        for (size_t i = 0; i < m_series.size(); i++)
+        {
+            if (views[i].empty())
+            {
+                continue;
+            }
+
+            if (m_series[i].style == Lines)
+            {
+                drawLines(&painter, area, views[i], m_series[i].color);
+            }
+            else
+            {
+                drawPoints(&painter, area, views[i], m_series[i].color);
+            }
+        }
+        painter.restore();
+    }
+
+    if (m_legendVisible)
+    {
+        drawLegend(&painter, area);
+    }
+
+    m_area = area;
+    m_paintedKey = dataKey(views);
+}
+
+/*!
+ Zooms in or out around the mouse position. With shift held, only the horizontal axis is zoomed.
+ */
+void PlotWidget::wheelEvent(QWheelEvent *event)
+{
+    if (m_area.width() <= 0 || m_area.height() <= 0)
+    {
+        return;
+    }
+
+    double factor = std::pow(PLOT_ZOOM_PER_DEGREE, -event->angleDelta().y() / 8.0);
+    QPoint position = event->pos();
+
+    double x = m_minX + (m_maxX - m_minX) * (position.x() - m_area.left()) / m_area.width();
+    if (factor < 1 && (m_maxX - m_minX) < PLOT_MIN_RELATIVE_RANGE * std::max(1.0, std::abs(x)))
+    {
+        // Zooming in further would run out of floating point precision.
+        return;
+    }
+
+    m_minX = x - (x - m_minX) * factor;
+    m_maxX = x + (m_maxX - x) * factor;
+
+    if (!(event->modifiers() & Qt::ShiftModifier))
+    {
+        double y = m_maxY - (m_maxY - m_minY) * (position.y() - m_area.top()) / m_area.height();
+        m_minY = y - (y - m_minY) * factor;
+        m_maxY = y + (m_maxY - y) * factor;
+    }
+
+    m_followData = false;
+    event->accept();
+    update();
+}
+
+void PlotWidget::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton)
+    {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+
+    m_dragging = true;
+    m_dragOrigin = event->pos();
+    m_dragMinX = m_minX;
+    m_dragMaxX = m_maxX;
+    m_dragMinY = m_minY;
+    m_dragMaxY = m_maxY;
+    setCursor(Qt::ClosedHandCursor);
+}
+
+/*!
+ Pans the plot so that the point grabbed by the mouse follows it.
+ */
+void PlotWidget::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!m_dragging || m_area.width() <= 0 || m_area.height() <= 0)
+    {
+        QWidget::mouseMoveEvent(event);
+        return;
+    }
+
+    QPoint delta = event->pos() - m_dragOrigin;
+    double dx = delta.x() * (m_dragMaxX - m_dragMinX) / m_area.width();
+    double dy = delta.y() * (m_dragMaxY - m_dragMinY) / m_area.height();
+
+    m_minX = m_dragMinX - dx;
+    m_maxX = m_dragMaxX - dx;
+    m_minY = m_dragMinY + dy;
+    m_maxY = m_dragMaxY + dy;
+
+    m_followData = false;
+    update();
+}
+
+void PlotWidget::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton && m_dragging)
+    {
+        m_dragging = false;
+        unsetCursor();
+    }
+    else
+    {
+        QWidget::mouseReleaseEvent(event);
+    }
+}
+
+void PlotWidget::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    Q_UNUSED(event);
+    resetView();
+}
+
+/*!
+ Reads every series for the range currently shown, or for all of the data
+ while following it.
+ */
+void PlotWidget::readSeries(std::vector<SeriesView> *views) const
+{
+    Viewport viewport;
+    viewport.minX = m_followData ? -std::numeric_limits<double>::infinity() : m_minX;
+    viewport.maxX = m_followData ? std::numeric_limits<double>::infinity() : m_maxX;
+    viewport.width = m_area.width() > 0 ? m_area.width() : width();
+
+    views->clear();
+    views->reserve(m_series.size());
+    for (const Series &series : m_series)
+    {
+        views->push_back(series.source(viewport));
+    }
+}
+
+/*!
+ Combines the generations of the series, so that any change to their data changes the result.
+ */
+uint64_t PlotWidget::dataKey(const std::vector<SeriesView> &views) const
+{
+    uint64_t key = 0;
+    for (const SeriesView &view : views)
+    {
+        key = key * 1000003 + view.generation + view.size();
+    }
+    return key;
+}
+
+/*!
+ Sets the visible ranges to those of the data. The ranges are read from the
+ extrema kept by the rings, without scanning the samples.
+ */
+void PlotWidget::fitToData(const std::vector<SeriesView> &views)
+{
+    double minX = std::numeric_limits<double>::max();
+    double maxX = -std::numeric_limits<double>::max();
+    double minY = std::numeric_limits<double>::max();
+    double maxY = -std::numeric_limits<double>::max();
+
+    for (const SeriesView &view : views)
+    {
+        if (!view.empty())
+        {
+            minX = std::min(minX, view.x.minimum());
+            maxX = std::max(maxX, view.x.maximum());
+            minY = std::min(minY, view.low.empty() ? view.y.minimum() : view.low.minimum());
+            maxY = std::max(maxY, view.high.empty() ? view.y.maximum() : view.high.maximum());
+        }
+    }
+
+    if (minX > maxX)
+    {
+        // No data.
+        return;
+    }
+
+    // Degenerate ranges are widened so that the data is drawn in the middle.
+    if (!(maxX > minX))
+    {
+        minX -= 0.5;
+        maxX += 0.5;
+    }
+    if (!(maxY > minY))
+    {
+        minY -= 0.5;
+        maxY += 0.5;
+    }
+
+    double margin = (maxY - minY) * PLOT_VERTICAL_MARGIN;
+
+    m_minX = minX;
+    m_maxX = maxX;
+    m_minY = minY - margin;
+    m_maxY = maxY + margin;
+}
+
+/*!
+ Returns the area of the widget left for the data once the title, the axis
+ titles and the tick labels have been laid out.
+ */
+QRect PlotWidget::plotArea(const std::vector<double> &yTicks, int yDecimals) const
+{
+    QFontMetrics metrics = fontMetrics();
+    int em = metrics.height();
+
+    int labelWidth = 0;
+    for (double tick : yTicks)
+    {
+        labelWidth = std::max(labelWidth, metrics.width(QString::number(tick, 'f', yDecimals)));
+    }
+
+    int left = em / 2 + labelWidth + em / 2;
+    if (!m_yTitle.isEmpty())
+    {
+        left += em + em / 4;
+    }
+
+    int top = m_title.isEmpty() ? em : 2 * em;
+    int bottom = em + em / 2;
+    if (!m_xTitle.isEmpty())
+    {
+        bottom += em;
+    }
+
+    return QRect(left, top, width() - left - em, height() - top - bottom);
+}
+
+/*!
+ Draws the title, the frame of the plot \a area, the grid lines at the ticks and their labels, and the axis titles.
+ */
+void PlotWidget::drawAxes(QPainter *painter, const QRect &area, const std::vector<double> &xTicks, int xDecimals,
+    const std::vector<double> &yTicks, int yDecimals)
+{
+    QFontMetrics metrics = fontMetrics();
+    int em = metrics.height();
+    QColor textColor = palette().color(QPalette::Text);
+    QColor gridColor = palette().color(QPalette::Mid);
+    gridColor.setAlpha(80);
+
+    painter->save();
+
+    if (!m_title.isEmpty())
+    {
+        QFont font = painter->font();
+        font.setBold(true);
+        painter->setFont(font);
+        painter->setPen(textColor);
+        painter->drawText(QRect(0, 0, width(), area.top()), Qt::AlignCenter, m_title);
+        painter->setFont(this->font());
+    }
+
+    if (area.width() <= 0 || area.height() <= 0)
+    {
+        painter->restore();
+        return;
+    }
+
+    double scaleX = area.width() / (m_maxX - m_minX);
+    double scaleY = area.height() / (m_maxY - m_minY);
+
+    for (double tick : xTicks)
+    {
+        int x = area.left() + static_cast<int>(std::lround((tick - m_minX) * scaleX));
+        painter->setPen(gridColor);
+        painter->drawLine(x, area.top(), x, area.bottom());
+        painter->setPen(textColor);
+        painter->drawText(QRect(x - 4 * em, area.bottom() + em / 4, 8 * em, em), Qt::AlignHCenter | Qt::AlignTop,
+            QString::number(tick, 'f', xDecimals));
+    }
+
+    for (double tick : yTicks)
+    {
+        int y = area.bottom() - static_cast<int>(std::lround((tick - m_minY) * scaleY));
+        painter->setPen(gridColor);
+        painter->drawLine(area.left(), y, area.right(), y);
+        painter->setPen(textColor);
+        painter->drawText(QRect(0, y - em / 2, area.left() - em / 2, em), Qt::AlignRight | Qt::AlignVCenter,
+            QString::number(tick, 'f', yDecimals));
+    }
+
+    painter->setPen(textColor);
+    painter->drawRect(area);
+
+    if (!m_xTitle.isEmpty())
+    {
+        painter->drawText(QRect(area.left(), height() - em - em / 4, area.width(), em), Qt::AlignCenter, m_xTitle);
+    }
+
+    if (!m_yTitle.isEmpty())
+    {
+        painter->translate(em / 4, area.top() + area.height() / 2);
+        painter->rotate(-90);
+        painter->drawText(QRect(-area.height() / 2, 0, area.height(), em), Qt::AlignCenter, m_yTitle);
+    }
+
+    painter->restore();
+}
+
+/*!
+ Draws \a series as a polyline, over the band of its minimum and maximum if it
+ has one. Only the samples inside the horizontal range, plus one on each side
+ so the line reaches the edges, are decimated and drawn.
+ */
+void PlotWidget::drawLines(QPainter *painter, const QRect &area, const SeriesView &series, const QColor &color)
+{
+    // The samples are sorted by x, so the visible ones are found by bisection.
+    size_t first = 0;
+    size_t last = series.size();
+    while (first < last)
+    {
+        size_t middle = first + (last - first) / 2;
+        if (series.x[middle] < m_minX)
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+
+    size_t end = first;
+    last = series.size();
+    while (end < last)
+    {
+        size_t middle = end + (last - end) / 2;
+        if (series.x[middle] <= m_maxX)
+        {
+            end = middle + 1;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+
+    first = first > 0 ? first - 1 : 0;
+    end = std::min(end + 1, series.size());
+
+    double scaleX = area.width() / (m_maxX - m_minX);
+    double scaleY = area.height() / (m_maxY - m_minY);
+
+    if (!series.low.empty() && end > first)
+    {
+        // The source picked a tier with a couple of points per pixel column
+        // at most, so the band is drawn from all of them.
+        m_points.resize(static_cast<int>(2 * (end - first)));
+        QPointF *points = m_points.data();
+        for (size_t i = first; i < end; i++)
+        {
+            *points++ = QPointF(area.left() + (series.x[i] - m_minX) * scaleX,
+                area.bottom() - (series.high[i] - m_minY) * scaleY);
+        }
+        for (size_t i = end; i-- > first;)
+        {
+            *points++ = QPointF(area.left() + (series.x[i] - m_minX) * scaleX,
+                area.bottom() - (series.low[i] - m_minY) * scaleY);
+        }
+
+        QColor bandColor = color;
+        bandColor.setAlpha(60);
+        painter->setRenderHint(QPainter::Antialiasing, false);
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(bandColor);
+        painter->drawPolygon(m_points.constData(), m_points.size());
+        painter->setBrush(Qt::NoBrush);
+    }
+
+    SeriesDecimator::m4(series, first, end, m_minX, m_maxX, area.width(), &m_indices);
+
+    m_points.resize(static_cast<int>(m_indices.size()));
+    QPointF *points = m_points.data();
+    for (size_t i : m_indices)
+    {
+        *points++ = QPointF(area.left() + (series.x[i] - m_minX) * scaleX,
+            area.bottom() - (series.y[i] - m_minY) * scaleY);
+    }
+
+    painter->setRenderHint(QPainter::Antialiasing, true);
+    painter->setPen(QPen(color, 1.5));
+    painter->drawPolyline(m_points.constData(), m_points.size());
+}
+
+/*!
+ Draws \a series as round markers. Samples that would land on the same
+ marker-sized cell are drawn once, and each marker is a blit of a prerendered pixmap.
+ */
+void PlotWidget::drawPoints(QPainter *painter, const QRect &area, const SeriesView &series, const QColor &color)
+{
+    int cell = std::max(m_markerSize / 2, 1);
+    SeriesDecimator::pixelGrid(series, m_minX, m_maxX, m_minY, m_maxY,
+        area.width() / cell, area.height() / cell, &m_indices);
+
+    qreal ratio = devicePixelRatioF();
+    QPixmap marker(QSize(m_markerSize, m_markerSize) * ratio);
+    marker.setDevicePixelRatio(ratio);
+    marker.fill(Qt::transparent);
+    {
+        QPainter markerPainter(&marker);
+        markerPainter.setRenderHint(QPainter::Antialiasing, true);
+        markerPainter.setPen(Qt::NoPen);
+        markerPainter.setBrush(color);
+        markerPainter.drawEllipse(QRectF(0, 0, m_markerSize, m_markerSize));
+    }
+
+    double scaleX = area.width() / (m_maxX - m_minX);
+    double scaleY = area.height() / (m_maxY - m_minY);
+    double radius = m_markerSize / 2.0;
+
+    for (size_t i : m_indices)
+    {
+        painter->drawPixmap(QPointF(area.left() + (series.x[i] - m_minX) * scaleX - radius,
+                                area.bottom() - (series.y[i] - m_minY) * scaleY - radius),
+            marker);
+    }
+}
+
+/*!
+ Draws the name and color of every series in the top right corner of the plot \a area.
+ */
+void PlotWidget::drawLegend(QPainter *painter, const QRect &area)
+{
+    QFontMetrics metrics = fontMetrics();
+    int em = metrics.height();
+
+    int textWidth = 0;
+    for (const Series &series : m_series)
+    {
+        textWidth = std::max(textWidth, metrics.width(series.name));
+    }
+
+    QRect box(area.right() - textWidth - 3 * em, area.top() + em / 2,
+        textWidth + 5 * em / 2, static_cast<int>(m_series.size()) * em + em / 2);
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing, false);
+
+    QColor background = palette().color(QPalette::Base);
+    background.setAlpha(200);
+    painter->setPen(palette().color(QPalette::Mid));
+    painter->setBrush(background);
+    painter->drawRect(box);
+
+    for (size_t i = 0; i < m_series.size(); i++)
+    {
+        int y = box.top() + em / 4 + static_cast<int>(i) * em;
+        painter->fillRect(QRect(box.left() + em / 2, y + em / 2 - 1, em, 3), m_series[i].color);
+        painter->setPen(palette().color(QPalette::Text));
+        painter->drawText(QRect(box.left() + 2 * em, y, textWidth, em), Qt::AlignLeft | Qt::AlignVCenter, m_series[i].name);
+    }
+
+    painter->restore();
+}
+
+/*!
+ Returns at most about \a maxCount evenly spaced round values between \a min
+ and \a max, and in \a decimals the number of decimals needed to print them.
+ */
+std::vector<double> PlotWidget::ticks(double min, double max, int maxCount, int *decimals)
+{
+    std::vector<double> result;
+    *decimals = 0;
+    if (!(max > min) || maxCount < 1)
+    {
+        return result;
+    }
+
+    // The step is 1, 2 or 5 times a power of ten.
+    double rawStep = (max - min) / maxCount;
+    double magnitude = std::pow(10.0, std::floor(std::log10(rawStep)));
+    double residual = rawStep / magnitude;
+    double step = magnitude * (residual > 5 ? 10 : residual > 2 ? 5 : residual > 1 ? 2 : 1);
+
+    *decimals = std::max(0, static_cast<int>(-std::floor(std::log10(step))));
+
+    // The bound on i stops the loop when the values are too large for the step to change them.
+    double first = std::ceil(min / step);
+    for (int i = 0; (first + i) * step <= max && i <= 2 * maxCount; i++)
+    {
+        result.push_back((first + i) * step);
+    }
+    return result;
+}
@@ -0,0 +1,161 @@
+/*!
+ * \file plot_widget.h
+ * \brief Interface of a lightweight raster plot widget for long time
+ * series.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#ifndef GNSS_SDR_MONITOR_PLOT_WIDGET_H_
+#define GNSS_SDR_MONITOR_PLOT_WIDGET_H_
+
+#include "channel_history_store.h"
+#include <QColor>
+#include <QPointF>
+#include <QVector>
+#include <QWidget>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/*!
+ Plots one or more series read in place from history rings, with QPainter on
+ the raster engine.
+
+ Each paint only touches the samples that can show up on screen: line series
+ are reduced with M4 decimation to at most four points per pixel column, and
+ point series to one point per marker-sized cell, so the cost of a frame is
+ bound by the size of the widget rather than by the length of the series.
+ The axes follow the range of the data, read from the incremental extrema of
+ the rings, until the user pans (drag) or zooms (wheel, shift for the
+ horizontal axis only). A double click goes back to following the data.
+
+ Sources are told the horizontal range and width being drawn, so one that
+ keeps its history at several resolutions can hand out the one that fits.
+ Points that summarize several samples are drawn over a band spanning their
+ minimum and maximum.
+ */
+class PlotWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    enum SeriesStyle
+    {
+        Lines,  // The samples must be sorted by x.
+        Points
+    };
+
+    // Horizontal range and width, in pixels, that a series is read for. The
+    // range is infinite while the plot follows the data.
+    struct Viewport
+    {
+        double minX;
+        double maxX;
+        int width;
+    };
+
+    // Returns the samples of a series. It is called when the plot is refreshed
+    // and painted, and the view only needs to stay valid until it returns.
+    typedef std::function<SeriesView(const Viewport &)> SeriesSource;
+
+    explicit PlotWidget(QWidget *parent = nullptr);
+
+    int addSeries(const QString &name, const SeriesSource &source, SeriesStyle style = Lines, const QColor &color = QColor());
+    int seriesCount() const;
+
+    void setTitle(const QString &title);
+    void setAxisTitles(const QString &xTitle, const QString &yTitle);
+    void setLegendVisible(bool visible);
+    void setMarkerSize(int size);
+
+    QSize sizeHint() const override;
+
+public slots:
+    void refresh();
+    void resetView();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+    struct Series
+    {
+        QString name;
+        SeriesSource source;
+        SeriesStyle style;
+        QColor color;
+    };
+
+    void readSeries(std::vector<SeriesView> *views) const;
+    uint64_t dataKey(const std::vector<SeriesView> &views) const;
+    void fitToData(const std::vector<SeriesView> &views);
+    QRect plotArea(const std::vector<double> &yTicks, int yDecimals) const;
+
+    void drawAxes(QPainter *painter, const QRect &area, const std::vector<double> &xTicks, int xDecimals,
+        const std::vector<double> &yTicks, int yDecimals);
+    void drawLines(QPainter *painter, const QRect &area, const SeriesView &series, const QColor &color);
+    void drawPoints(QPainter *painter, const QRect &area, const SeriesView &series, const QColor &color);
+    void drawLegend(QPainter *painter, const QRect &area);
+
+    static std::vector<double> ticks(double min, double max, int maxCount, int *decimals);
+
+    std::vector<Series> m_series;
+
+    QString m_title;
+    QString m_xTitle;
+    QString m_yTitle;
+    bool m_legendVisible;
+    int m_markerSize;
+
+    // Visible ranges, in data coordinates.
+    bool m_followData;
+    double m_minX;
+    double m_maxX;
+    double m_minY;
+    double m_maxY;
+
+    uint64_t m_paintedKey;  // Data the last frame was painted from.
+    QRect m_area;           // Plot area of the last frame, to map mouse positions.
+
+    bool m_dragging;
+    QPoint m_dragOrigin;
+    double m_dragMinX;
+    double m_dragMaxX;
+    double m_dragMinY;
+    double m_dragMaxY;
+
+    // Scratch buffers reused between frames.
+    std::vector<size_t> m_indices;
+    QVector<QPointF> m_points;
+};
+
+#endif  // GNSS_SDR_MONITOR_PLOT_WIDGET_H_
@@ -31,6 +31,7 @@
 
 
 #include "preferences_dialog.h"
+#include "datagram_receiver.h"
 #include "ui_preferences_dialog.h"
 #include <QDebug>
 #include <QSettings>
@@ -42,9 +43,26 @@ PreferencesDialog::PreferencesDialog(QWidget *parent) : QDialog(parent),
 
     QSettings settings;
     settings.beginGroup("Preferences_Dialog");
-    ui->buffer_size_spinBox->setValue(settings.value("buffer_size", 1000).toInt());
+    // The per-field retentions default to the former single buffer size.
+    int bufferSize = settings.value("buffer_size", 1000).toInt();
+    ui->retention_prompt_spinBox->setValue(settings.value("retention_prompt", bufferSize).toInt());
+    ui->retention_cn0_spinBox->setValue(settings.value("retention_cn0", bufferSize).toInt());
+    ui->retention_doppler_spinBox->setValue(settings.value("retention_doppler", bufferSize).toInt());
+    ui->retention_pvt_spinBox->setValue(settings.value("retention_pvt", bufferSize).toInt());
+    ui->memory_budget_spinBox->setValue(settings.value("memory_budget", 0).toInt());
+    ui->satellite_timeout_spinBox->setValue(settings.value("satellite_timeout", 600).toInt());
     ui->port_gnss_synchro_spinBox->setValue(settings.value("port_gnss_synchro", 1111).toInt());
     ui->port_monitor_pvt_spinBox->setValue(settings.value("port_monitor_pvt", 1112).toInt());
+    ui->receive_backend_comboBox->setCurrentIndex(settings.value("receive_backend", DatagramReceiver::QtSocketBackend).toInt());
+    ui->refresh_rate_spinBox->setValue(settings.value("refresh_rate", 10).toInt());
+    ui->map_tile_package_lineEdit->setText(settings.value("map_tile_package", QString()).toString());
+    ui->map_tile_upstream_lineEdit->setText(settings.value("map_tile_upstream",
+                                                            "https://server.arcgisonline.com/ArcGIS/rest/services/World_Imagery/MapServer/tile/{z}/{y}/{x}")
+                                                .toString());
+    ui->map_memory_cache_spinBox->setValue(settings.value("map_memory_cache", 32).toInt());
+    ui->map_disk_cache_spinBox->setValue(settings.value("map_disk_cache", 512).toInt());
+    ui->record_directory_lineEdit->setText(settings.value("record_directory", QString()).toString());
+    ui->record_segment_size_spinBox->setValue(settings.value("record_segment_size", 64).toInt());
     settings.endGroup();
 
     connect(this, &PreferencesDialog::accepted, this, &PreferencesDialog::onAccept);
@@ -59,9 +77,22 @@ void PreferencesDialog::onAccept()
 {
     QSettings settings;
     settings.beginGroup("Preferences_Dialog");
-    settings.setValue("buffer_size", ui->buffer_size_spinBox->value());
+    settings.setValue("retention_prompt", ui->retention_prompt_spinBox->value());
+    settings.setValue("retention_cn0", ui->retention_cn0_spinBox->value());
+    settings.setValue("retention_doppler", ui->retention_doppler_spinBox->value());
+    settings.setValue("retention_pvt", ui->retention_pvt_spinBox->value());
+    settings.setValue("memory_budget", ui->memory_budget_spinBox->value());
+    settings.setValue("satellite_timeout", ui->satellite_timeout_spinBox->value());
     settings.setValue("port_gnss_synchro", ui->port_gnss_synchro_spinBox->value());
     settings.setValue("port_monitor_pvt", ui->port_monitor_pvt_spinBox->value());
+    settings.setValue("receive_backend", ui->receive_backend_comboBox->currentIndex());
+    settings.setValue("refresh_rate", ui->refresh_rate_spinBox->value());
+    settings.setValue("map_tile_package", ui->map_tile_package_lineEdit->text().trimmed());
+    settings.setValue("map_tile_upstream", ui->map_tile_upstream_lineEdit->text().trimmed());
+    settings.setValue("map_memory_cache", ui->map_memory_cache_spinBox->value());
+    settings.setValue("map_disk_cache", ui->map_disk_cache_spinBox->value());
+    settings.setValue("record_directory", ui->record_directory_lineEdit->text().trimmed());
+    settings.setValue("record_segment_size", ui->record_segment_size_spinBox->value());
     settings.endGroup();
 
     qDebug() << "Preferences Saved";
@@ -14,27 +14,69 @@ Map
     id: map
     height: 300
 
+    // Tiles come from the local tile server of the monitor, which caches
+    // them on disk and works offline from a tile package.
     plugin: Plugin
     {
         id: mapPlugin
-        name: "esri"
+        name: "osm"
 
         PluginParameter
         {
-            name: "esri.mapping.maximumZoomLevel"
-            value: 19.90
+            name: "osm.mapping.custom.host"
+            value: m_tile_server_url
+        }
+
+        PluginParameter
+        {
+            name: "osm.mapping.providersrepository.disabled"
+            value: true
+        }
+
+        PluginParameter // The tile server has its own disk cache.
+        {
+            name: "osm.mapping.cache.disk.size"
+            value: 0
         }
     }
     center: cttc
     zoomLevel: 15
 
-    MapPolyline // Path of the vehicle.
+    // The path is served at the level of detail of the zoom, and only around
+    // the area shown.
+    function updatePathView()
+    {
+        m_monitor_pvt_wrapper.pathModel.setView(zoomLevel, toCoordinate(Qt.point(0, 0)),
+                                                toCoordinate(Qt.point(width, height)));
+    }
+
+    onZoomLevelChanged: updatePathView()
+    onCenterChanged: updatePathView()
+    onWidthChanged: updatePathView()
+    onHeightChanged: updatePathView()
+    Component.onCompleted:
     {
-        line.width: 3
-        line.color: "red"
-        opacity: 0.3
-        path: m_monitor_pvt_wrapper.path
-        visible: show_path.checked
+        for (var i = 0; i < supportedMapTypes.length; i++)
+        {
+            if (supportedMapTypes[i].style === MapType.CustomMap)
+            {
+                activeMapType = supportedMapTypes[i];
+            }
+        }
+        updatePathView();
+    }
+
+    MapItemView // Path of the vehicle, one polyline per chunk.
+    {
+        model: m_monitor_pvt_wrapper.pathModel
+        delegate: MapPolyline
+        {
+            line.width: 3
+            line.color: "red"
+            opacity: 0.3
+            path: model.path
+            visible: show_path.checked
+        }
     }
 
     MapQuickItem // Current position of the vehicle.
@@ -0,0 +1,283 @@
+/*!
+ * \file receive_bench.cpp
+ * \brief Benchmark that compares the receive backends of the monitor sockets
+ * on datagrams sent over the loopback interface.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+// The libc functions counted below must not be replaced by inline fortified versions.
+#undef _FORTIFY_SOURCE
+
+#include "datagram_receiver.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QUdpSocket>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#if defined(Q_OS_UNIX)
+#include <ctime>
+#endif
+
+#if defined(Q_OS_LINUX)
+#include <dlfcn.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#endif
+
+// Same slab as the ingest engine.
+#define BENCH_BATCH_SIZE 16
+#define BENCH_MAX_DATAGRAM_SIZE 65536
+
+// Time left to the receiver to drain its socket after the sender stops.
+#define BENCH_DRAIN_MS 200
+
+// Syscalls made by the thread that receives, while it is measured.
+static thread_local bool t_counting = false;
+static thread_local quint64 t_syscalls = 0;
+
+#if defined(Q_OS_LINUX)
+// The receive and poll calls of libc are wrapped to count them, whether they
+// are made by the backends or by the Qt event loop. Other libc calls are not
+// on the receive path.
+#define BENCH_COUNTED(ret, name, params, args)                                                     \
+    extern "C" ret name params                                                                    \
+    {                                                                                             \
+        static ret(*real) params = reinterpret_cast<ret(*) params>(dlsym(RTLD_NEXT, #name)); \
+        if (t_counting)                                                                           \
+        {                                                                                         \
+            t_syscalls++;                                                                         \
+        }                                                                                         \
+        return real args;                                                                         \
+    }
+
+BENCH_COUNTED(ssize_t, recv, (int fd, void *buffer, size_t length, int flags), (fd, buffer, length, flags))
+BENCH_COUNTED(ssize_t, recvfrom, (int fd, void *buffer, size_t length, int flags, sockaddr *address, socklen_t *addressLength), (fd, buffer, length, flags, address, addressLength))
+BENCH_COUNTED(ssize_t, recvmsg, (int fd, msghdr *message, int flags), (fd, message, flags))
+BENCH_COUNTED(int, recvmmsg, (int fd, mmsghdr *messages, unsigned int count, int flags, timespec *timeout), (fd, messages, count, flags, timeout))
+BENCH_COUNTED(int, poll, (pollfd * fds, nfds_t count, int timeout), (fds, count, timeout))
+BENCH_COUNTED(int, ppoll, (pollfd * fds, nfds_t count, const timespec *timeout, const sigset_t *mask), (fds, count, timeout, mask))
+BENCH_COUNTED(int, epoll_wait, (int fd, epoll_event *events, int count, int timeout), (fd, events, count, timeout))
+#endif
+
+struct BenchResult
+{
+    quint64 sent;
+    quint64 received;
+    quint64 receiveCalls;
+    quint64 syscalls;
+    double cpuSeconds;
+};
+
+/*!
+ Returns the CPU time of the calling thread in seconds, or a negative value
+ where it cannot be measured.
+ */
+static double threadCpuTime()
+{
+#if defined(Q_OS_UNIX)
+    timespec now;
+    if (::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) == 0)
+    {
+        return now.tv_sec + now.tv_nsec / 1e9;
+    }
+#endif
+    return -1;
+}
+
+/*!
+ Sends datagrams of \a size bytes to \a port on the loopback interface for
+ \a milliseconds, at \a rate datagrams per second or as fast as possible if
+ \a rate is 0. Returns the number of datagrams sent.
+ */
+static quint64 sendDatagrams(quint16 port, int size, int rate, int milliseconds)
+{
+    QUdpSocket socket;
+    QByteArray datagram(size, 'x');
+    QElapsedTimer timer;
+    timer.start();
+
+    quint64 attempted = 0;
+    quint64 sent = 0;
+    while (timer.elapsed() < milliseconds)
+    {
+        if (rate > 0)
+        {
+            // Catch up with the schedule, then sleep until the next datagram is due.
+            quint64 due = static_cast<quint64>(timer.nsecsElapsed() / 1000) * rate / 1000000;
+            if (attempted >= due)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                continue;
+            }
+        }
+        attempted++;
+        if (socket.writeDatagram(datagram, QHostAddress::LocalHost, port) == size)
+        {
+            sent++;
+        }
+    }
+    return sent;
+}
+
+/*!
+ Receives the datagrams of a loopback sender with \a backend, in the same way
+ as the ingest engine, and counts what it took.
+ */
+static bool measure(DatagramReceiver::Backend backend, quint16 port, int size, int rate, int milliseconds, BenchResult *result)
+{
+    *result = BenchResult();
+    DatagramReceiver *receiver = DatagramReceiver::create(backend);
+    if (receiver->backend() != backend || !receiver->bind(port))
+    {
+        delete receiver;
+        return false;
+    }
+
+    DatagramBatch batch(BENCH_BATCH_SIZE, BENCH_MAX_DATAGRAM_SIZE);
+    QObject::connect(receiver, &DatagramReceiver::readyRead, [receiver, &batch, result]() {
+        while (receiver->receive(&batch) > 0)
+        {
+            result->receiveCalls++;
+            result->received += batch.size();
+        }
+    });
+
+    std::atomic<quint64> sent(0);
+    std::thread sender([&sent, port, size, rate, milliseconds]() {
+        sent = sendDatagrams(port, size, rate, milliseconds);
+    });
+
+    QEventLoop loop;
+    QTimer::singleShot(milliseconds + BENCH_DRAIN_MS, &loop, &QEventLoop::quit);
+    double cpuStart = threadCpuTime();
+    t_syscalls = 0;
+    t_counting = true;
+    loop.exec();
+    t_counting = false;
+    double cpuEnd = threadCpuTime();
+    sender.join();
+
+    result->sent = sent;
+    result->syscalls = t_syscalls;
+    result->cpuSeconds = cpuStart < 0 ? -1 : cpuEnd - cpuStart;
+    delete receiver;
+    return true;
+}
+
+static std::vector<int> parseList(const QString &list)
+{
+    std::vector<int> values;
+    for (const QString &value : list.split(',', QString::SkipEmptyParts))
+    {
+        values.push_back(value.toInt());
+    }
+    return values;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compares the QUdpSocket and recvmmsg receive backends of gnss-sdr-monitor "
+                                     "on datagrams sent over the loopback interface, for each datagram size "
+                                     "and send rate.");
+    parser.addHelpOption();
+    parser.addOption({"sizes", "Datagram sizes in bytes.", "list", "256,1400,8192"});
+    parser.addOption({"rates", "Send rates in datagrams/s, 0 for as fast as possible.", "list", "1000,10000,100000,0"});
+    parser.addOption({"duration", "Seconds of sending per measurement.", "seconds", "2"});
+    parser.addOption({"port", "Loopback port to receive on.", "port", "11110"});
+    parser.process(app);
+
+    std::vector<int> sizes = parseList(parser.value("sizes"));
+    std::vector<int> rates = parseList(parser.value("rates"));
+    int milliseconds = static_cast<int>(parser.value("duration").toDouble() * 1000);
+    quint16 port = static_cast<quint16>(parser.value("port").toUInt());
+    if (sizes.empty() || rates.empty() || milliseconds <= 0)
+    {
+        parser.showHelp(1);
+    }
+
+#if !defined(Q_OS_LINUX)
+    std::cout << "Syscalls are only counted on Linux." << std::endl;
+#endif
+    std::cout << std::left << std::setw(12) << "backend" << std::right << std::setw(7) << "bytes"
+              << std::setw(10) << "rate" << std::setw(10) << "sent" << std::setw(8) << "lost %"
+              << std::setw(13) << "datagrams/s" << std::setw(14) << "calls/dgram" << std::setw(16) << "syscalls/dgram"
+              << std::setw(14) << "CPU us/dgram" << std::endl;
+    std::cout << std::fixed;
+
+    for (int size : sizes)
+    {
+        for (int rate : rates)
+        {
+            for (DatagramReceiver::Backend backend : {DatagramReceiver::QtSocketBackend, DatagramReceiver::RecvMmsgBackend})
+            {
+                const char *name = backend == DatagramReceiver::QtSocketBackend ? "QUdpSocket" : "recvmmsg";
+                BenchResult result;
+                if (!measure(backend, port, size, rate, milliseconds, &result))
+                {
+                    std::cout << std::left << std::setw(12) << name << std::right << " not available" << std::endl;
+                    continue;
+                }
+
+                double received = std::max<double>(result.received, 1);
+                double lost = result.sent ? 100.0 * (result.sent - std::min(result.sent, result.received)) / result.sent : 0;
+                std::cout << std::left << std::setw(12) << name << std::right << std::setw(7) << size
+                          << std::setw(10) << (rate > 0 ? QString::number(rate).toStdString() : "max")
+                          << std::setw(10) << result.sent << std::setw(8) << std::setprecision(1) << lost
+                          << std::setw(13) << std::setprecision(0) << result.received / (milliseconds / 1000.0)
+                          << std::setw(14) << std::setprecision(3) << result.receiveCalls / received;
+#if defined(Q_OS_LINUX)
+                std::cout << std::setw(16) << result.syscalls / received;
+#else
+                std::cout << std::setw(16) << "-";
+#endif
+                if (result.cpuSeconds >= 0)
+                {
+                    std::cout << std::setw(14) << std::setprecision(2) << result.cpuSeconds * 1e6 / received;
+                }
+                else
+                {
+                    std::cout << std::setw(14) << "-";
+                }
+                std::cout << std::endl;
+            }
+        }
+    }
+    return 0;
+}
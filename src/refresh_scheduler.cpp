@@ -0,0 +1,209 @@
+/*!
+ * \file refresh_scheduler.cpp
+ * \brief Implementation of a scheduler that paces the refreshes of the views
+ * to a target frame rate.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "refresh_scheduler.h"
+#include <QEvent>
+#include <algorithm>
+#include <cmath>
+
+// Share of the frame interval that a frame may spend refreshing the views.
+#define REFRESH_FRAME_BUDGET 0.5
+
+// Longest frame interval the scheduler backs off to, in milliseconds.
+#define REFRESH_MAX_INTERVAL 2000.0
+
+// Weight of the last frame in the moving average of the frame cost.
+#define REFRESH_COST_SMOOTHING 0.2
+
+// Factor by which the frame interval recovers per frame once it fits again.
+#define REFRESH_RECOVERY_FACTOR 0.9
+
+RefreshScheduler::RefreshScheduler(QObject *parent) : QObject(parent),
+                                                      m_lastFrameStart(-1),
+                                                      m_inFrame(false),
+                                                      m_framePending(false),
+                                                      m_averageCost(0.0)
+{
+    setTargetFps(10.0);
+
+    m_frameTimer.setSingleShot(true);
+    m_finishTimer.setSingleShot(true);
+    m_finishTimer.setInterval(0);
+    connect(&m_frameTimer, &QTimer::timeout, this, &RefreshScheduler::runFrame);
+    connect(&m_finishTimer, &QTimer::timeout, this, &RefreshScheduler::finishFrame);
+
+    m_clock.start();
+}
+
+/*!
+ Sets the number of frames per second that the scheduler aims for when the
+ frames fit in their budget.
+ */
+void RefreshScheduler::setTargetFps(double fps)
+{
+    if (fps <= 0.0)
+    {
+        return;
+    }
+
+    m_targetInterval = std::min(1000.0 / fps, REFRESH_MAX_INTERVAL);
+    m_interval = m_targetInterval;
+}
+
+double RefreshScheduler::targetFps() const
+{
+    return 1000.0 / m_targetInterval;
+}
+
+/*!
+ Returns the frame rate currently allowed, which is lower than the target
+ while the frames overrun their budget.
+ */
+double RefreshScheduler::currentFps() const
+{
+    return 1000.0 / m_interval;
+}
+
+/*!
+ Returns the moving average of the cost of a frame, in milliseconds.
+ */
+double RefreshScheduler::frameCost() const
+{
+    return m_averageCost;
+}
+
+/*!
+ Registers \a widget so that \a refresh is called on every frame in which
+ the widget is visible and its window is not minimized. The view is forgotten
+ when the widget is destroyed.
+ */
+void RefreshScheduler::addView(QWidget *widget, const std::function<void()> &refresh)
+{
+    View view;
+    view.widget = widget;
+    view.refresh = refresh;
+    m_views.push_back(view);
+
+    widget->installEventFilter(this);
+}
+
+/*!
+ Requests a frame when a view is shown, which happens when its dock is shown
+ or its window is opened or restored, because it was not refreshed while hidden.
+ */
+bool RefreshScheduler::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::Show)
+    {
+        requestFrame();
+    }
+
+    return QObject::eventFilter(watched, event);
+}
+
+/*!
+ Requests a frame. The frame is run when the frame interval has elapsed since
+ the previous one, together with any other request made in the meantime.
+ */
+void RefreshScheduler::requestFrame()
+{
+    if (m_inFrame)
+    {
+        m_framePending = true;
+        return;
+    }
+
+    if (m_frameTimer.isActive())
+    {
+        return;
+    }
+
+    qint64 wait = 0;
+    if (m_lastFrameStart >= 0)
+    {
+        qint64 next = m_lastFrameStart + static_cast<qint64>(std::lround(m_interval));
+        wait = std::max<qint64>(0, next - m_clock.elapsed());
+    }
+    m_frameTimer.start(static_cast<int>(wait));
+}
+
+void RefreshScheduler::runFrame()
+{
+    m_inFrame = true;
+    m_lastFrameStart = m_clock.elapsed();
+    m_frameClock.start();
+
+    emit frameStarted();
+
+    m_views.erase(std::remove_if(m_views.begin(), m_views.end(),
+                      [](const View &view) { return view.widget.isNull(); }),
+        m_views.end());
+
+    for (const View &view : m_views)
+    {
+        QWidget *window = view.widget->window();
+        if (view.widget->isVisible() && !window->isMinimized())
+        {
+            view.refresh();
+        }
+    }
+
+    // The repaints requested by the frame are delivered by the event loop
+    // before this timer fires, so they are included in the cost of the frame.
+    m_finishTimer.start();
+}
+
+void RefreshScheduler::finishFrame()
+{
+    double cost = m_frameClock.nsecsElapsed() / 1e6;
+    m_averageCost += REFRESH_COST_SMOOTHING * (cost - m_averageCost);
+
+    // Stretch the interval at once when the frames overrun their budget, and
+    // bring it back towards the target gradually when they fit again.
+    double required = m_averageCost / REFRESH_FRAME_BUDGET;
+    if (required > m_interval)
+    {
+        m_interval = std::min(required, REFRESH_MAX_INTERVAL);
+    }
+    else if (m_interval > m_targetInterval)
+    {
+        m_interval = std::max(std::max(required, m_targetInterval), m_interval * REFRESH_RECOVERY_FACTOR);
+    }
+
+    m_inFrame = false;
+    emit frameFinished(cost);
+
+    if (m_framePending)
+    {
+        m_framePending = false;
+        requestFrame();
+    }
+}
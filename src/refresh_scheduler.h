@@ -0,0 +1,103 @@
+/*!
+ * \file refresh_scheduler.h
+ * \brief Interface of a scheduler that paces the refreshes of the views
+ * to a target frame rate.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#ifndef GNSS_SDR_MONITOR_REFRESH_SCHEDULER_H_
+#define GNSS_SDR_MONITOR_REFRESH_SCHEDULER_H_
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QWidget>
+#include <functional>
+#include <vector>
+
+/*!
+ Paces the refreshes of the GUI to a target frame rate. Any number of frame
+ requests received between two frames are coalesced into a single frame,
+ which is run as soon as the frame interval has elapsed since the last one.
+
+ A frame emits frameStarted(), so that the pending data can be consumed, and
+ then refreshes the registered views that are visible. Views in hidden docks,
+ closed windows or minimized windows are skipped, and a frame is requested
+ when one of them is shown again so that it catches up at once. The cost of each frame,
+ including the repaints it triggers, is measured and, when it overruns its
+ share of the frame interval, the frame rate is lowered until it fits again.
+ */
+class RefreshScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RefreshScheduler(QObject *parent = nullptr);
+
+    void setTargetFps(double fps);
+    double targetFps() const;
+    double currentFps() const;
+    double frameCost() const;
+
+    void addView(QWidget *widget, const std::function<void()> &refresh);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+public slots:
+    void requestFrame();
+
+signals:
+    void frameStarted();
+    void frameFinished(double cost);
+
+private slots:
+    void runFrame();
+    void finishFrame();
+
+private:
+    struct View
+    {
+        QPointer<QWidget> widget;
+        std::function<void()> refresh;
+    };
+
+    std::vector<View> m_views;
+    QTimer m_frameTimer;
+    QTimer m_finishTimer;
+    QElapsedTimer m_clock;
+    QElapsedTimer m_frameClock;
+    qint64 m_lastFrameStart;
+    bool m_inFrame;
+    bool m_framePending;
+    double m_targetInterval;
+    double m_interval;
+    double m_averageCost;
+};
+
+#endif  // GNSS_SDR_MONITOR_REFRESH_SCHEDULER_H_
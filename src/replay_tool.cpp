@@ -0,0 +1,195 @@
+/*!
+ * \file replay_tool.cpp
+ * \brief Command line tool that lists the datagrams of the flight recorder
+ * segments, or sends them again to the monitor with their original timing.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "flight_recorder.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QHostAddress>
+#include <QSettings>
+#include <QThread>
+#include <QUdpSocket>
+#include <iostream>
+
+// Longest pause between two datagrams, so that gaps in a recording, such as
+// a receiver restart, do not stall the replay.
+#define REPLAY_TOOL_MAX_GAP_MS 5000
+
+/*!
+ Returns the segments given in \a arguments, files or directories holding
+ flight-*.rec files, in recording order.
+ */
+static QStringList segmentPaths(const QStringList &arguments)
+{
+    QStringList paths;
+    for (const QString &argument : arguments)
+    {
+        QFileInfo info(argument);
+        if (!info.isDir())
+        {
+            paths.append(argument);
+            continue;
+        }
+        // The names hold the creation time and the sequence, zero padded.
+        QDir directory(argument);
+        for (const QString &name : directory.entryList(QStringList() << "flight-*.rec", QDir::Files, QDir::Name))
+        {
+            paths.append(directory.filePath(name));
+        }
+    }
+    return paths;
+}
+
+static const char *streamName(int stream)
+{
+    switch (stream)
+    {
+    case FlightRecorder::GnssSynchroStream:
+        return "GnssSynchro";
+    case FlightRecorder::MonitorPvtStream:
+        return "MonitorPvt";
+    default:
+        return "unknown";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    // Same names as the monitor, so that the ports of the preferences are used.
+    app.setOrganizationName("gnss-sdr");
+    app.setOrganizationDomain("gnss-sdr.org");
+    app.setApplicationName("gnss-sdr-monitor");
+
+    QSettings settings;
+    settings.beginGroup("Preferences_Dialog");
+    QString gnssSynchroPort = settings.value("port_gnss_synchro", 1111).toString();
+    QString monitorPvtPort = settings.value("port_monitor_pvt", 1112).toString();
+    settings.endGroup();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Lists the datagrams recorded by gnss-sdr-monitor, or sends them again "
+                                     "to a monitor with the timing they were received with.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("segments", "Segment files, or directories of them.", "segments...");
+    parser.addOption({"dump", "List the datagrams instead of sending them."});
+    parser.addOption({"host", "Address to send to.", "address", "127.0.0.1"});
+    parser.addOption({"gnss-synchro-port", "Port of the GnssSynchro datagrams. Defaults to the preferences.", "port", gnssSynchroPort});
+    parser.addOption({"monitor-pvt-port", "Port of the MonitorPvt datagrams. Defaults to the preferences.", "port", monitorPvtPort});
+    parser.addOption({"speed", "Replay speed, 0 for as fast as possible.", "factor", "1"});
+    parser.process(app);
+
+    QStringList paths = segmentPaths(parser.positionalArguments());
+    if (paths.isEmpty())
+    {
+        parser.showHelp(1);
+    }
+
+    bool dump = parser.isSet("dump");
+    QHostAddress host(parser.value("host"));
+    quint16 ports[] = {0, static_cast<quint16>(parser.value("gnss-synchro-port").toUInt()),
+        static_cast<quint16>(parser.value("monitor-pvt-port").toUInt())};
+    double speed = parser.value("speed").toDouble();
+    QUdpSocket socket;
+
+    // Receive time of the first datagram, and when it was sent.
+    qint64 firstTime = -1;
+    QElapsedTimer clock;
+    qint64 shift = 0;
+    qint64 lastTime = 0;
+    quint64 counts[3] = {0, 0, 0};
+    quint64 failed = 0;
+    int status = 0;
+
+    for (const QString &path : paths)
+    {
+        bool ok = FlightRecorder::readSegment(path.toStdString(), [&](const FlightRecorder::Record &record) {
+            int stream = record.stream == FlightRecorder::GnssSynchroStream || record.stream == FlightRecorder::MonitorPvtStream ? record.stream : 0;
+            counts[stream]++;
+            if (dump)
+            {
+                std::cout << record.receiveTime << " " << streamName(record.stream) << " " << record.length << std::endl;
+                return;
+            }
+            if (stream == 0)
+            {
+                return;
+            }
+
+            if (firstTime < 0)
+            {
+                firstTime = record.receiveTime;
+                clock.start();
+            }
+            else if (speed > 0)
+            {
+                // Gaps beyond the limit are skipped.
+                qint64 gap = record.receiveTime - lastTime;
+                if (gap > static_cast<qint64>(REPLAY_TOOL_MAX_GAP_MS) * 1000000)
+                {
+                    shift += gap - static_cast<qint64>(REPLAY_TOOL_MAX_GAP_MS) * 1000000;
+                }
+                qint64 due = static_cast<qint64>((record.receiveTime - firstTime - shift) / speed);
+                qint64 ahead = due - clock.nsecsElapsed();
+                if (ahead > 0)
+                {
+                    QThread::usleep(static_cast<unsigned long>(ahead / 1000));
+                }
+            }
+            lastTime = record.receiveTime;
+
+            if (socket.writeDatagram(record.data, record.length, host, ports[stream]) != record.length)
+            {
+                failed++;
+            }
+        });
+        if (!ok)
+        {
+            std::cerr << "Not a flight recorder segment: " << path.toStdString() << std::endl;
+            status = 1;
+        }
+    }
+
+    std::cout << (dump ? "Listed " : "Sent ") << counts[1] << " GnssSynchro and " << counts[2] << " MonitorPvt datagrams";
+    if (counts[0] > 0)
+    {
+        std::cout << ", " << counts[0] << " of unknown streams";
+    }
+    if (failed > 0)
+    {
+        std::cout << ", " << failed << " not sent";
+        status = 1;
+    }
+    std::cout << " from " << paths.size() << " segments." << std::endl;
+    return status;
+}
@@ -0,0 +1,161 @@
+/*!
+ * \file series_buffer.cpp
+ * \brief Implementation of a fixed-capacity history of the points of a plot
+ * series.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "series_buffer.h"
+#include <algorithm>
+
+/*!
+ Constructs a buffer that holds the newest \a capacity points.
+ */
+SeriesBuffer::SeriesBuffer(size_t capacity) : m_capacity(0), m_head(0), m_size(0), m_generation(0), m_sequence(0)
+{
+    setCapacity(capacity);
+}
+
+/*!
+ Sets the number of points kept. The newest points that fit are preserved,
+ and nothing is reallocated if the capacity does not change.
+ */
+void SeriesBuffer::setCapacity(size_t capacity)
+{
+    if (capacity == m_capacity)
+    {
+        return;
+    }
+
+    size_t kept = std::min(m_size, capacity);
+
+    std::vector<double> x(capacity);
+    std::vector<double> y(capacity);
+    for (size_t i = 0; i < kept; i++)
+    {
+        size_t index = (m_head + m_size - kept + i) % m_capacity;
+        x[i] = m_x[index];
+        y[i] = m_y[index];
+    }
+
+    // The extrema keep tracking the newest points.
+    m_xExtrema.resize(capacity);
+    m_yExtrema.resize(capacity);
+
+    m_x.swap(x);
+    m_y.swap(y);
+    m_capacity = capacity;
+    m_head = 0;
+    m_size = kept;
+    m_generation++;
+}
+
+size_t SeriesBuffer::capacity() const
+{
+    return m_capacity;
+}
+
+/*!
+ Appends the point (\a x, \a y), overwriting the oldest one when the buffer is full.
+ */
+void SeriesBuffer::append(double x, double y)
+{
+    if (m_capacity == 0)
+    {
+        return;
+    }
+
+    size_t index = m_head + m_size;
+    if (index >= m_capacity)
+    {
+        index -= m_capacity;
+    }
+    m_x[index] = x;
+    m_y[index] = y;
+
+    m_xExtrema.push(x);
+    m_yExtrema.push(y);
+
+    if (m_size < m_capacity)
+    {
+        m_size++;
+    }
+    else if (++m_head == m_capacity)
+    {
+        m_head = 0;
+    }
+
+    m_generation++;
+    m_sequence++;
+}
+
+void SeriesBuffer::clear()
+{
+    m_head = 0;
+    m_size = 0;
+    m_xExtrema.clear();
+    m_yExtrema.clear();
+    m_generation++;
+}
+
+size_t SeriesBuffer::size() const
+{
+    return m_size;
+}
+
+bool SeriesBuffer::empty() const
+{
+    return m_size == 0;
+}
+
+/*!
+ Returns the number of bytes allocated by the rings and their extrema.
+ */
+size_t SeriesBuffer::memoryUsage() const
+{
+    return (m_x.capacity() + m_y.capacity()) * sizeof(double) + m_xExtrema.memoryUsage() + m_yExtrema.memoryUsage();
+}
+
+/*!
+ Returns a view of the points, oldest first. It is only valid until the buffer is next modified.
+ */
+SeriesView SeriesBuffer::view() const
+{
+    SeriesView series;
+    series.x = ring(m_x, m_xExtrema);
+    series.y = ring(m_y, m_yExtrema);
+    series.slot = -1;
+    series.generation = m_generation;
+    series.sequence = m_sequence;
+    return series;
+}
+
+RingView SeriesBuffer::ring(const std::vector<double> &samples, const SlidingExtrema<double> &extrema) const
+{
+    size_t firstSize = std::min(m_size, m_capacity - m_head);
+    return RingView(samples.data() + m_head, firstSize, samples.data(), m_size - firstSize, &extrema);
+}
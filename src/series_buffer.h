@@ -0,0 +1,78 @@
+/*!
+ * \file series_buffer.h
+ * \brief Interface of a fixed-capacity history of the points of a plot
+ * series.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#ifndef GNSS_SDR_MONITOR_SERIES_BUFFER_H_
+#define GNSS_SDR_MONITOR_SERIES_BUFFER_H_
+
+#include "channel_history_store.h"
+#include "sliding_extrema.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*!
+ Keeps the newest points of a series in a pair of rings, one per coordinate,
+ with their ranges maintained incrementally, and exposes them as a SeriesView.
+ It is the counterpart of a ChannelHistoryStore slot for series that do not
+ come from a tracking channel.
+ */
+class SeriesBuffer
+{
+public:
+    explicit SeriesBuffer(size_t capacity = 0);
+
+    void setCapacity(size_t capacity);
+    size_t capacity() const;
+
+    void append(double x, double y);
+    void clear();
+
+    size_t size() const;
+    bool empty() const;
+
+    SeriesView view() const;
+    size_t memoryUsage() const;
+
+private:
+    RingView ring(const std::vector<double> &samples, const SlidingExtrema<double> &extrema) const;
+
+    size_t m_capacity;
+    size_t m_head;  // Index of the oldest point.
+    size_t m_size;
+    std::vector<double> m_x;
+    std::vector<double> m_y;
+    SlidingExtrema<double> m_xExtrema;
+    SlidingExtrema<double> m_yExtrema;
+    uint64_t m_generation;
+    uint64_t m_sequence;
+};
+
+#endif  // GNSS_SDR_MONITOR_SERIES_BUFFER_H_
@@ -0,0 +1,182 @@
+/*!
+ * \file series_decimator.cpp
+ * \brief Implementation of pixel-aware decimation of the series drawn by
+ * the sparkline delegates.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "series_decimator.h"
+#include <algorithm>
+
+namespace
+{
+/*!
+ Returns the pixel cell, between 0 and \a cells - 1, of a coordinate already scaled to pixels.
+ */
+inline int pixelCell(double pixel, int cells)
+{
+    // Written so that NaN ends up in the first cell.
+    if (!(pixel >= 0.0))
+    {
+        return 0;
+    }
+    return pixel >= cells - 1 ? cells - 1 : static_cast<int>(pixel);
+}
+
+/*!
+ Appends the first, minimum, maximum and last samples of a pixel column, in sample order and without repetitions.
+ */
+inline void appendColumn(size_t first, size_t min, size_t max, size_t last, std::vector<size_t> *indices)
+{
+    indices->push_back(first);
+
+    size_t low = std::min(min, max);
+    size_t high = std::max(min, max);
+    if (low != first)
+    {
+        indices->push_back(low);
+    }
+    if (high != low && high != first)
+    {
+        indices->push_back(high);
+    }
+    if (last != high && last != first)
+    {
+        indices->push_back(last);
+    }
+}
+}  // namespace
+
+/*!
+ M4 decimation of the samples of \a series from index \a first up to, but not
+ including, index \a end, for a line plot \a width pixels wide whose horizontal axis spans \a minX to \a maxX.
+
+ Consecutive samples that fall in the same pixel column are reduced to the
+ first, last, minimum and maximum of the column, which are the only samples
+ that affect the rasterized line, so at most four samples per column are
+ kept. The indices are stored in \a indices, replacing its contents.
+ */
+void SeriesDecimator::m4(const SeriesView &series, size_t first, size_t end, double minX, double maxX, int width,
+    std::vector<size_t> *indices)
+{
+    indices->clear();
+
+    end = std::min(end, series.size());
+    if (first >= end)
+    {
+        return;
+    }
+
+    int columns = std::max(width, 0) + 1;
+    double scale = (maxX > minX) ? width / (maxX - minX) : 0.0;
+
+    int column = pixelCell((series.x[first] - minX) * scale, columns);
+    size_t columnFirst = first;
+    size_t columnMin = first;
+    size_t columnMax = first;
+    double yMin = series.y[first];
+    double yMax = yMin;
+
+    for (size_t i = first + 1; i < end; i++)
+    {
+        int c = pixelCell((series.x[i] - minX) * scale, columns);
+        double y = series.y[i];
+
+        if (c != column)
+        {
+            appendColumn(columnFirst, columnMin, columnMax, i - 1, indices);
+
+            column = c;
+            columnFirst = i;
+            columnMin = i;
+            columnMax = i;
+            yMin = y;
+            yMax = y;
+        }
+        else if (y < yMin)
+        {
+            columnMin = i;
+            yMin = y;
+        }
+        else if (y > yMax)
+        {
+            columnMax = i;
+            yMax = y;
+        }
+    }
+
+    appendColumn(columnFirst, columnMin, columnMax, end - 1, indices);
+}
+
+/*!
+ Decimation of the samples of \a series for a scatter plot of \a width by \a height
+ pixels spanning \a minX to \a maxX horizontally and \a minY to \a maxY vertically.
+
+ Only the newest sample that falls in each pixel is kept, since the older
+ ones would be painted over with the same pen. Samples outside the ranges are
+ dropped. The newest sample of the series is kept if it is inside them. The
+ indices are stored in \a indices, oldest first, replacing its contents.
+ */
+void SeriesDecimator::pixelGrid(const SeriesView &series, double minX, double maxX, double minY, double maxY,
+    int width, int height, std::vector<size_t> *indices)
+{
+    indices->clear();
+
+    if (series.empty())
+    {
+        return;
+    }
+
+    int columns = std::max(width, 0) + 1;
+    int rows = std::max(height, 0) + 1;
+    double scaleX = (maxX > minX) ? width / (maxX - minX) : 0.0;
+    double scaleY = (maxY > minY) ? height / (maxY - minY) : 0.0;
+
+    std::vector<bool> occupied(static_cast<size_t>(columns) * rows, false);
+
+    for (size_t i = series.size(); i-- > 0;)
+    {
+        double x = series.x[i];
+        double y = series.y[i];
+        if (!(x >= minX && x <= maxX && y >= minY && y <= maxY))
+        {
+            continue;
+        }
+
+        int column = pixelCell((x - minX) * scaleX, columns);
+        int row = pixelCell((y - minY) * scaleY, rows);
+
+        size_t cell = static_cast<size_t>(row) * columns + column;
+        if (!occupied[cell])
+        {
+            occupied[cell] = true;
+            indices->push_back(i);
+        }
+    }
+
+    std::reverse(indices->begin(), indices->end());
+}
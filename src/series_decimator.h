@@ -0,0 +1,54 @@
+/*!
+ * \file series_decimator.h
+ * \brief Interface of pixel-aware decimation of the series drawn by the
+ * sparkline delegates.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#ifndef GNSS_SDR_MONITOR_SERIES_DECIMATOR_H_
+#define GNSS_SDR_MONITOR_SERIES_DECIMATOR_H_
+
+#include "channel_history_store.h"
+#include <cstddef>
+#include <vector>
+
+/*!
+ Selects the samples of a series that are needed to draw it at a given size
+ in pixels. The result is a list of sample indices, in drawing order, so the
+ caller maps only those samples to its own coordinate system.
+ */
+class SeriesDecimator
+{
+public:
+    static void m4(const SeriesView &series, size_t first, size_t end, double minX, double maxX, int width,
+        std::vector<size_t> *indices);
+
+    static void pixelGrid(const SeriesView &series, double minX, double maxX, double minY, double maxY,
+        int width, int height, std::vector<size_t> *indices);
+};
+
+#endif  // GNSS_SDR_MONITOR_SERIES_DECIMATOR_H_
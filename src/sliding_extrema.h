@@ -0,0 +1,312 @@
+/*!
+ * \file sliding_extrema.h
+ * \brief Interface and implementation of an incremental minimum and maximum
+ * over a sliding window of samples.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#ifndef GNSS_SDR_MONITOR_SLIDING_EXTREMA_H_
+#define GNSS_SDR_MONITOR_SLIDING_EXTREMA_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/*!
+ Keeps the minimum and maximum of the last window() values pushed to it.
+
+ Each extreme is tracked with a monotonic deque: a pushed value discards the
+ older values it dominates, and values that leave the window are dropped from
+ the front. Pushing is amortized O(1). The deques grow, up to the window, as
+ long runs of monotonic values need them, so noisy data takes little memory.
+ The extremes of the whole window are read in O(1), and those of the newest
+ \a count values, for any count, in O(log window).
+ */
+template <typename T>
+class SlidingExtrema
+{
+public:
+    explicit SlidingExtrema(size_t window = 0)
+    {
+        setWindow(window);
+    }
+
+    /*!
+     Sets the number of values the extremes are computed over, and clears the window.
+     */
+    void setWindow(size_t window)
+    {
+        m_window = window;
+        m_count = 0;
+        m_size = 0;
+        m_min.reset(window);
+        m_max.reset(window);
+    }
+
+    /*!
+     Sets the number of values the extremes are computed over, keeping the
+     newest values that fit. Growing the window does not bring back values
+     that already left it.
+     */
+    void resize(size_t window)
+    {
+        m_window = window;
+        m_size = std::min(m_size, window);
+        m_min.fit(window, m_count - m_size);
+        m_max.fit(window, m_count - m_size);
+    }
+
+    size_t window() const
+    {
+        return m_window;
+    }
+
+    void clear()
+    {
+        m_count = 0;
+        m_size = 0;
+        m_min.clear();
+        m_max.clear();
+    }
+
+    /*!
+     Adds \a value as the newest value of the window, evicting the oldest one if the window is full.
+     */
+    void push(T value)
+    {
+        if (m_window == 0)
+        {
+            return;
+        }
+
+        uint64_t sequence = m_count++;
+        if (m_size < m_window)
+        {
+            m_size++;
+        }
+        uint64_t oldest = m_count - m_size;
+        m_min.push(sequence, value, oldest);
+        m_max.push(sequence, value, oldest);
+    }
+
+    /*!
+     Returns the number of values in the window.
+     */
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /*!
+     Returns the number of bytes allocated by the deques.
+     */
+    size_t memoryUsage() const
+    {
+        return m_min.memoryUsage() + m_max.memoryUsage();
+    }
+
+    // Extremes of the whole window. The window must not be empty.
+    T minimum() const { return m_min.front(); }
+    T maximum() const { return m_max.front(); }
+
+    // Extremes of the newest \a count values, with 0 < count <= size().
+    T minimum(size_t count) const { return m_min.since(m_count - count); }
+    T maximum(size_t count) const { return m_max.since(m_count - count); }
+
+private:
+    struct Entry
+    {
+        uint64_t sequence;
+        T value;
+    };
+
+    /*!
+     Fixed-capacity deque of entries whose values are ordered by Compare from
+     front to back, and whose sequence numbers increase from front to back.
+     */
+    template <typename Compare>
+    class MonotonicDeque
+    {
+    public:
+        void reset(size_t capacity)
+        {
+            // The storage is released, and grown again up to capacity as needed.
+            std::vector<Entry>().swap(m_entries);
+            m_capacity = capacity;
+            clear();
+        }
+
+        /*!
+         Sets the capacity and drops the entries older than \a oldest. The
+         storage is shrunk if it is larger than the new capacity.
+         */
+        void fit(size_t capacity, uint64_t oldest)
+        {
+            while (m_size > 0 && at(0).sequence < oldest)
+            {
+                m_head = next(m_head);
+                m_size--;
+            }
+
+            m_capacity = capacity;
+            if (m_entries.size() > std::max<size_t>(capacity, 16))
+            {
+                relocate(std::max<size_t>(m_size, 16));
+            }
+        }
+
+        size_t memoryUsage() const
+        {
+            return m_entries.capacity() * sizeof(Entry);
+        }
+
+        void clear()
+        {
+            m_head = 0;
+            m_size = 0;
+        }
+
+        void push(uint64_t sequence, T value, uint64_t oldest)
+        {
+            while (m_size > 0 && at(0).sequence < oldest)
+            {
+                m_head = next(m_head);
+                m_size--;
+            }
+
+            // Values that do not beat the new one can never be the extreme again.
+            Compare compare;
+            while (m_size > 0 && !compare(at(m_size - 1).value, value))
+            {
+                m_size--;
+            }
+
+            if (m_size == m_entries.size())
+            {
+                grow();
+            }
+
+            size_t tail = m_head + m_size;
+            if (tail >= m_entries.size())
+            {
+                tail -= m_entries.size();
+            }
+            m_entries[tail].sequence = sequence;
+            m_entries[tail].value = value;
+            m_size++;
+        }
+
+        T front() const
+        {
+            return at(0).value;
+        }
+
+        /*!
+         Returns the extreme of the values pushed with a sequence number of at least \a first.
+         */
+        T since(uint64_t first) const
+        {
+            // The first entry not older than first. The newest value is always
+            // in the deque, so the search cannot run past the end.
+            size_t low = 0;
+            size_t high = m_size - 1;
+            while (low < high)
+            {
+                size_t middle = low + (high - low) / 2;
+                if (at(middle).sequence < first)
+                {
+                    low = middle + 1;
+                }
+                else
+                {
+                    high = middle;
+                }
+            }
+            return at(low).value;
+        }
+
+    private:
+        const Entry &at(size_t i) const
+        {
+            size_t index = m_head + i;
+            if (index >= m_entries.size())
+            {
+                index -= m_entries.size();
+            }
+            return m_entries[index];
+        }
+
+        size_t next(size_t index) const
+        {
+            return (index + 1 == m_entries.size()) ? 0 : index + 1;
+        }
+
+        /*!
+         Doubles the storage, without exceeding the capacity, and moves the entries to its start.
+         */
+        void grow()
+        {
+            relocate(std::max<size_t>(std::min<size_t>(2 * m_entries.size(), m_capacity), 16));
+        }
+
+        /*!
+         Moves the entries to the start of a new storage of \a size entries.
+         */
+        void relocate(size_t size)
+        {
+            std::vector<Entry> entries;
+            entries.reserve(size);
+            for (size_t i = 0; i < m_size; i++)
+            {
+                entries.push_back(at(i));
+            }
+            entries.resize(size);
+            m_entries.swap(entries);
+            m_head = 0;
+        }
+
+        std::vector<Entry> m_entries;
+        size_t m_capacity = 0;
+        size_t m_head = 0;
+        size_t m_size = 0;
+    };
+
+    size_t m_window;
+    uint64_t m_count;  // Values pushed since the window was cleared.
+    size_t m_size;     // Values in the window.
+    MonotonicDeque<std::less<T>> m_min;
+    MonotonicDeque<std::greater<T>> m_max;
+};
+
+#endif  // GNSS_SDR_MONITOR_SLIDING_EXTREMA_H_
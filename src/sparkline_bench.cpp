@@ -0,0 +1,152 @@
+/*!
+ * \file sparkline_bench.cpp
+ * \brief Times the rendering of the C/N0 sparkline into an offscreen image
+ * for buffer sizes from 100 to 100k samples.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "channel_history_store.h"
+#include "cn0_delegate.h"
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QPainter>
+#include <QStyle>
+#include <QStyleOptionViewItem>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// Sample rate of the generated history, as GNSS-SDR sends it, and the
+// shortest time spent rendering each sparkline.
+#define SPARKLINE_BENCH_RATE 50
+#define SPARKLINE_BENCH_MIN_MS 500
+
+namespace
+{
+std::vector<size_t> parseList(const QString &text)
+{
+    std::vector<size_t> values;
+    for (const QString &item : text.split(',', QString::SkipEmptyParts))
+    {
+        bool ok = false;
+        qulonglong value = item.trimmed().toULongLong(&ok);
+        if (ok && value > 0)
+        {
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+/*!
+ Returns the time, in microseconds, it takes to paint the sparkline of the
+ newest \a size samples of \a series into \a image, averaged over at least
+ SPARKLINE_BENCH_MIN_MS of repeated paints.
+ */
+double measure(QImage *image, const QStyleOptionViewItem &option, const SeriesView &series, size_t size, bool autoRange)
+{
+    QElapsedTimer timer;
+    timer.start();
+    long paints = 0;
+    do
+    {
+        image->fill(Qt::transparent);
+        QPainter painter(image);
+        Cn0Delegate::drawSparkline(&painter, option, series, size, 20, 50, autoRange);
+        painter.end();
+        paints++;
+    } while (timer.elapsed() < SPARKLINE_BENCH_MIN_MS);
+    return timer.nsecsElapsed() / 1000.0 / paints;
+}
+}  // namespace
+
+int main(int argc, char *argv[])
+{
+    // Render without a display unless a platform was chosen.
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Times the rendering of the C/N0 sparkline of gnss-sdr-monitor into an "
+                                     "offscreen image, for each buffer size.");
+    parser.addHelpOption();
+    parser.addOption({"sizes", "Buffer sizes in samples.", "list", "100,1000,10000,100000"});
+    parser.addOption({"width", "Width of the cell in pixels.", "pixels", "240"});
+    parser.process(app);
+
+    std::vector<size_t> sizes = parseList(parser.value("sizes"));
+    int width = parser.value("width").toInt();
+    if (sizes.empty() || width <= 0)
+    {
+        parser.showHelp(1);
+    }
+
+    // A C/N0 wandering around 42 dB-Hz, with the noise of a tracking loop.
+    size_t longest = *std::max_element(sizes.begin(), sizes.end());
+    ChannelHistoryStore store(longest);
+    int slot = store.acquire(ChannelHistoryStore::satelliteKey('G', 1, 1));
+    for (size_t i = 0; i < longest; i++)
+    {
+        double time = static_cast<double>(i) / SPARKLINE_BENCH_RATE;
+        double cn0 = 42 + 4 * std::sin(time / 60) + std::sin(static_cast<double>(i * 7919 % 1000));
+        store.append(slot, time, 0, 0, cn0, 0);
+    }
+
+    SeriesView series;
+    series.x = store.view(slot, ChannelHistoryStore::Time);
+    series.y = store.view(slot, ChannelHistoryStore::Cn0);
+    series.slot = slot;
+    series.generation = store.generation(slot);
+    series.sequence = store.sequence(slot);
+
+    // A cell of the channel table as the delegate is given it, moved to the origin.
+    QStyleOptionViewItem option;
+    option.font = QApplication::font();
+    option.fontMetrics = QFontMetrics(option.font);
+    option.palette = QApplication::palette();
+    option.state = QStyle::State_Enabled | QStyle::State_Active;
+    option.rect = QRect(0, 0, width, option.fontMetrics.height() + 8);
+
+    QImage image(option.rect.size(), QImage::Format_ARGB32_Premultiplied);
+
+    std::cout << "Cell of " << option.rect.width() << "x" << option.rect.height() << " pixels" << std::endl;
+    std::cout << std::setw(10) << "samples" << std::setw(16) << "fixed range us" << std::setw(15) << "auto range us" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    for (size_t size : sizes)
+    {
+        std::cout << std::setw(10) << size << std::setw(16) << measure(&image, option, series, size, false)
+                  << std::setw(15) << measure(&image, option, series, size, true) << std::endl;
+    }
+    return 0;
+}
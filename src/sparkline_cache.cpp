@@ -0,0 +1,337 @@
+/*!
+ * \file sparkline_cache.cpp
+ * \brief Implementation of a cache of rendered sparklines for the item
+ * delegates.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "sparkline_cache.h"
+#include "channel_table_model.h"
+#include <QAbstractItemView>
+#include <QAbstractScrollArea>
+#include <QApplication>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QStyle>
+#include <QThreadPool>
+
+// Style state flags that change how a sparkline is drawn.
+#define SPARKLINE_STATE_MASK (QStyle::State_Enabled | QStyle::State_Active | QStyle::State_Selected | QStyle::State_MouseOver)
+
+bool SparklineCache::Key::operator==(const Key &other) const
+{
+    return slot == other.slot &&
+           generation == other.generation &&
+           size == other.size &&
+           state == other.state &&
+           palette == other.palette &&
+           devicePixelRatio == other.devicePixelRatio;
+}
+
+namespace
+{
+/*!
+ Draws a sparkline into a transparent image of the size and pixel ratio given by \a key.
+ */
+QImage rasterize(const SparklineCache::Key &key, const SeriesView &series, const SparklineCache::DrawFunction &draw)
+{
+    QImage image(key.size * key.devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(key.devicePixelRatio);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    draw(&painter, series);
+    painter.end();
+
+    return image;
+}
+}  // namespace
+
+/*!
+ Renders a sparkline from a copy of its samples on a worker thread, and
+ queues the image to the cache that requested it, if it still exists.
+ */
+class SparklineCache::RenderJob : public QRunnable
+{
+public:
+    RenderJob(const Key &key, const SeriesView &series, size_t count, const DrawFunction &draw,
+        const std::shared_ptr<Receiver> &receiver)
+        : m_key(key), m_snapshot(series, count), m_draw(draw), m_receiver(receiver)
+    {
+    }
+
+    void run() override
+    {
+        QImage image = rasterize(m_key, m_snapshot.view(), m_draw);
+
+        QMutexLocker locker(&m_receiver->mutex);
+        if (m_receiver->cache)
+        {
+            QMetaObject::invokeMethod(m_receiver->cache, "deliver", Qt::QueuedConnection,
+                Q_ARG(SparklineCache::Key, m_key), Q_ARG(QImage, image));
+        }
+    }
+
+private:
+    Key m_key;
+    SeriesSnapshot m_snapshot;
+    DrawFunction m_draw;
+    std::shared_ptr<Receiver> m_receiver;
+};
+
+SparklineCache::SparklineCache(QObject *parent) : QObject(parent)
+{
+    qRegisterMetaType<SparklineCache::Key>();
+
+    m_model = nullptr;
+    m_receiver = std::make_shared<Receiver>();
+    m_receiver->cache = this;
+}
+
+SparklineCache::~SparklineCache()
+{
+    // Jobs still running drop their image. Those already queued are discarded with this object.
+    QMutexLocker locker(&m_receiver->mutex);
+    m_receiver->cache = nullptr;
+}
+
+/*!
+ Builds the key of the sparkline of \a series drawn in the cell of \a index
+ with \a option on a device with the given \a devicePixelRatio.
+ */
+SparklineCache::Key SparklineCache::makeKey(const SeriesView &series, const QModelIndex &index, const QStyleOptionViewItem &option,
+    qreal devicePixelRatio)
+{
+    Key key;
+    key.slot = series.slot;
+    key.generation = series.generation;
+    key.size = option.rect.size();
+    key.state = static_cast<int>(option.state & SPARKLINE_STATE_MASK);
+    key.palette = option.palette.cacheKey();
+    key.devicePixelRatio = devicePixelRatio;
+    key.row = index.row();
+    key.column = index.column();
+    return key;
+}
+
+/*!
+ Adjusts an \a option, already initialized for its index, so that it can be
+ used to render a sparkline on a worker thread: the cell is moved to the
+ origin, the widget is detached and the style tweaks are applied here.
+ */
+void SparklineCache::prepareOption(QStyleOptionViewItem *option)
+{
+    if (QApplication::style()->objectName().contains("vista"))
+    {
+        // QWindowsVistaStyle::drawControl does this internally. Unfortunately there
+        // doesn't appear to be a more general way to do this.
+        option->palette.setColor(QPalette::All, QPalette::HighlightedText, option->palette.color(QPalette::Active, QPalette::Text));
+    }
+
+    option->rect = QRect(QPoint(0, 0), option->rect.size());
+    option->widget = nullptr;
+}
+
+/*!
+ Looks up the sparkline for \a key. Returns true and sets \a pixmap if it is cached.
+ */
+bool SparklineCache::find(const Key &key, QPixmap *pixmap) const
+{
+    auto it = m_entries.constFind(key.slot);
+    if (it == m_entries.constEnd() || !(it->key == key))
+    {
+        return false;
+    }
+
+    *pixmap = it->pixmap;
+    return true;
+}
+
+/*!
+ Stores the sparkline \a pixmap rendered for \a key, replacing the previous one of the same slot.
+ */
+void SparklineCache::insert(const Key &key, const QPixmap &pixmap)
+{
+    Entry &entry = m_entries[key.slot];
+    entry.key = key;
+    entry.pixmap = pixmap;
+}
+
+/*!
+ Returns the sparkline for \a key, drawn by \a draw from the newest \a count
+ samples of \a series in a cell of \a widget.
+
+ If it is not cached but a previous rendering of the same slot has the
+ right size, that one is returned and the new one is rendered on the thread
+ pool, unless a job for the slot is already in flight. Otherwise the
+ sparkline is rendered in place, so a cell is never left empty.
+ */
+QPixmap SparklineCache::pixmap(const Key &key, const SeriesView &series, size_t count, const QWidget *widget,
+    const DrawFunction &draw)
+{
+    QPixmap pixmap;
+    if (find(key, &pixmap))
+    {
+        return pixmap;
+    }
+
+    // Renderings delivered later are shown by repainting their cell of the view.
+    m_widget = const_cast<QWidget *>(widget);
+
+    auto it = m_entries.constFind(key.slot);
+    if (it != m_entries.constEnd() && it->key.size == key.size && it->key.devicePixelRatio == key.devicePixelRatio)
+    {
+        // Keep showing the previous rendering until the new one is ready.
+        if (!m_pending.contains(key.slot))
+        {
+            render(key, series, count, draw);
+        }
+        return it->pixmap;
+    }
+
+    // A job in flight for this slot would be older than this rendering.
+    m_pending.remove(key.slot);
+
+    pixmap = QPixmap::fromImage(rasterize(key, series, draw));
+    insert(key, pixmap);
+    return pixmap;
+}
+
+/*!
+ Starts a job that renders the sparkline for \a key on the thread pool.
+ */
+void SparklineCache::render(const Key &key, const SeriesView &series, size_t count, const DrawFunction &draw)
+{
+    m_pending.insert(key.slot, key);
+    QThreadPool::globalInstance()->start(new RenderJob(key, series, count, draw, m_receiver));
+}
+
+/*!
+ Swaps in the \a image rendered for \a key, unless its slot was removed
+ or the cache cleared since the job was started.
+ */
+void SparklineCache::deliver(const SparklineCache::Key &key, const QImage &image)
+{
+    auto it = m_pending.find(key.slot);
+    if (it == m_pending.end() || !(it.value() == key))
+    {
+        return;
+    }
+    m_pending.erase(it);
+
+    insert(key, QPixmap::fromImage(image));
+    updateCell(key);
+}
+
+/*!
+ Repaints the cell that shows the sparkline of \a key. If the rows moved
+ since the key was made, so that the cell shows another history, or the
+ sparklines are not painted in a view, the whole widget is repainted.
+ */
+void SparklineCache::updateCell(const Key &key)
+{
+    if (!m_widget)
+    {
+        return;
+    }
+
+    QAbstractItemView *view = qobject_cast<QAbstractItemView *>(m_widget.data());
+    if (!view || !m_model || view->model() != m_model)
+    {
+        QAbstractScrollArea *area = qobject_cast<QAbstractScrollArea *>(m_widget.data());
+        (area ? area->viewport() : m_widget.data())->update();
+        return;
+    }
+
+    QModelIndex index = m_model->index(key.row, key.column);
+    const SeriesView *series = index.data(ChannelTableModel::SeriesRole).value<const SeriesView *>();
+    if (!series || series->slot != key.slot)
+    {
+        view->viewport()->update();
+        return;
+    }
+    view->viewport()->update(view->visualRect(index));
+}
+
+/*!
+ Drops the entries of channels removed from \a model, and all entries when it is reset.
+ Does nothing if the cache already follows \a model.
+ */
+void SparklineCache::setModel(const QAbstractItemModel *model)
+{
+    if (m_model == model)
+    {
+        return;
+    }
+
+    if (m_model)
+    {
+        disconnect(m_model, nullptr, this, nullptr);
+    }
+
+    m_model = model;
+    clear();
+
+    if (m_model)
+    {
+        connect(m_model, &QAbstractItemModel::rowsAboutToBeRemoved, this, &SparklineCache::removeRows);
+        connect(m_model, &QAbstractItemModel::modelReset, this, &SparklineCache::clear);
+        connect(m_model, &QObject::destroyed, this, [this]() {
+            m_model = nullptr;
+            clear();
+        });
+    }
+}
+
+void SparklineCache::remove(int slot)
+{
+    m_entries.remove(slot);
+    m_pending.remove(slot);
+}
+
+void SparklineCache::clear()
+{
+    m_entries.clear();
+    m_pending.clear();
+}
+
+void SparklineCache::removeRows(const QModelIndex &parent, int first, int last)
+{
+    for (int row = first; row <= last; row++)
+    {
+        // The renderings are keyed by the history the row shows.
+        for (int column = 0; column < m_model->columnCount(parent); column++)
+        {
+            const SeriesView *series = m_model->index(row, column, parent).data(ChannelTableModel::SeriesRole).value<const SeriesView *>();
+            if (series)
+            {
+                remove(series->slot);
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,132 @@
+/*!
+ * \file sparkline_cache.h
+ * \brief Interface of a cache of rendered sparklines for the item delegates.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#ifndef GNSS_SDR_MONITOR_SPARKLINE_CACHE_H_
+#define GNSS_SDR_MONITOR_SPARKLINE_CACHE_H_
+
+#include "channel_history_store.h"
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QPainter>
+#include <QPixmap>
+#include <QPointer>
+#include <QStyleOptionViewItem>
+#include <functional>
+#include <memory>
+
+/*!
+ Keeps the last sparkline rendered for each history, keyed by the slot of
+ its series, so that repaints caused by scrolling, hovering or selection only
+ blit a pixmap. An entry is reused while the data generation, the cell size,
+ the style state and the device pixel ratio are unchanged, and is dropped
+ when the row that shows the history leaves the model.
+
+ When the data of a channel changes, its new sparkline is rasterized into a
+ QImage on the global thread pool from a copy of the samples, so channels are
+ rendered in parallel and off the GUI thread. The previous pixmap is blitted
+ until the new one is swapped in, and the view is then asked to repaint the
+ cell that shows it.
+ */
+class SparklineCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Key
+    {
+        int slot;
+        quint64 generation;
+        QSize size;
+        int state;
+        qint64 palette;
+        qreal devicePixelRatio;
+        // Cell that showed the sparkline when the key was made. It locates the
+        // repaint of a delivered rendering and is not compared.
+        int row;
+        int column;
+
+        bool operator==(const Key &other) const;
+    };
+
+    // Draws a sparkline with its cell at the origin. It runs on a worker
+    // thread, so it must only use what it captured by value and the series.
+    typedef std::function<void(QPainter *, const SeriesView &)> DrawFunction;
+
+    explicit SparklineCache(QObject *parent = nullptr);
+    ~SparklineCache();
+
+    static Key makeKey(const SeriesView &series, const QModelIndex &index, const QStyleOptionViewItem &option,
+        qreal devicePixelRatio);
+    static void prepareOption(QStyleOptionViewItem *option);
+
+    bool find(const Key &key, QPixmap *pixmap) const;
+    void insert(const Key &key, const QPixmap &pixmap);
+    QPixmap pixmap(const Key &key, const SeriesView &series, size_t count, const QWidget *widget,
+        const DrawFunction &draw);
+
+    void setModel(const QAbstractItemModel *model);
+    void remove(int slot);
+    void clear();
+
+private slots:
+    void removeRows(const QModelIndex &parent, int first, int last);
+    void deliver(const SparklineCache::Key &key, const QImage &image);
+
+private:
+    struct Entry
+    {
+        Key key;
+        QPixmap pixmap;
+    };
+
+    // Shared with the render jobs, which outlive the cache if it is destroyed while they run.
+    struct Receiver
+    {
+        QMutex mutex;
+        SparklineCache *cache;
+    };
+
+    class RenderJob;
+
+    void render(const Key &key, const SeriesView &series, size_t count, const DrawFunction &draw);
+    void updateCell(const Key &key);
+
+    const QAbstractItemModel *m_model;
+    QPointer<QWidget> m_widget;  // Widget the sparklines are painted on, the view if they are in one.
+    QHash<int, Entry> m_entries;
+    QHash<int, Key> m_pending;  // Key of the job in flight for each slot.
+    std::shared_ptr<Receiver> m_receiver;
+};
+
+Q_DECLARE_METATYPE(SparklineCache::Key)
+
+#endif  // GNSS_SDR_MONITOR_SPARKLINE_CACHE_H_
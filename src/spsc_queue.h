@@ -0,0 +1,122 @@
+/*!
+ * \file spsc_queue.h
+ * \brief Interface and implementation of a bounded lock-free
+ * single-producer single-consumer queue.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#ifndef GNSS_SDR_MONITOR_SPSC_QUEUE_H_
+#define GNSS_SDR_MONITOR_SPSC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/*!
+ A bounded single-producer single-consumer queue.
+
+ The slots are constructed once and reused, so neither side allocates after
+ construction. The producer fills a slot in place with acquire() and makes it
+ visible with publish(); the consumer reads it in place with front() and hands
+ it back with pop(). Only one thread may produce and only one may consume.
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity) : m_slots(capacity + 1), m_head(0), m_tail(0)
+    {
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    /*!
+     Returns the next free slot, or nullptr if the queue is full. Producer only.
+     */
+    T *acquire()
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (next(tail) == m_head.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        return &m_slots[tail];
+    }
+
+    /*!
+     Makes the slot returned by the last acquire() visible to the consumer. Producer only.
+     */
+    void publish()
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        m_tail.store(next(tail), std::memory_order_release);
+    }
+
+    /*!
+     Returns the oldest published slot, or nullptr if the queue is empty. Consumer only.
+     */
+    T *front()
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        return &m_slots[head];
+    }
+
+    /*!
+     Releases the slot returned by the last front() back to the producer. Consumer only.
+     */
+    void pop()
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        m_head.store(next(head), std::memory_order_release);
+    }
+
+    size_t capacity() const
+    {
+        return m_slots.size() - 1;
+    }
+
+private:
+    size_t next(size_t index) const
+    {
+        return (index + 1 == m_slots.size()) ? 0 : index + 1;
+    }
+
+    std::vector<T> m_slots;
+
+    // Keep the indices on separate cache lines so that the producer and the
+    // consumer do not invalidate each other's line on every operation.
+    std::atomic<size_t> m_head;
+    char m_padding[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> m_tail;
+};
+
+#endif  // GNSS_SDR_MONITOR_SPSC_QUEUE_H_
@@ -0,0 +1,63 @@
+/*!
+ * \file startup_trace.cpp
+ * \brief Implementation of a trace of the time taken by each step of the
+ * startup.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "startup_trace.h"
+#include <QDebug>
+
+QElapsedTimer StartupTrace::s_timer;
+qint64 StartupTrace::s_last = 0;
+
+/*!
+ Starts the trace. It should be called first thing in main().
+ */
+void StartupTrace::start()
+{
+    s_timer.start();
+    s_last = 0;
+}
+
+/*!
+ Logs that \a step has just finished.
+ */
+void StartupTrace::mark(const QString &step)
+{
+    if (!s_timer.isValid())
+    {
+        start();
+    }
+
+    qint64 now = s_timer.nsecsElapsed();
+    qDebug().noquote() << QString("Startup: %1 ms (+%2 ms) %3")
+                              .arg(now / 1e6, 0, 'f', 1)
+                              .arg((now - s_last) / 1e6, 0, 'f', 1)
+                              .arg(step);
+    s_last = now;
+}
@@ -0,0 +1,52 @@
+/*!
+ * \file startup_trace.h
+ * \brief Interface of a trace of the time taken by each step of the startup.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#ifndef GNSS_SDR_MONITOR_STARTUP_TRACE_H_
+#define GNSS_SDR_MONITOR_STARTUP_TRACE_H_
+
+#include <QElapsedTimer>
+#include <QString>
+
+/*!
+ Logs each step of the startup with the time since the start of the process
+ and since the previous step, so that the slow ones stand out.
+ */
+class StartupTrace
+{
+public:
+    static void start();
+    static void mark(const QString &step);
+
+private:
+    static QElapsedTimer s_timer;
+    static qint64 s_last;
+};
+
+#endif  // GNSS_SDR_MONITOR_STARTUP_TRACE_H_
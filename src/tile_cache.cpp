@@ -0,0 +1,489 @@
+/*!
+ * \file tile_cache.cpp
+ * \brief Implementation of a two level cache of map tiles backed by an
+ * optional read-only tile package.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "tile_cache.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QVariant>
+#include <QtConcurrent>
+#include <algorithm>
+#include <climits>
+#include <iterator>
+#include <utility>
+
+// Default bounds of the caches.
+#define TILE_CACHE_MEMORY_LIMIT (32 * 1024 * 1024)
+#define TILE_CACHE_DISK_LIMIT (512 * 1024 * 1024)
+
+TileCache::TileCache(QObject *parent) : QObject(parent), m_namespace(0), m_diskScan(nullptr), m_diskLimit(TILE_CACHE_DISK_LIMIT), m_diskUsage(0), m_packageQuery(nullptr)
+{
+    m_memory.setMaxCost(TILE_CACHE_MEMORY_LIMIT);
+    m_diskThread.setMaxThreadCount(1);
+    m_statistics = Statistics();
+    setSource(QString());
+}
+
+TileCache::~TileCache()
+{
+    // The pending writes are completed.
+    m_diskThread.waitForDone();
+    closePackage();
+}
+
+/*!
+ Uses \a directory, which is created if needed, as the disk cache. The tiles
+ already in it are ranked by modification time and trimmed to the limit once
+ the worker has scanned them. Until then, every lookup that misses the memory
+ cache tries the disk.
+ */
+bool TileCache::openDiskCache(const QString &directory)
+{
+    m_diskOrder.clear();
+    m_diskEntries.clear();
+    m_diskUsage = 0;
+    m_diskDirectory.clear();
+    // A scan still running is dropped when it ends.
+    m_diskScan = nullptr;
+
+    if (!QDir().mkpath(directory))
+    {
+        qDebug() << "Cannot create the tile cache" << directory;
+        return false;
+    }
+    m_diskDirectory = directory;
+
+    auto *watcher = new QFutureWatcher<std::vector<DiskTile>>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher]() {
+        if (watcher == m_diskScan)
+        {
+            applyDiskScan();
+        }
+        watcher->deleteLater();
+    });
+    m_diskScan = watcher;
+    watcher->setFuture(QtConcurrent::run(&m_diskThread, &TileCache::scanDisk, directory));
+    return true;
+}
+
+/*!
+ Blocks until the tiles already in the disk cache are indexed, for the tools
+ that check the cache right after opening it.
+ */
+void TileCache::waitForDiskCache()
+{
+    if (m_diskScan)
+    {
+        m_diskScan->waitForFinished();
+        applyDiskScan();
+    }
+}
+
+/*!
+ Files the tiles inserted and looked up from now on under a hash of \a
+ source, the URL template of the upstream they come from.
+ */
+void TileCache::setSource(const QString &source)
+{
+    m_source = source;
+    QByteArray hash = QCryptographicHash::hash(source.toUtf8(), QCryptographicHash::Sha1);
+    m_namespace = hash.left(8).toHex().toULongLong(nullptr, 16);
+}
+
+QString TileCache::source() const
+{
+    return m_source;
+}
+
+/*!
+ Serves the tiles of \a path, a directory pyramid or an MBTiles file, when
+ they are not cached.
+ */
+bool TileCache::openPackage(const QString &path)
+{
+    closePackage();
+
+    QFileInfo info(path);
+    if (info.isDir())
+    {
+        m_packageDirectory = path;
+        return true;
+    }
+    if (!info.isFile())
+    {
+        qDebug() << "Tile package not found:" << path;
+        return false;
+    }
+
+    m_packageConnection = QString("tile_package_%1").arg(reinterpret_cast<quintptr>(this));
+    QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", m_packageConnection);
+    database.setDatabaseName(path);
+    database.setConnectOptions("QSQLITE_OPEN_READONLY");
+    if (!database.open())
+    {
+        qDebug() << "Cannot open the tile package" << path << database.lastError().text();
+        closePackage();
+        return false;
+    }
+
+    m_packageQuery = new QSqlQuery(database);
+    if (!m_packageQuery->prepare("SELECT tile_data FROM tiles WHERE zoom_level = ? AND tile_column = ? AND tile_row = ?"))
+    {
+        qDebug() << "Not an MBTiles package:" << path << m_packageQuery->lastError().text();
+        closePackage();
+        return false;
+    }
+    return true;
+}
+
+void TileCache::closePackage()
+{
+    m_packageDirectory.clear();
+    if (m_packageConnection.isEmpty())
+    {
+        return;
+    }
+
+    // The query must be gone before the connection is removed.
+    delete m_packageQuery;
+    m_packageQuery = nullptr;
+    QSqlDatabase::database(m_packageConnection, false).close();
+    QSqlDatabase::removeDatabase(m_packageConnection);
+    m_packageConnection.clear();
+}
+
+void TileCache::setMemoryLimit(size_t bytes)
+{
+    m_memory.setMaxCost(static_cast<int>(std::min<size_t>(bytes, INT_MAX)));
+}
+
+void TileCache::setDiskLimit(size_t bytes)
+{
+    m_diskLimit = bytes;
+    trimDisk();
+}
+
+/*!
+ Calls \a callback with the tile at \a zoom, \a x, \a y, or an empty array
+ if it is not available. Memory hits are answered right away, disk hits
+ when the worker has read them. Tiles found on disk or in the package are
+ kept in memory.
+ */
+void TileCache::find(int zoom, int x, int y, const std::function<void(const QByteArray &)> &callback)
+{
+    Key tileKey(m_namespace, key(zoom, x, y));
+    if (QByteArray *tile = m_memory.object(tileKey))
+    {
+        m_statistics.memoryHits++;
+        callback(*tile);
+        return;
+    }
+
+    if (m_diskDirectory.isEmpty() || (!m_diskScan && m_diskEntries.count(tileKey) == 0))
+    {
+        callback(findPackage(tileKey, zoom, x, y));
+        return;
+    }
+
+    auto *watcher = new QFutureWatcher<QByteArray>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, tileKey, zoom, x, y, callback]() {
+        QByteArray tile = watcher->result();
+        watcher->deleteLater();
+        if (tile.isEmpty())
+        {
+            // Removed behind our back, unless it was inserted since.
+            if (!m_memory.contains(tileKey))
+            {
+                forgetDisk(tileKey);
+            }
+            callback(findPackage(tileKey, zoom, x, y));
+            return;
+        }
+
+        m_statistics.diskHits++;
+        auto it = m_diskEntries.find(tileKey);
+        if (it != m_diskEntries.end())
+        {
+            m_diskOrder.splice(m_diskOrder.end(), m_diskOrder, it->second.position);
+        }
+        m_memory.insert(tileKey, new QByteArray(tile), tile.size());
+        callback(tile);
+    });
+    watcher->setFuture(QtConcurrent::run(&m_diskThread, &TileCache::readDisk, diskPath(tileKey)));
+}
+
+/*!
+ Returns true if the tile is cached, in memory or on disk. The package is
+ not checked.
+ */
+bool TileCache::contains(int zoom, int x, int y)
+{
+    Key tileKey(m_namespace, key(zoom, x, y));
+    return m_memory.contains(tileKey) || m_diskEntries.count(tileKey) > 0;
+}
+
+/*!
+ Stores \a tile in memory and on disk, evicting the least recently used
+ tiles beyond the limits. The file is written by the worker.
+ */
+void TileCache::insert(int zoom, int x, int y, const QByteArray &tile)
+{
+    if (tile.isEmpty())
+    {
+        return;
+    }
+
+    Key tileKey(m_namespace, key(zoom, x, y));
+    m_memory.insert(tileKey, new QByteArray(tile), tile.size());
+
+    if (m_diskDirectory.isEmpty() || static_cast<size_t>(tile.size()) > m_diskLimit)
+    {
+        return;
+    }
+
+    QtConcurrent::run(&m_diskThread, &TileCache::writeDisk, diskPath(tileKey), tile);
+
+    auto it = m_diskEntries.find(tileKey);
+    if (it != m_diskEntries.end())
+    {
+        m_diskUsage -= static_cast<size_t>(it->second.size);
+        m_diskOrder.erase(it->second.position);
+        m_diskEntries.erase(it);
+    }
+    m_diskOrder.push_back(tileKey);
+    m_diskEntries[tileKey] = {std::prev(m_diskOrder.end()), tile.size()};
+    m_diskUsage += static_cast<size_t>(tile.size());
+    trimDisk();
+}
+
+size_t TileCache::memoryUsage() const
+{
+    return static_cast<size_t>(m_memory.totalCost());
+}
+
+size_t TileCache::diskUsage() const
+{
+    return m_diskUsage;
+}
+
+TileCache::Statistics TileCache::statistics() const
+{
+    return m_statistics;
+}
+
+quint64 TileCache::key(int zoom, int x, int y)
+{
+    return (static_cast<quint64>(zoom) << 48) | (static_cast<quint64>(x) << 24) | static_cast<quint64>(y);
+}
+
+QString TileCache::diskPath(const Key &key) const
+{
+    int zoom = static_cast<int>(key.second >> 48);
+    int x = static_cast<int>((key.second >> 24) & 0xFFFFFF);
+    int y = static_cast<int>(key.second & 0xFFFFFF);
+    return QString("%1/%2/%3/%4/%5.tile").arg(m_diskDirectory).arg(key.first, 16, 16, QChar('0')).arg(zoom).arg(x).arg(y);
+}
+
+/*!
+ Indexes the tiles found by the scan of the disk cache. They are older than
+ the ones inserted or read since it was opened, which stay the most recently
+ used.
+ */
+void TileCache::applyDiskScan()
+{
+    std::vector<DiskTile> found = m_diskScan->result();
+    m_diskScan = nullptr;
+
+    std::sort(found.begin(), found.end(), [](const DiskTile &a, const DiskTile &b) { return a.time > b.time; });
+    for (const DiskTile &tile : found)
+    {
+        if (m_diskEntries.count(tile.key) > 0)
+        {
+            continue;
+        }
+        m_diskOrder.push_front(tile.key);
+        m_diskEntries[tile.key] = {m_diskOrder.begin(), tile.size};
+        m_diskUsage += static_cast<size_t>(tile.size);
+    }
+    trimDisk();
+
+    qDebug() << "Tile cache" << m_diskDirectory << "holds" << m_diskEntries.size() << "tiles," << m_diskUsage / 1024 << "KiB";
+}
+
+QByteArray TileCache::findPackage(const Key &key, int zoom, int x, int y)
+{
+    QByteArray tile = readPackage(zoom, x, y);
+    if (tile.isEmpty())
+    {
+        m_statistics.misses++;
+        return tile;
+    }
+    m_statistics.packageHits++;
+    m_memory.insert(key, new QByteArray(tile), tile.size());
+    return tile;
+}
+
+QByteArray TileCache::readPackage(int zoom, int x, int y)
+{
+    if (!m_packageDirectory.isEmpty())
+    {
+        QString base = QString("%1/%2/%3/%4").arg(m_packageDirectory).arg(zoom).arg(x).arg(y);
+        for (const char *suffix : {".png", ".jpg", ".jpeg"})
+        {
+            QFile file(base + suffix);
+            if (file.open(QIODevice::ReadOnly))
+            {
+                return file.readAll();
+            }
+        }
+        return QByteArray();
+    }
+
+    if (!m_packageQuery)
+    {
+        return QByteArray();
+    }
+
+    // MBTiles follow the TMS scheme, with rows counted from the south.
+    m_packageQuery->bindValue(0, zoom);
+    m_packageQuery->bindValue(1, x);
+    m_packageQuery->bindValue(2, (1 << zoom) - 1 - y);
+    QByteArray tile;
+    if (m_packageQuery->exec() && m_packageQuery->next())
+    {
+        tile = m_packageQuery->value(0).toByteArray();
+    }
+    m_packageQuery->finish();
+    return tile;
+}
+
+void TileCache::forgetDisk(const Key &key)
+{
+    auto it = m_diskEntries.find(key);
+    if (it != m_diskEntries.end())
+    {
+        m_diskUsage -= static_cast<size_t>(it->second.size);
+        m_diskOrder.erase(it->second.position);
+        m_diskEntries.erase(it);
+    }
+}
+
+/*!
+ Deletes the least recently used tiles of the disk cache beyond its limit.
+ */
+void TileCache::trimDisk()
+{
+    QStringList paths;
+    while (m_diskUsage > m_diskLimit && !m_diskOrder.empty())
+    {
+        Key oldest = m_diskOrder.front();
+        auto it = m_diskEntries.find(oldest);
+        paths.append(diskPath(oldest));
+        m_diskUsage -= static_cast<size_t>(it->second.size);
+        m_diskEntries.erase(it);
+        m_diskOrder.pop_front();
+    }
+    if (!paths.isEmpty())
+    {
+        QtConcurrent::run(&m_diskThread, &TileCache::removeDisk, paths);
+    }
+}
+
+/*!
+ Lists the tiles of the disk cache in \a directory, on the worker. Files
+ that are not laid out as a cached tile are left alone.
+ */
+std::vector<TileCache::DiskTile> TileCache::scanDisk(const QString &directory)
+{
+    std::vector<DiskTile> found;
+    QDir root(directory);
+    QDirIterator it(directory, QStringList() << "*.tile", QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext())
+    {
+        it.next();
+        QFileInfo info = it.fileInfo();
+        // The path is <directory>/n/z/x/y.tile.
+        QStringList parts = root.relativeFilePath(info.filePath()).split('/');
+        bool okNamespace = false;
+        bool okZoom = false;
+        bool okX = false;
+        bool okY = false;
+        quint64 space = parts.size() == 4 ? parts[0].toULongLong(&okNamespace, 16) : 0;
+        int zoom = parts.size() == 4 ? parts[1].toInt(&okZoom) : 0;
+        int x = parts.size() == 4 ? parts[2].toInt(&okX) : 0;
+        int y = parts.size() == 4 ? info.completeBaseName().toInt(&okY) : 0;
+        if (okNamespace && okZoom && okX && okY)
+        {
+            found.push_back({info.lastModified().toMSecsSinceEpoch(), Key(space, key(zoom, x, y)), info.size()});
+        }
+    }
+    return found;
+}
+
+/*!
+ Reads a tile of the disk cache, on the worker, and stamps its file so that
+ the order is restored by the next openDiskCache().
+ */
+QByteArray TileCache::readDisk(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadWrite))
+    {
+        return QByteArray();
+    }
+    QByteArray tile = file.readAll();
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    return tile;
+}
+
+void TileCache::writeDisk(const QString &path, const QByteArray &tile)
+{
+    QDir().mkpath(QFileInfo(path).path());
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(tile) != tile.size())
+    {
+        qDebug() << "Cannot write the tile" << path;
+    }
+}
+
+void TileCache::removeDisk(const QStringList &paths)
+{
+    for (const QString &path : paths)
+    {
+        QFile::remove(path);
+    }
+}
@@ -0,0 +1,162 @@
+/*!
+ * \file tile_cache.h
+ * \brief Interface of a two level cache of map tiles backed by an optional
+ * read-only tile package.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#ifndef GNSS_SDR_MONITOR_TILE_CACHE_H_
+#define GNSS_SDR_MONITOR_TILE_CACHE_H_
+
+#include <QByteArray>
+#include <QCache>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QPair>
+#include <QSqlQuery>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+/*!
+ Map tiles by zoom, column and row, looked up in a memory cache, then in a
+ disk cache, then in a tile package. The memory and disk caches are bounded
+ in bytes and evict the least recently used tiles. The disk cache is a
+ directory pyramid, n/z/x/y.tile, whose files are ranked by modification
+ time when it is opened, so that the recency survives restarts.
+
+ Cached tiles are filed under a namespace n, a hash of the source they come
+ from, so that the tiles of different upstreams never mix. Both caches are
+ shared by all the namespaces.
+
+ The disk is only touched by a worker thread, which runs the scan of the
+ cache, the reads, the writes and the deletions in order. The index of the
+ disk cache lives in the thread of the TileCache, so that lookups that miss
+ do not wait for the disk, and find() answers disk hits when the read ends.
+
+ A tile package is read only. It is either a directory pyramid of PNG or
+ JPEG files or an MBTiles file, an SQLite database whose rows count from the
+ south, and it lets the map work on machines without network access.
+ */
+class TileCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Statistics
+    {
+        size_t memoryHits;
+        size_t diskHits;
+        size_t packageHits;
+        size_t misses;
+    };
+
+    explicit TileCache(QObject *parent = nullptr);
+    ~TileCache();
+
+    bool openDiskCache(const QString &directory);
+    void waitForDiskCache();
+    void setSource(const QString &source);
+    QString source() const;
+    bool openPackage(const QString &path);
+    void closePackage();
+
+    void setMemoryLimit(size_t bytes);
+    void setDiskLimit(size_t bytes);
+
+    void find(int zoom, int x, int y, const std::function<void(const QByteArray &)> &callback);
+    bool contains(int zoom, int x, int y);
+    void insert(int zoom, int x, int y, const QByteArray &tile);
+
+    size_t memoryUsage() const;
+    size_t diskUsage() const;
+    Statistics statistics() const;
+
+    static quint64 key(int zoom, int x, int y);
+
+private:
+    // The namespace and the key of a tile.
+    typedef QPair<quint64, quint64> Key;
+
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const
+        {
+            return std::hash<quint64>()(key.first ^ (key.second * 0x9E3779B97F4A7C15ULL));
+        }
+    };
+
+    struct DiskEntry
+    {
+        std::list<Key>::iterator position;
+        qint64 size;
+    };
+
+    struct DiskTile
+    {
+        qint64 time;
+        Key key;
+        qint64 size;
+    };
+
+    QString diskPath(const Key &key) const;
+    void applyDiskScan();
+    QByteArray findPackage(const Key &key, int zoom, int x, int y);
+    QByteArray readPackage(int zoom, int x, int y);
+    void forgetDisk(const Key &key);
+    void trimDisk();
+
+    static std::vector<DiskTile> scanDisk(const QString &directory);
+    static QByteArray readDisk(const QString &path);
+    static void writeDisk(const QString &path, const QByteArray &tile);
+    static void removeDisk(const QStringList &paths);
+
+    QCache<Key, QByteArray> m_memory;
+
+    QString m_source;
+    quint64 m_namespace;
+
+    QThreadPool m_diskThread;  // A single thread, so that the disk operations keep their order.
+    QFutureWatcher<std::vector<DiskTile>> *m_diskScan;
+    QString m_diskDirectory;
+    size_t m_diskLimit;
+    size_t m_diskUsage;
+    std::list<Key> m_diskOrder;  // Least recently used first.
+    std::unordered_map<Key, DiskEntry, KeyHash> m_diskEntries;
+
+    QString m_packageDirectory;
+    QString m_packageConnection;
+    QSqlQuery *m_packageQuery;
+
+    Statistics m_statistics;
+};
+
+#endif  // GNSS_SDR_MONITOR_TILE_CACHE_H_
@@ -0,0 +1,300 @@
+/*!
+ * \file tile_server.cpp
+ * \brief Implementation of a local HTTP server that provides the map with
+ * tiles from a cache, a tile package or an upstream tile server.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "tile_server.h"
+#include <QDebug>
+#include <QHostAddress>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSettings>
+#include <QStandardPaths>
+#include <algorithm>
+
+// Highest zoom level served.
+#define TILE_SERVER_MAX_ZOOM 22
+
+// Imagery served when no other upstream is set, the one of the esri plugin.
+#define TILE_SERVER_DEFAULT_UPSTREAM "https://server.arcgisonline.com/ArcGIS/rest/services/World_Imagery/MapServer/tile/{z}/{y}/{x}"
+
+TileServer::TileServer(QObject *parent) : QObject(parent)
+{
+    m_server = new QTcpServer(this);
+    m_network = new QNetworkAccessManager(this);
+    connect(m_server, &QTcpServer::newConnection, this, &TileServer::acceptConnections);
+}
+
+/*!
+ Listens on \a port of the loopback interface, or on any free port if it is 0.
+ */
+bool TileServer::listen(quint16 port)
+{
+    if (!m_server->listen(QHostAddress::LocalHost, port))
+    {
+        qDebug() << "Tile server cannot listen:" << m_server->errorString();
+        return false;
+    }
+    return true;
+}
+
+/*!
+ Returns the base URL of the tiles, to be used as the custom host of the map.
+ */
+QString TileServer::url() const
+{
+    return QString("http://127.0.0.1:%1/").arg(m_server->serverPort());
+}
+
+/*!
+ Applies the tile package, the upstream and the cache limits set in the
+ preferences. The package is only reopened if it changed.
+ */
+void TileServer::loadSettings()
+{
+    QSettings settings;
+    settings.beginGroup("Preferences_Dialog");
+    QString package = settings.value("map_tile_package", QString()).toString();
+    QString upstream = settings.value("map_tile_upstream", TILE_SERVER_DEFAULT_UPSTREAM).toString();
+    // Offline, the tiles cached from the last upstream are served.
+    if (upstream.isEmpty())
+    {
+        m_cache.setSource(settings.value("map_tile_last_upstream", TILE_SERVER_DEFAULT_UPSTREAM).toString());
+    }
+    else
+    {
+        settings.setValue("map_tile_last_upstream", upstream);
+    }
+    int memoryMiB = settings.value("map_memory_cache", 32).toInt();
+    int diskMiB = settings.value("map_disk_cache", 512).toInt();
+    settings.endGroup();
+
+    m_cache.setMemoryLimit(static_cast<size_t>(std::max(memoryMiB, 0)) * 1024 * 1024);
+    m_cache.setDiskLimit(static_cast<size_t>(std::max(diskMiB, 0)) * 1024 * 1024);
+
+    if (m_cacheDirectory.isEmpty())
+    {
+        m_cacheDirectory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/tiles";
+        m_cache.openDiskCache(m_cacheDirectory);
+    }
+
+    if (package != m_package)
+    {
+        m_package = package;
+        if (package.isEmpty())
+        {
+            m_cache.closePackage();
+        }
+        else
+        {
+            m_cache.openPackage(package);
+        }
+    }
+
+    setUpstream(upstream);
+}
+
+/*!
+ Sets the URL of the tiles fetched on a miss, with {z}, {x} and {y} in place
+ of the zoom, column and row, and serves the tiles cached from it. An empty
+ template keeps the map offline with the tiles of the previous one.
+ */
+void TileServer::setUpstream(const QString &urlTemplate)
+{
+    m_upstream = urlTemplate;
+    if (!urlTemplate.isEmpty())
+    {
+        m_cache.setSource(urlTemplate);
+    }
+}
+
+QString TileServer::upstream() const
+{
+    return m_upstream;
+}
+
+TileCache *TileServer::cache()
+{
+    return &m_cache;
+}
+
+QUrl TileServer::tileUrl(const QString &urlTemplate, int zoom, int x, int y)
+{
+    QString url = urlTemplate;
+    url.replace("{z}", QString::number(zoom));
+    url.replace("{x}", QString::number(x));
+    url.replace("{y}", QString::number(y));
+    return QUrl(url);
+}
+
+void TileServer::acceptConnections()
+{
+    while (QTcpSocket *socket = m_server->nextPendingConnection())
+    {
+        connect(socket, &QTcpSocket::readyRead, this, &TileServer::readRequests);
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+/*!
+ Reads the heads of the requests received on a connection, which is kept
+ alive between them. Only the request line matters.
+ */
+void TileServer::readRequests()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    if (!socket)
+    {
+        return;
+    }
+
+    while (socket->canReadLine())
+    {
+        QByteArray line = socket->readLine().trimmed();
+        QByteArray requestLine = socket->property("requestLine").toByteArray();
+        if (!line.isEmpty())
+        {
+            if (requestLine.isEmpty())
+            {
+                socket->setProperty("requestLine", line);
+            }
+            continue;
+        }
+
+        // The empty line ends the head.
+        socket->setProperty("requestLine", QByteArray());
+        if (!requestLine.isEmpty())
+        {
+            handleRequest(socket, requestLine);
+        }
+    }
+}
+
+/*!
+ Answers a request line of the form GET /z/x/y.png HTTP/1.1 from the cache,
+ once it is found, or queues it until the tile is fetched from the upstream.
+ */
+void TileServer::handleRequest(QTcpSocket *socket, const QByteArray &requestLine)
+{
+    QList<QByteArray> request = requestLine.split(' ');
+    QList<QByteArray> path = request.size() >= 2 ? request[1].mid(1).split('/') : QList<QByteArray>();
+    bool okZoom = false;
+    bool okX = false;
+    bool okY = false;
+    int zoom = path.size() == 3 ? path[0].toInt(&okZoom) : -1;
+    int x = path.size() == 3 ? path[1].toInt(&okX) : -1;
+    int y = path.size() == 3 ? path[2].split('.').first().toInt(&okY) : -1;
+    if (request[0] != "GET" || !okZoom || !okX || !okY || zoom < 0 || zoom > TILE_SERVER_MAX_ZOOM ||
+        x < 0 || y < 0 || x >= (1 << zoom) || y >= (1 << zoom))
+    {
+        respond(socket, QByteArray());
+        return;
+    }
+
+    QPointer<QTcpSocket> client(socket);
+    m_cache.find(zoom, x, y, [this, client, zoom, x, y](const QByteArray &tile) {
+        if (!client)
+        {
+            return;
+        }
+        if (!tile.isEmpty() || m_upstream.isEmpty())
+        {
+            respond(client, tile);
+            return;
+        }
+
+        quint64 key = TileCache::key(zoom, x, y);
+        bool fetching = m_waiting.contains(key);
+        m_waiting[key].append(client);
+        if (!fetching)
+        {
+            fetch(zoom, x, y);
+        }
+    });
+}
+
+/*!
+ Fetches a tile from the upstream, caches it and answers the requests that
+ wait for it.
+ */
+void TileServer::fetch(int zoom, int x, int y)
+{
+    QNetworkRequest request(tileUrl(m_upstream, zoom, x, y));
+    request.setHeader(QNetworkRequest::UserAgentHeader, "gnss-sdr-monitor");
+    request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+    QNetworkReply *reply = m_network->get(request);
+
+    QString source = m_upstream;
+    connect(reply, &QNetworkReply::finished, this, [this, reply, source, zoom, x, y]() {
+        QByteArray tile;
+        if (reply->error() == QNetworkReply::NoError &&
+            reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 200)
+        {
+            tile = reply->readAll();
+            // Not filed under another upstream set meanwhile.
+            if (m_cache.source() == source)
+            {
+                m_cache.insert(zoom, x, y, tile);
+            }
+        }
+        else
+        {
+            qDebug() << "Tile" << zoom << x << y << "not fetched:" << reply->errorString();
+        }
+        reply->deleteLater();
+
+        for (const QPointer<QTcpSocket> &socket : m_waiting.take(TileCache::key(zoom, x, y)))
+        {
+            if (socket)
+            {
+                respond(socket, tile);
+            }
+        }
+    });
+}
+
+/*!
+ Writes the response with \a tile, or a 404 if it is empty. The type is
+ sniffed, since packages and upstreams serve either PNG or JPEG tiles.
+ */
+void TileServer::respond(QTcpSocket *socket, const QByteArray &tile)
+{
+    QByteArray head;
+    if (tile.isEmpty())
+    {
+        head = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+    }
+    else
+    {
+        QByteArray type = tile.startsWith("\x89PNG") ? "image/png" : "image/jpeg";
+        head = "HTTP/1.1 200 OK\r\nContent-Type: " + type + "\r\nContent-Length: " + QByteArray::number(tile.size()) + "\r\n\r\n";
+    }
+    socket->write(head);
+    socket->write(tile);
+}
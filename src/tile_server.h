@@ -0,0 +1,90 @@
+/*!
+ * \file tile_server.h
+ * \brief Interface of a local HTTP server that provides the map with tiles
+ * from a cache, a tile package or an upstream tile server.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#ifndef GNSS_SDR_MONITOR_TILE_SERVER_H_
+#define GNSS_SDR_MONITOR_TILE_SERVER_H_
+
+#include "tile_cache.h"
+#include <QHash>
+#include <QList>
+#include <QNetworkAccessManager>
+#include <QObject>
+#include <QPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUrl>
+
+/*!
+ Serves map tiles on the loopback interface as GET /z/x/y.png, the layout
+ the osm plugin of QtLocation requests from a custom host. Tiles are looked
+ up in a TileCache. The ones it misses are fetched from an upstream URL
+ template, if set, and cached, so that panning over an area already seen
+ does not reach the network. Without an upstream the map works offline with
+ the tiles of the cache and the package. Concurrent requests for the same
+ tile share a single fetch.
+ */
+class TileServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TileServer(QObject *parent = nullptr);
+
+    bool listen(quint16 port = 0);
+    QString url() const;
+
+    void loadSettings();
+    void setUpstream(const QString &urlTemplate);
+    QString upstream() const;
+
+    TileCache *cache();
+
+    static QUrl tileUrl(const QString &urlTemplate, int zoom, int x, int y);
+
+private slots:
+    void acceptConnections();
+    void readRequests();
+
+private:
+    void handleRequest(QTcpSocket *socket, const QByteArray &requestLine);
+    void fetch(int zoom, int x, int y);
+    void respond(QTcpSocket *socket, const QByteArray &tile);
+
+    QTcpServer *m_server;
+    QNetworkAccessManager *m_network;
+    TileCache m_cache;
+    QString m_cacheDirectory;
+    QString m_package;
+    QString m_upstream;
+    QHash<quint64, QList<QPointer<QTcpSocket>>> m_waiting;
+};
+
+#endif  // GNSS_SDR_MONITOR_TILE_SERVER_H_
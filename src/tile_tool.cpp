@@ -0,0 +1,290 @@
+/*!
+ * \file tile_tool.cpp
+ * \brief Command line tool that seeds the map tile cache for an area and
+ * measures the latency of the tiles served to the map.
+ *
+ * -----------------------------------------------------------------------
+ *
+ * Copyright (C) 2010-2019  (see AUTHORS file for a list of contributors)
+ *
+ * GNSS-SDR is a software defined Global Navigation
+ *      Satellite Systems receiver
+ *
+ * This file is part of GNSS-SDR.
+ *
+ * GNSS-SDR is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * GNSS-SDR is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GNSS-SDR. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * -----------------------------------------------------------------------
+ */
+
+
+#include "tile_server.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QNetworkReply>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Upstream fetches in flight while seeding.
+#define TILE_TOOL_CONCURRENCY 8
+
+struct TileRange
+{
+    int zoom;
+    int minX;
+    int maxX;
+    int minY;
+    int maxY;
+};
+
+/*!
+ Returns the ranges of tiles that cover the box \a box, given as
+ minimum latitude, minimum longitude, maximum latitude, maximum longitude,
+ for each zoom level in \a zooms, given as minimum-maximum.
+ */
+static std::vector<TileRange> tileRanges(const QString &box, const QString &zooms)
+{
+    std::vector<TileRange> ranges;
+    QStringList corners = box.split(',');
+    QStringList levels = zooms.split('-');
+    if (corners.size() != 4 || levels.isEmpty() || levels.size() > 2)
+    {
+        return ranges;
+    }
+
+    double minLatitude = std::max(corners[0].toDouble(), -85.0511);
+    double minLongitude = corners[1].toDouble();
+    double maxLatitude = std::min(corners[2].toDouble(), 85.0511);
+    double maxLongitude = corners[3].toDouble();
+    int minZoom = levels.first().toInt();
+    int maxZoom = std::min(levels.last().toInt(), 22);
+
+    for (int zoom = minZoom; zoom <= maxZoom; zoom++)
+    {
+        double n = std::pow(2.0, zoom);
+        auto column = [n](double longitude) {
+            return std::min(static_cast<int>(n) - 1, std::max(0, static_cast<int>(std::floor((longitude + 180) / 360 * n))));
+        };
+        auto row = [n](double latitude) {
+            double phi = latitude * M_PI / 180;
+            double y = (1 - std::log(std::tan(phi) + 1 / std::cos(phi)) / M_PI) / 2 * n;
+            return std::min(static_cast<int>(n) - 1, std::max(0, static_cast<int>(std::floor(y))));
+        };
+        // Rows grow southwards.
+        ranges.push_back({zoom, column(minLongitude), column(maxLongitude), row(maxLatitude), row(minLatitude)});
+    }
+    return ranges;
+}
+
+static size_t tileCount(const std::vector<TileRange> &ranges)
+{
+    size_t count = 0;
+    for (const TileRange &range : ranges)
+    {
+        count += static_cast<size_t>(range.maxX - range.minX + 1) * (range.maxY - range.minY + 1);
+    }
+    return count;
+}
+
+/*!
+ Fetches the tiles of \a ranges that are not cached yet from the upstream of
+ \a server into its cache.
+ */
+static int seed(TileServer *server, const std::vector<TileRange> &ranges)
+{
+    if (server->upstream().isEmpty())
+    {
+        std::cerr << "No upstream to seed from." << std::endl;
+        return 1;
+    }
+
+    QNetworkAccessManager network;
+    QEventLoop loop;
+    size_t total = tileCount(ranges);
+    size_t done = 0;
+    size_t fetched = 0;
+    size_t failed = 0;
+    int inFlight = 0;
+
+    for (const TileRange &range : ranges)
+    {
+        for (int x = range.minX; x <= range.maxX; x++)
+        {
+            for (int y = range.minY; y <= range.maxY; y++)
+            {
+                int zoom = range.zoom;
+                if (server->cache()->contains(zoom, x, y))
+                {
+                    done++;
+                    continue;
+                }
+
+                while (inFlight >= TILE_TOOL_CONCURRENCY)
+                {
+                    loop.exec();
+                }
+
+                QNetworkRequest request(TileServer::tileUrl(server->upstream(), zoom, x, y));
+                request.setHeader(QNetworkRequest::UserAgentHeader, "gnss-sdr-monitor");
+                request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+                QNetworkReply *reply = network.get(request);
+                inFlight++;
+                QObject::connect(reply, &QNetworkReply::finished, [&, reply, zoom, x, y]() {
+                    if (reply->error() == QNetworkReply::NoError)
+                    {
+                        server->cache()->insert(zoom, x, y, reply->readAll());
+                        fetched++;
+                    }
+                    else
+                    {
+                        failed++;
+                    }
+                    reply->deleteLater();
+                    inFlight--;
+                    done++;
+                    if (done % 100 == 0)
+                    {
+                        std::cout << done << " of " << total << " tiles" << std::endl;
+                    }
+                    loop.quit();
+                });
+            }
+        }
+    }
+    while (inFlight > 0)
+    {
+        loop.exec();
+    }
+
+    std::cout << "Seeded " << fetched << " tiles, " << failed << " failed, " << total - fetched - failed
+              << " already cached. Cache: " << server->cache()->diskUsage() / 1024 << " KiB on disk." << std::endl;
+    return failed > 0 ? 1 : 0;
+}
+
+/*!
+ Requests the tiles of \a ranges from \a server over HTTP, as the map does,
+ and prints the latency of each pass: the first one reads the disk cache or
+ the package, the second one the memory cache.
+ */
+static int benchmark(TileServer *server, const std::vector<TileRange> &ranges)
+{
+    QNetworkAccessManager network;
+    for (const char *pass : {"cold", "warm"})
+    {
+        std::vector<double> latencies;
+        size_t missing = 0;
+        for (const TileRange &range : ranges)
+        {
+            for (int x = range.minX; x <= range.maxX; x++)
+            {
+                for (int y = range.minY; y <= range.maxY; y++)
+                {
+                    QElapsedTimer timer;
+                    timer.start();
+                    QNetworkReply *reply = network.get(QNetworkRequest(QUrl(server->url() + QString("%1/%2/%3.png").arg(range.zoom).arg(x).arg(y))));
+                    QEventLoop loop;
+                    QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+                    loop.exec();
+                    latencies.push_back(timer.nsecsElapsed() / 1e6);
+                    if (reply->error() != QNetworkReply::NoError)
+                    {
+                        missing++;
+                    }
+                    reply->deleteLater();
+                }
+            }
+        }
+
+        if (latencies.empty())
+        {
+            std::cerr << "No tiles in the area." << std::endl;
+            return 1;
+        }
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << pass << ": " << latencies.size() << " tiles (" << missing << " missing), median "
+                  << latencies[latencies.size() / 2] << " ms, p95 " << latencies[latencies.size() * 95 / 100]
+                  << " ms, max " << latencies.back() << " ms" << std::endl;
+    }
+
+    TileCache::Statistics statistics = server->cache()->statistics();
+    std::cout << "Hits: " << statistics.memoryHits << " memory, " << statistics.diskHits << " disk, "
+              << statistics.packageHits << " package, " << statistics.misses << " misses" << std::endl;
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    // Same names as the monitor, so that the settings and the cache are shared.
+    app.setOrganizationName("gnss-sdr");
+    app.setOrganizationDomain("gnss-sdr.org");
+    app.setApplicationName("gnss-sdr-monitor");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Seeds the map tile cache of gnss-sdr-monitor for an area, or measures "
+                                     "the latency of its tiles. Drop the page cache of the OS before a "
+                                     "benchmark for a truly cold first pass.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "seed or benchmark");
+    parser.addOption({"box", "Area as min_lat,min_lon,max_lat,max_lon.", "box"});
+    parser.addOption({"zoom", "Zoom levels as min-max.", "levels", "0-17"});
+    parser.addOption({"upstream", "Tile URL template with {z}, {x} and {y}. Defaults to the preferences.", "url"});
+    parser.addOption({"package", "Directory pyramid or MBTiles file. Defaults to the preferences.", "path"});
+    parser.addOption({"disk-cache", "Disk cache limit in MiB. Defaults to the preferences.", "mib"});
+    parser.process(app);
+
+    QStringList arguments = parser.positionalArguments();
+    std::vector<TileRange> ranges = tileRanges(parser.value("box"), parser.value("zoom"));
+    if (arguments.size() != 1 || ranges.empty())
+    {
+        parser.showHelp(1);
+    }
+
+    TileServer server;
+    server.loadSettings();
+    if (parser.isSet("upstream"))
+    {
+        server.setUpstream(parser.value("upstream"));
+    }
+    if (parser.isSet("package"))
+    {
+        server.cache()->openPackage(parser.value("package"));
+    }
+    if (parser.isSet("disk-cache"))
+    {
+        server.cache()->setDiskLimit(static_cast<size_t>(parser.value("disk-cache").toInt()) * 1024 * 1024);
+    }
+    server.cache()->waitForDiskCache();
+
+    std::cout << tileCount(ranges) << " tiles in the area." << std::endl;
+    if (arguments.first() == "seed")
+    {
+        return seed(&server, ranges);
+    }
+    if (arguments.first() == "benchmark")
+    {
+        // Only what is already cached or packaged is measured.
+        server.setUpstream(QString());
+        if (!server.listen())
+        {
+            return 1;
+        }
+        return benchmark(&server, ranges);
+    }
+    parser.showHelp(1);
+}